@@ -1,9 +1,67 @@
 #include "src/program_handle.h"
+#include "src/benchmark.h"
+#include "src/file_io.h"
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
 
 using namespace Tolo;
 
-int main()
+int main(int argc, char** argv)
 {
+	// 'Tolo benchmark [scratch path]' runs the benchmark suite and prints its results as json
+	if (argc > 1 && std::strcmp(argv[1], "benchmark") == 0)
+	{
+		std::vector<BenchmarkResult> results;
+		RunBenchmarkSuite("Script/benchmark", argc > 2 ? argv[2] : "benchmark_generated.tolo", results);
+
+		std::string json;
+		WriteBenchmarkJson(results, json);
+		std::fputs(json.c_str(), stdout);
+
+		return 0;
+	}
+
+	// 'Tolo count [output path]' runs every benchmark kernel once and writes its exact counts,
+	// the same on every host
+	if (argc > 1 && std::strcmp(argv[1], "count") == 0)
+	{
+		std::map<std::string, uint64_t> values;
+		CountBenchmarkKernels("Script/benchmark", values);
+
+		std::string text;
+		WriteCounterValues(values, text);
+
+		if (argc > 2)
+			WriteTextFile(argv[2], text, false);
+		else
+			std::fputs(text.c_str(), stdout);
+
+		return 0;
+	}
+
+	// 'Tolo compare <baseline> <current> [threshold %]' compares two count files, fails if a
+	// count grew by more than the threshold
+	if (argc > 3 && std::strcmp(argv[1], "compare") == 0)
+	{
+		std::string baselineText;
+		std::string currentText;
+		ReadTextFile(argv[2], baselineText);
+		ReadTextFile(argv[3], currentText);
+
+		std::map<std::string, uint64_t> baseline;
+		std::map<std::string, uint64_t> current;
+		ReadCounterValues(baselineText, baseline);
+		ReadCounterValues(currentText, current);
+
+		std::string report;
+		bool isPassing = CompareCounterValues(baseline, current, argc > 4 ? std::atof(argv[4]) : 1.0, report);
+		std::fputs(report.c_str(), stdout);
+		std::puts(isPassing ? "counts ok" : "counts regressed");
+
+		return isPassing ? 0 : 1;
+	}
+
 	ProgramHandle program(
 		"Script/method_test.tolo", 
 		16 * 1024, 
@@ -0,0 +1,78 @@
+#include "arena.h"
+#include "common.h"
+#include <cstdlib>
+
+namespace Tolo
+{
+	Arena::Arena(size_t _blockSize) :
+		blockSize(_blockSize),
+		p_nextByte(nullptr),
+		p_blockEnd(nullptr),
+		p_lastDestructor(nullptr),
+		allocationCount(0),
+		usedBytes(0),
+		reservedBytes(0)
+	{}
+
+	Arena::~Arena()
+	{
+		Release();
+	}
+
+	void* Arena::Allocate(size_t size, size_t alignment)
+	{
+		size_t padding = (alignment - reinterpret_cast<size_t>(p_nextByte) % alignment) % alignment;
+
+		if (p_nextByte == nullptr || padding + size > static_cast<size_t>(p_blockEnd - p_nextByte))
+		{
+			// oversized objects get a block of their own
+			size_t newBlockSize = size + alignment > blockSize ? size + alignment : blockSize;
+			char* p_block = static_cast<char*>(std::malloc(newBlockSize));
+			Affirm(p_block != nullptr, "failed to allocate arena block of %i bytes", static_cast<Int>(newBlockSize));
+
+			blocks.push_back(p_block);
+			reservedBytes += newBlockSize;
+			p_nextByte = p_block;
+			p_blockEnd = p_block + newBlockSize;
+			padding = (alignment - reinterpret_cast<size_t>(p_nextByte) % alignment) % alignment;
+		}
+
+		void* p_memory = p_nextByte + padding;
+		p_nextByte += padding + size;
+		usedBytes += padding + size;
+
+		return p_memory;
+	}
+
+	void Arena::Release()
+	{
+		for (Destructor* p_destructor = p_lastDestructor; p_destructor != nullptr; p_destructor = p_destructor->p_next)
+			p_destructor->p_destroy(p_destructor->p_object);
+
+		for (char* p_block : blocks)
+			std::free(p_block);
+
+		blocks.clear();
+		p_nextByte = nullptr;
+		p_blockEnd = nullptr;
+		p_lastDestructor = nullptr;
+		allocationCount = 0;
+		usedBytes = 0;
+		reservedBytes = 0;
+	}
+
+	size_t Arena::GetAllocationCount() const
+	{
+		return allocationCount;
+	}
+
+	size_t Arena::GetUsedBytes() const
+	{
+		return usedBytes;
+	}
+
+	size_t Arena::GetReservedBytes() const
+	{
+		return reservedBytes;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+#include <vector>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+
+namespace Tolo
+{
+	// bump allocator for objects that all die together, destructors run in reverse order on Release
+	class Arena
+	{
+	private:
+		struct Destructor
+		{
+			void(*p_destroy)(void*);
+			void* p_object;
+			Destructor* p_next;
+		};
+
+		std::vector<char*> blocks;
+		size_t blockSize;
+		char* p_nextByte;
+		char* p_blockEnd;
+		Destructor* p_lastDestructor;
+		size_t allocationCount;
+		size_t usedBytes;
+		size_t reservedBytes;
+
+		void* Allocate(size_t size, size_t alignment);
+
+	public:
+		Arena(size_t _blockSize = 64 * 1024);
+
+		Arena(const Arena&) = delete;
+
+		Arena& operator=(const Arena&) = delete;
+
+		~Arena();
+
+		template<typename T, typename... ARGS>
+		T* New(ARGS&&... args)
+		{
+			T* p_object = new (Allocate(sizeof(T), alignof(T))) T(std::forward<ARGS>(args)...);
+
+			if constexpr (!std::is_trivially_destructible_v<T>)
+			{
+				Destructor* p_destructor = static_cast<Destructor*>(Allocate(sizeof(Destructor), alignof(Destructor)));
+				p_destructor->p_destroy = [](void* p) { static_cast<T*>(p)->~T(); };
+				p_destructor->p_object = p_object;
+				p_destructor->p_next = p_lastDestructor;
+				p_lastDestructor = p_destructor;
+			}
+
+			allocationCount++;
+
+			return p_object;
+		}
+
+		// destroys all objects and frees all blocks
+		void Release();
+
+		// number of objects created with New since the last Release
+		size_t GetAllocationCount() const;
+
+		size_t GetUsedBytes() const;
+
+		// bytes held in blocks, the peak memory of the arena as blocks are only freed by Release
+		size_t GetReservedBytes() const;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,313 @@
+#include "benchmark.h"
+#include "tokenizer.h"
+#include "lexer.h"
+#include "program_handle.h"
+#include "file_io.h"
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+
+namespace Tolo
+{
+	BenchmarkResult::BenchmarkResult() :
+		kind(Kind::Kernel),
+		nsPerOp(0.0),
+		megabytesPerSecond(0.0),
+		checksum(0)
+	{}
+
+	void GenerateBenchmarkScript(size_t codeSize, std::string& outCode)
+	{
+		outCode.clear();
+		outCode.reserve(codeSize + 1024);
+		outCode += "struct vec2\n{\n\tfloat x;\n\tfloat y;\n};\n\n";
+
+		for (int i = 0; outCode.size() < codeSize; i++)
+		{
+			std::string index = std::to_string(i);
+
+			outCode += "/* generated function " + index + " */\n";
+			outCode += "int function_" + index + "(int count, ptr p_str)\n{\n";
+			outCode += "\tint sum = 0;\n\tint i = 0;\n";
+			outCode += "\tvec2 v = vec2(1.5, 2.25);\n";
+			outCode += "\twhile (i < count && sum <= 1000000)\n\t{\n";
+			outCode += "\t\tsum = sum + (i * " + index + ") / 3 - (i >> 1) + (i << 2);\n";
+			outCode += "\t\tif (sum == 7 || sum != 8 && !(i >= 2)) { sum = sum ^ 5 | ~i & 3; }\n";
+			outCode += "\t\tchar c = '\\n';\n";
+			outCode += "\t\tv.x = v.x * 0.5; // halve\n";
+			outCode += "\t\ti = i + 1;\n\t}\n";
+			outCode += "\tassert(sum > 0, \"sum of function " + index + " was\\t\\'negative\\'\\n\");\n";
+			outCode += "\treturn Color::Red + sum;\n}\n\n";
+		}
+	}
+
+	void GenerateCompileBenchmarkScript(size_t codeSize, std::string& outCode)
+	{
+		outCode.clear();
+		outCode.reserve(codeSize + 1024);
+		outCode += "struct vec2\n{\n\tfloat x;\n\tfloat y;\n};\n\n";
+
+		int functionCount = 0;
+
+		for (; outCode.size() < codeSize; functionCount++)
+		{
+			std::string index = std::to_string(functionCount);
+
+			outCode += "int function_" + index + "(int count)\n{\n";
+			outCode += "\tint sum = 0;\n\tint i = 0;\n";
+			outCode += "\tvec2 v = vec2(1.5, 2.25);\n";
+			outCode += "\twhile (i < count && sum <= 1000000)\n\t{\n";
+			outCode += "\t\tsum = sum + (i * " + index + ") / 3 - (i >> 1) + (i << 2);\n";
+			outCode += "\t\tif (sum == 7 || sum != 8 && !(i >= 2)) { int t = ~i; sum = sum ^ 5 | t & 3; }\n";
+			outCode += "\t\tv.x = v.x * 0.5;\n";
+			outCode += "\t\ti = i + 1;\n\t}\n";
+
+			// calls keep the parser resolving signatures
+			if (functionCount > 0)
+				outCode += "\tint r = function_" + std::to_string(functionCount - 1) + "(count - 1);\n\tsum = sum + r;\n";
+
+			outCode += "\treturn sum;\n}\n\n";
+		}
+
+		outCode += "int main()\n{\n\treturn function_" + std::to_string(functionCount - 1) + "(0);\n}\n";
+	}
+
+	double BenchmarkTokenizer(size_t codeSize, int repetitions)
+	{
+		Affirm(repetitions > 0, "benchmark repetitions must be greater than 0");
+
+		std::string code;
+		GenerateBenchmarkScript(codeSize, code);
+
+		SymbolTable symbols;
+		std::vector<Token> tokens;
+		auto start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < repetitions; i++)
+		{
+			tokens.clear();
+			Tokenize(code, symbols, tokens);
+		}
+
+		std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+		return static_cast<double>(code.size()) * repetitions / (1024.0 * 1024.0) / seconds.count();
+	}
+
+	double BenchmarkLexer(size_t codeSize, int repetitions)
+	{
+		Affirm(repetitions > 0, "benchmark repetitions must be greater than 0");
+
+		std::string code;
+		GenerateCompileBenchmarkScript(codeSize, code);
+
+		SymbolTable symbols;
+		auto start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < repetitions; i++)
+		{
+			Arena arena;
+			std::vector<LexNode*> lexNodes;
+			TokenStream tokenStream(code, symbols);
+
+			Lexer lexer(arena);
+			lexer.Lex(tokenStream, lexNodes);
+		}
+
+		std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+		return static_cast<double>(code.size()) * repetitions / (1024.0 * 1024.0) / seconds.count();
+	}
+
+	double BenchmarkCompiler(const std::string& scratchPath, size_t codeSize, int repetitions, CompileStats& outStats)
+	{
+		Affirm(repetitions > 0, "benchmark repetitions must be greater than 0");
+
+		std::string code;
+		GenerateCompileBenchmarkScript(codeSize, code);
+
+		Affirm(
+			WriteTextFile(scratchPath, code, false),
+			"failed to write benchmark script '%s'",
+			scratchPath.c_str()
+		);
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < repetitions; i++)
+		{
+			ProgramHandle program(scratchPath, static_cast<Int>(code.size() * 4 + 1024 * 1024), 1024, "int", "main", {});
+			program.Compile();
+			outStats = program.GetCompileStats();
+		}
+
+		std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+		return static_cast<double>(code.size()) * repetitions / (1024.0 * 1024.0) / seconds.count();
+	}
+
+	BenchmarkResult BenchmarkKernel(const std::string& name, const std::string& codePath, Int operationCount, int repetitions)
+	{
+		Affirm(repetitions > 0, "benchmark repetitions must be greater than 0");
+		Affirm(operationCount > 0, "benchmark operation count must be greater than 0");
+
+		ProgramHandle program(codePath, 1024 * 1024, 4 * 1024, "int", "main", { "int" });
+		program.Compile();
+
+		BenchmarkResult result;
+		result.name = name;
+		double bestSeconds = 0.0;
+
+		for (int i = 0; i < repetitions; i++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			Int checksum = program.Execute<Int>(operationCount);
+			std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+			Affirm(
+				i == 0 || checksum == result.checksum,
+				"benchmark kernel '%s' returned %i and %i for the same input",
+				name.c_str(), result.checksum, checksum
+			);
+
+			result.checksum = checksum;
+			bestSeconds = i == 0 ? seconds.count() : std::min(bestSeconds, seconds.count());
+		}
+
+		program.StartCounting();
+		program.Execute<Int>(operationCount);
+		program.StopCounting();
+		result.counters = program.GetExecutionCounters();
+
+		result.nsPerOp = bestSeconds * 1e9 / operationCount;
+
+		return result;
+	}
+
+	struct KernelInfo
+	{
+		const char* name;
+		Int operationCount;
+	};
+
+	static const KernelInfo kernels[]
+	{
+		{ "int_loop", 2000000 },
+		{ "float_math", 1000000 },
+		{ "fib", 1000000 },
+		{ "struct_access", 1000000 },
+		{ "virtual_dispatch", 1000000 },
+		{ "malloc_free", 500000 },
+		{ "string_natives", 200000 }
+	};
+
+	void CountBenchmarkKernels(const std::string& scriptDirectory, std::map<std::string, uint64_t>& outValues)
+	{
+		for (const KernelInfo& kernel : kernels)
+		{
+			ProgramHandle program(scriptDirectory + "/" + kernel.name + ".tolo", 1024 * 1024, 4 * 1024, "int", "main", { "int" });
+			program.Compile();
+
+			program.StartCounting();
+			program.Execute<Int>(kernel.operationCount);
+			program.StopCounting();
+
+			AddCounterValues(kernel.name, program.GetExecutionCounters(), outValues);
+		}
+	}
+
+	void RunBenchmarkSuite(const std::string& scriptDirectory, const std::string& scratchPath, std::vector<BenchmarkResult>& outResults)
+	{
+		const int repetitions = 3;
+		const size_t compileCodeSize = 4 * 1024 * 1024;
+
+		for (const KernelInfo& kernel : kernels)
+		{
+			std::string codePath = scriptDirectory + "/" + kernel.name + ".tolo";
+			outResults.push_back(BenchmarkKernel(kernel.name, codePath, kernel.operationCount, repetitions));
+		}
+
+		BenchmarkResult result;
+		result.kind = BenchmarkResult::Kind::Compile;
+		result.name = "compile_tokenizer";
+		result.megabytesPerSecond = BenchmarkTokenizer(compileCodeSize, repetitions);
+		outResults.push_back(result);
+
+		result.name = "compile_lexer";
+		result.megabytesPerSecond = BenchmarkLexer(compileCodeSize, repetitions);
+		outResults.push_back(result);
+
+		CompileStats stats;
+		result.name = "compile_full";
+		result.megabytesPerSecond = BenchmarkCompiler(scratchPath, compileCodeSize, repetitions, stats);
+		outResults.push_back(result);
+
+		// throughput of each phase of the last compile, a phase too short for the clock has none
+		const std::pair<const char*, double> phases[]
+		{
+			{ "compile_preprocess", stats.preprocessSeconds },
+			{ "compile_lex", stats.lexSeconds },
+			{ "compile_declarations", stats.declarationsSeconds },
+			{ "compile_functions", stats.functionsSeconds },
+			{ "compile_code", stats.codeSeconds }
+		};
+
+		for (const auto& phase : phases)
+		{
+			if (phase.second <= 0.0)
+				continue;
+
+			result.name = phase.first;
+			result.megabytesPerSecond = static_cast<double>(stats.sourceBytes) / (1024.0 * 1024.0) / phase.second;
+			outResults.push_back(result);
+		}
+	}
+
+	void WriteBenchmarkJson(const std::vector<BenchmarkResult>& results, std::string& outJson)
+	{
+		outJson = "[\n";
+
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const BenchmarkResult& result = results[i];
+			char buffer[256];
+
+			outJson += "\t{\"name\":\"" + result.name + "\"";
+
+			if (result.kind == BenchmarkResult::Kind::Compile)
+			{
+				std::snprintf(buffer, sizeof(buffer), ",\"mbPerSecond\":%.3f", result.megabytesPerSecond);
+				outJson += buffer;
+			}
+			else
+			{
+				std::snprintf(
+					buffer, sizeof(buffer), ",\"nsPerOp\":%.3f,\"checksum\":%i",
+					result.nsPerOp, result.checksum
+				);
+				outJson += buffer;
+			}
+
+			const ExecutionCounters& counters = result.counters;
+
+			if (counters.instructionCount > 0)
+			{
+				std::snprintf(
+					buffer, sizeof(buffer),
+					",\"instructions\":%llu,\"calls\":%llu,\"nativeCalls\":%llu,\"bytesLoaded\":%llu,\"bytesWritten\":%llu,\"stackHighWater\":%i",
+					static_cast<unsigned long long>(counters.instructionCount),
+					static_cast<unsigned long long>(counters.callCount),
+					static_cast<unsigned long long>(counters.nativeCallCount),
+					static_cast<unsigned long long>(counters.bytesLoaded),
+					static_cast<unsigned long long>(counters.bytesWritten),
+					counters.stackHighWater
+				);
+				outJson += buffer;
+			}
+
+			outJson += i + 1 < results.size() ? "},\n" : "}\n";
+		}
+
+		outJson += "]\n";
+	}
+}
\ No newline at end of file
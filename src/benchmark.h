@@ -0,0 +1,58 @@
+#pragma once
+#include "common.h"
+#include "profiler.h"
+#include "compile_stats.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <map>
+
+namespace Tolo
+{
+	struct BenchmarkResult
+	{
+		// picks the fields a result is written with
+		enum class Kind
+		{
+			Kernel,
+			Compile
+		};
+
+		Kind kind;
+		std::string name;
+		double nsPerOp; // kernels only
+		double megabytesPerSecond; // compile benchmarks only
+		ExecutionCounters counters; // of one kernel run
+		Int checksum; // returned by the kernel, changes when its behaviour does
+
+		BenchmarkResult();
+	};
+
+	// generates a script of at least codeSize bytes using every kind of token
+	void GenerateBenchmarkScript(size_t codeSize, std::string& outCode);
+
+	// generates a program of at least codeSize bytes that compiles without natives
+	void GenerateCompileBenchmarkScript(size_t codeSize, std::string& outCode);
+
+	// tokenizes a generated script of codeSize bytes repetitions times, returns the throughput in MB/s
+	double BenchmarkTokenizer(size_t codeSize, int repetitions);
+
+	// tokenizes and lexes a generated program, returns the throughput in MB/s
+	double BenchmarkLexer(size_t codeSize, int repetitions);
+
+	// compiles a generated program written to scratchPath, returns the throughput in MB/s and the
+	// stats of the last compile
+	double BenchmarkCompiler(const std::string& scratchPath, size_t codeSize, int repetitions, CompileStats& outStats);
+
+	// runs 'int main(int n)' of the script with n operations, keeps the fastest of the repetitions
+	BenchmarkResult BenchmarkKernel(const std::string& name, const std::string& codePath, Int operationCount, int repetitions);
+
+	// runs every kernel in scriptDirectory once while counting, adds 'kernel.counter' values
+	void CountBenchmarkKernels(const std::string& scriptDirectory, std::map<std::string, uint64_t>& outValues);
+
+	// runs every kernel in scriptDirectory and the compile benchmarks
+	void RunBenchmarkSuite(const std::string& scriptDirectory, const std::string& scratchPath, std::vector<BenchmarkResult>& outResults);
+
+	// one object per result with the fields of its kind, counters are left out when not taken
+	void WriteBenchmarkJson(const std::vector<BenchmarkResult>& results, std::string& outJson);
+}
\ No newline at end of file
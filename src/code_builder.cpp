@@ -1,20 +1,45 @@
 #include "code_builder.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
 
 namespace Tolo
 {
 	CodeBuilder::CodeBuilder(Ptr _p_stack, Int _stackSize, Int _constStringCapacity) :
 		p_stack(_p_stack),
+		hasOwnCode(false),
 		stackSize(_stackSize),
 		constStringCapacity(_constStringCapacity),
 		p_nextConstStringIp(_p_stack),
 		codeLength(_constStringCapacity),
-		currentBranchDepth(0),
-		currentWhileDepth(0)
+		currentLine(0)
 	{}
 
+	CodeBuilder::CodeBuilder() :
+		p_stack(nullptr),
+		hasOwnCode(true),
+		stackSize(0),
+		constStringCapacity(0),
+		p_nextConstStringIp(nullptr),
+		codeLength(0),
+		currentLine(0)
+	{}
+
+	void CodeBuilder::Reserve(Int size)
+	{
+		if (codeLength + size <= stackSize)
+			return;
+
+		Affirm(hasOwnCode, "stack overflowed when building code");
+
+		ownCode.resize(std::max(ownCode.size() * 2, static_cast<size_t>(codeLength + size)));
+		p_stack = ownCode.data();
+		stackSize = static_cast<Int>(ownCode.size());
+	}
+
 	void CodeBuilder::Op(OpCode val)
 	{
-		Affirm(codeLength + sizeof(Char) <= stackSize, "stack overflowed when building code");
+		Reserve(sizeof(Char));
 
 		*(p_stack + codeLength) = static_cast<Char>(val);
 		codeLength += sizeof(Char);
@@ -22,7 +47,7 @@ namespace Tolo
 
 	void CodeBuilder::ConstChar(Char val)
 	{
-		Affirm(codeLength + sizeof(Char) <= stackSize, "stack overflowed when building code");
+		Reserve(sizeof(Char));
 
 		*(p_stack + codeLength) = val;
 		codeLength += sizeof(Char);
@@ -30,7 +55,7 @@ namespace Tolo
 
 	void CodeBuilder::ConstInt(Int val)
 	{
-		Affirm(codeLength + sizeof(Int) <= stackSize, "stack overflowed when building code");
+		Reserve(sizeof(Int));
 
 		*reinterpret_cast<Int*>(p_stack + codeLength) = val;
 		codeLength += sizeof(Int);
@@ -38,7 +63,7 @@ namespace Tolo
 
 	void CodeBuilder::ConstFloat(Float val)
 	{
-		Affirm(codeLength + sizeof(Float) <= stackSize, "stack overflowed when building code");
+		Reserve(sizeof(Float));
 
 		*reinterpret_cast<Float*>(p_stack + codeLength) = val;
 		codeLength += sizeof(Float);
@@ -46,7 +71,16 @@ namespace Tolo
 
 	void CodeBuilder::ConstStringPtr(const std::string& val)
 	{
-		Affirm(codeLength + sizeof(Ptr) <= stackSize, "stack overflowed when building code");
+		Reserve(sizeof(Ptr));
+
+		// the const string area is only known once the code is appended to the stack
+		if (hasOwnCode)
+		{
+			*reinterpret_cast<Ptr*>(p_stack + codeLength) = nullptr;
+			constStringFixups.push_back({ codeLength, val });
+			codeLength += sizeof(Ptr);
+			return;
+		}
 
 		if(constStringToIp.count(val) == 0)
 		{
@@ -63,51 +97,187 @@ namespace Tolo
 		}
 
 		*reinterpret_cast<Ptr*>(p_stack + codeLength) = constStringToIp[val];
+		relocations.stackPtrOffsets.push_back(codeLength);
 		codeLength += sizeof(Ptr);
 	}
 
 	void CodeBuilder::ConstPtr(Ptr p_val)
 	{
-		Affirm(codeLength + sizeof(Ptr) <= stackSize, "stack overflowed when building code");
+		Reserve(sizeof(Ptr));
 
 		*reinterpret_cast<Ptr*>(p_stack + codeLength) = p_val;
+
+		if (p_val >= p_stack && p_val < p_stack + stackSize)
+			relocations.stackPtrOffsets.push_back(codeLength);
+
 		codeLength += sizeof(Ptr);
 	}
 
-	void CodeBuilder::ConstPtrToLabel(const std::string& labelName)
+	void CodeBuilder::ConstNativeFunctionPtr(const std::string& functionHash, Ptr p_function)
+	{
+		Reserve(sizeof(Ptr));
+
+		*reinterpret_cast<Ptr*>(p_stack + codeLength) = p_function;
+		relocations.offsetToNativeFunctionHash[codeLength] = functionHash;
+		codeLength += sizeof(Ptr);
+	}
+
+	Int FindCodeLine(const std::vector<CodeLine>& codeLines, Int offset)
+	{
+		auto it = std::upper_bound(
+			codeLines.begin(), codeLines.end(), offset,
+			[](Int val, const CodeLine& codeLine) { return val < codeLine.offset; }
+		);
+
+		return it != codeLines.begin() ? std::prev(it)->line : 0;
+	}
+
+	static void AddCodeLine(std::vector<CodeLine>& codeLines, Int offset, Int line)
 	{
-		Affirm(codeLength + sizeof(Ptr) <= stackSize, "stack overflowed when building code");
+		// a line without code in between is replaced
+		if (!codeLines.empty() && codeLines.back().offset == offset)
+			codeLines.pop_back();
+
+		if (codeLines.empty() || codeLines.back().line != line)
+			codeLines.push_back({ offset, line });
+	}
+
+	void CodeBuilder::SetLine(Int line)
+	{
+		currentLine = line;
+		AddCodeLine(codeLines, codeLength, line);
+	}
+
+	LabelId CodeBuilder::CreateLabel()
+	{
+		labelOffsets.push_back(-1);
+		return static_cast<LabelId>(labelOffsets.size() - 1);
+	}
+
+	LabelId CodeBuilder::GetNamedLabel(const std::string& labelName)
+	{
+		auto it = labelNameToLabelId.find(labelName);
+
+		if (it != labelNameToLabelId.end())
+			return it->second;
+
+		LabelId labelId = CreateLabel();
+		labelNameToLabelId.emplace(labelName, labelId);
+
+		return labelId;
+	}
 
-		if (labelNameToLabelIp.count(labelName) != 0)
-			*reinterpret_cast<Ptr*>(p_stack + codeLength) = labelNameToLabelIp[labelName];
-		else
-			labelNameToStackOffsets[labelName].push_back(codeLength);
+	void CodeBuilder::ConstPtrToLabel(LabelId labelId)
+	{
+		Reserve(sizeof(Ptr));
 
+		*reinterpret_cast<Ptr*>(p_stack + codeLength) = nullptr;
+		labelFixups.push_back({ labelId, codeLength });
+		relocations.stackPtrOffsets.push_back(codeLength);
 		codeLength += sizeof(Ptr);
 	}
 
+	void CodeBuilder::ConstPtrToLabel(const std::string& labelName)
+	{
+		ConstPtrToLabel(GetNamedLabel(labelName));
+	}
+
+	void CodeBuilder::DefineLabel(LabelId labelId)
+	{
+		Affirm(labelOffsets[labelId] == -1, "label %i is defined twice when building code", labelId);
+
+		labelOffsets[labelId] = codeLength;
+	}
+
 	void CodeBuilder::DefineLabel(const std::string& labelName)
 	{
-		labelNameToLabelIp[labelName] = p_stack + codeLength;
+		LabelId labelId = GetNamedLabel(labelName);
 
-		if (labelNameToStackOffsets.count(labelName) == 0)
-			return;
+		Affirm(labelOffsets[labelId] == -1, "label '%s' is defined twice when building code", labelName.c_str());
 
-		const std::vector<Int>& stackOffsets = labelNameToStackOffsets[labelName];
+		labelOffsets[labelId] = codeLength;
+	}
 
-		for (Int offset : stackOffsets)
-			*reinterpret_cast<Ptr*>(p_stack + offset) = p_stack + codeLength;
+	void CodeBuilder::ResolveLabels()
+	{
+		for (const LabelFixup& fixup : labelFixups)
+		{
+			Int labelOffset = labelOffsets[fixup.labelId];
 
-		labelNameToStackOffsets.erase(labelName);
+			Affirm(labelOffset != -1, "unresolved labels after building code");
+
+			*reinterpret_cast<Ptr*>(p_stack + fixup.stackOffset) = p_stack + labelOffset;
+		}
+
+		labelFixups.clear();
 	}
 
-	void CodeBuilder::RemoveLabel(const std::string& labelName)
+	Ptr CodeBuilder::GetLabelIp(const std::string& labelName) const
 	{
-		labelNameToLabelIp.erase(labelName);
+		auto it = labelNameToLabelId.find(labelName);
+
+		Affirm(
+			it != labelNameToLabelId.end() && labelOffsets[it->second] != -1,
+			"label '%s' is not defined",
+			labelName.c_str()
+		);
+
+		return p_stack + labelOffsets[it->second];
 	}
 
-	bool CodeBuilder::HasUnresolvedLabels()
+	void CodeBuilder::Append(const CodeBuilder& code)
 	{
-		return labelNameToStackOffsets.size() > 0;
+		Reserve(code.codeLength);
+
+		Int baseOffset = codeLength;
+		std::memcpy(p_stack + baseOffset, code.p_stack, static_cast<size_t>(code.codeLength));
+		codeLength += code.codeLength;
+
+		// named labels are shared, all other labels get new ids
+		std::vector<LabelId> labelIds(code.labelOffsets.size(), -1);
+
+		for (const auto& e : code.labelNameToLabelId)
+			labelIds[e.second] = GetNamedLabel(e.first);
+
+		for (size_t i = 0; i < labelIds.size(); i++)
+		{
+			if (labelIds[i] == -1)
+				labelIds[i] = CreateLabel();
+
+			if (code.labelOffsets[i] == -1)
+				continue;
+
+			Affirm(labelOffsets[labelIds[i]] == -1, "label %i is defined twice when building code", labelIds[i]);
+
+			labelOffsets[labelIds[i]] = baseOffset + code.labelOffsets[i];
+		}
+
+		for (const LabelFixup& fixup : code.labelFixups)
+			labelFixups.push_back({ labelIds[fixup.labelId], baseOffset + fixup.stackOffset });
+
+		for (Int offset : code.relocations.stackPtrOffsets)
+			relocations.stackPtrOffsets.push_back(baseOffset + offset);
+
+		for (const auto& e : code.relocations.offsetToNativeFunctionHash)
+			relocations.offsetToNativeFunctionHash[baseOffset + e.first] = e.second;
+
+		// the appended code starts with no line until its own lines begin
+		AddCodeLine(codeLines, baseOffset, 0);
+
+		for (const CodeLine& codeLine : code.codeLines)
+			AddCodeLine(codeLines, baseOffset + codeLine.offset, codeLine.line);
+
+		AddCodeLine(codeLines, codeLength, currentLine);
+
+		// store the const strings and point the appended code at them
+		Int endOffset = codeLength;
+
+		for (const ConstStringFixup& fixup : code.constStringFixups)
+		{
+			codeLength = baseOffset + fixup.stackOffset;
+			ConstStringPtr(fixup.value);
+		}
+
+		codeLength = endOffset;
 	}
 }
\ No newline at end of file
@@ -1,26 +1,84 @@
 #pragma once
 #include "common.h"
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <vector>
 
 namespace Tolo
 {
+	// locations of pointers in the built code that depend on where the code and the native
+	// functions live in memory
+	struct CodeRelocations
+	{
+		std::vector<Int> stackPtrOffsets;
+		std::map<Int, std::string> offsetToNativeFunctionHash;
+	};
+
+	typedef Int LabelId;
+
+	// a pointer in the code to fill in with the ip of a label
+	struct LabelFixup
+	{
+		LabelId labelId;
+		Int stackOffset;
+	};
+
+	// labels of the enclosing while loop, for break and continue
+	struct WhileLabels
+	{
+		LabelId conditionLabel;
+		LabelId endLabel;
+	};
+
+	// a const string pointer in code built into its own buffer, stored when the code is appended
+	struct ConstStringFixup
+	{
+		Int stackOffset;
+		std::string value;
+	};
+
+	// line of a code builder for bytes that are data and not instructions, like v-tables
+	constexpr Int DATA_CODE_LINE = -1;
+
+	// the code from offset on was built from this line of the preprocessed code, 0 if it was
+	// built from no line
+	struct CodeLine
+	{
+		Int offset;
+		Int line;
+	};
+
+	// the line of the code at offset, 0 if it was built from no line
+	Int FindCodeLine(const std::vector<CodeLine>& codeLines, Int offset);
+
 	struct CodeBuilder
 	{
 		Ptr p_stack;
+		std::vector<Char> ownCode; // grows with the code when not building onto the stack
+		bool hasOwnCode;
 		std::map<std::string, Ptr> constStringToIp;
 		Int stackSize;
 		Int constStringCapacity;
 		Ptr p_nextConstStringIp;
 		Int codeLength;
-		std::map<std::string, Ptr> labelNameToLabelIp;
-		std::map<std::string, std::vector<Int>> labelNameToStackOffsets;
-		Int currentBranchDepth;
-		Int currentWhileDepth;
+		std::vector<Int> labelOffsets; // -1 while a label is undefined
+		std::vector<LabelFixup> labelFixups;
+		std::vector<ConstStringFixup> constStringFixups;
+		std::unordered_map<std::string, LabelId> labelNameToLabelId; // functions and other global labels
+		std::vector<WhileLabels> whileStack;
+		std::vector<LabelId> chainEndStack; // end of the current if chain
+		CodeRelocations relocations;
+		std::vector<CodeLine> codeLines; // sorted by offset
+		Int currentLine;
 
 		CodeBuilder(Ptr _p_stack, Int _stackSize, Int _constStringCapacity);
 
+		// builds code into its own buffer, so it can be built on any thread and appended later
+		CodeBuilder();
+
+		void Reserve(Int size);
+
 		void Op(OpCode val);
 
 		void ConstChar(Char val);
@@ -33,12 +91,31 @@ namespace Tolo
 
 		void ConstPtr(Ptr p_val);
 
+		void ConstNativeFunctionPtr(const std::string& functionHash, Ptr p_function);
+
+		// the code built from now on belongs to this line
+		void SetLine(Int line);
+
+		LabelId CreateLabel();
+
+		// returns the label with this name, creating it on first use
+		LabelId GetNamedLabel(const std::string& labelName);
+
+		void ConstPtrToLabel(LabelId labelId);
+
 		void ConstPtrToLabel(const std::string& labelName);
 
+		void DefineLabel(LabelId labelId);
+
 		void DefineLabel(const std::string& labelName);
 
-		void RemoveLabel(const std::string& labelName);
+		// writes the ips of all labels into the code, fails if a label was never defined
+		void ResolveLabels();
+
+		Ptr GetLabelIp(const std::string& labelName) const;
 
-		bool HasUnresolvedLabels();
+		// copies code built by another builder to the end of this code, its labels, const strings,
+		// relocations and lines are moved along, named labels are shared by name
+		void Append(const CodeBuilder& code);
 	};
 }
\ No newline at end of file
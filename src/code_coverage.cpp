@@ -0,0 +1,292 @@
+#include "code_coverage.h"
+#include <algorithm>
+#include <map>
+#include <cstdio>
+
+namespace Tolo
+{
+	CodeCoverage::CodeCoverage() :
+		p_stack(nullptr)
+	{}
+
+	void CodeCoverage::Reset(Ptr _p_stack, Int codeEnd)
+	{
+		p_stack = _p_stack;
+		offsetCounts.assign(static_cast<size_t>(codeEnd), 0);
+		takenCounts.assign(static_cast<size_t>(codeEnd), 0);
+	}
+
+
+	CoverageContext::CoverageContext() :
+		p_stack(nullptr),
+		codeStart(0),
+		codeEnd(0),
+		p_codeLines(nullptr),
+		p_sourceMap(nullptr)
+	{}
+
+	FunctionCoverage::FunctionCoverage() :
+		fileIndex(0),
+		line(0),
+		callCount(0)
+	{}
+
+	LineCoverage::LineCoverage() :
+		fileIndex(0),
+		line(0),
+		count(0)
+	{}
+
+	BranchCoverage::BranchCoverage() :
+		fileIndex(0),
+		line(0),
+		codeOffset(0),
+		count(0),
+		takenCount(0)
+	{}
+
+
+	void BuildCoverageReport(const CoverageContext& context, const CodeCoverage& coverage, CoverageReport& outReport)
+	{
+		const std::vector<CodeLine>& codeLines = *context.p_codeLines;
+		const SourceMap& sourceMap = *context.p_sourceMap;
+
+		outReport.filePaths = sourceMap.filePaths;
+		outReport.functions.clear();
+		outReport.lines.clear();
+		outReport.branches.clear();
+
+		std::map<std::pair<Int, Int>, uint64_t> locationToCount;
+		auto lineIt = codeLines.begin();
+		Int line = 0;
+
+		for (Int offset = context.codeStart; offset < context.codeEnd;)
+		{
+			for (; lineIt != codeLines.end() && lineIt->offset <= offset; lineIt++)
+				line = lineIt->line;
+
+			if (line == DATA_CODE_LINE)
+			{
+				offset += sizeof(Ptr);
+				continue;
+			}
+
+			OpCode opCode = static_cast<OpCode>(context.p_stack[offset]);
+
+			if (opCode >= OpCode::INVALID)
+				break;
+
+			uint64_t count = coverage.offsetCounts[static_cast<size_t>(offset)];
+			SourceLocation location;
+
+			if (sourceMap.TryGetLocationOfLine(line, location))
+			{
+				uint64_t& lineCount = locationToCount[{ location.fileIndex, location.line }];
+				lineCount = std::max(lineCount, count);
+
+				if (opCode == OpCode::Write_IP_If)
+				{
+					BranchCoverage& branch = outReport.branches.emplace_back();
+					branch.fileIndex = location.fileIndex;
+					branch.line = location.line;
+					branch.codeOffset = offset;
+					branch.count = count;
+					branch.takenCount = coverage.takenCounts[static_cast<size_t>(offset)];
+				}
+			}
+
+			offset += 1 + GetImmediateSize(opCode);
+		}
+
+		for (const auto& e : locationToCount)
+		{
+			LineCoverage& lineCoverage = outReport.lines.emplace_back();
+			lineCoverage.fileIndex = e.first.first;
+			lineCoverage.line = e.first.second;
+			lineCoverage.count = e.second;
+		}
+
+		for (const auto& e : context.functions)
+		{
+			Int offset = static_cast<Int>(e.first - context.p_stack);
+			SourceLocation location;
+
+			if (!sourceMap.TryGetLocationOfLine(FindCodeLine(codeLines, offset), location))
+				continue;
+
+			FunctionCoverage& function = outReport.functions.emplace_back();
+			function.functionHash = e.second;
+			function.fileIndex = location.fileIndex;
+			function.line = location.line;
+			function.callCount = coverage.offsetCounts[static_cast<size_t>(offset)];
+		}
+
+		std::stable_sort(outReport.functions.begin(), outReport.functions.end(), [](const FunctionCoverage& lhs, const FunctionCoverage& rhs)
+		{
+			return std::make_pair(lhs.fileIndex, lhs.line) < std::make_pair(rhs.fileIndex, rhs.line);
+		});
+
+		// jumps of a line are already in code order
+		std::stable_sort(outReport.branches.begin(), outReport.branches.end(), [](const BranchCoverage& lhs, const BranchCoverage& rhs)
+		{
+			return std::make_pair(lhs.fileIndex, lhs.line) < std::make_pair(rhs.fileIndex, rhs.line);
+		});
+	}
+
+	template<typename... ARGS>
+	static void AppendFormat(std::string& outText, const char* format, ARGS... args)
+	{
+		char buffer[512];
+		std::snprintf(buffer, sizeof(buffer), format, args...);
+		outText += buffer;
+	}
+
+	static unsigned long long ToULL(uint64_t value)
+	{
+		return static_cast<unsigned long long>(value);
+	}
+
+	void WriteCoverageLcov(const CoverageReport& report, std::string& outText)
+	{
+		outText.clear();
+
+		for (Int fileIndex = 0; fileIndex < static_cast<Int>(report.filePaths.size()); fileIndex++)
+		{
+			outText += "TN:\nSF:" + report.filePaths[static_cast<size_t>(fileIndex)] + "\n";
+
+			size_t functionCount = 0;
+			size_t functionHitCount = 0;
+
+			for (const FunctionCoverage& function : report.functions)
+			{
+				if (function.fileIndex == fileIndex)
+					AppendFormat(outText, "FN:%i,%s\n", function.line, function.functionHash.c_str());
+			}
+
+			for (const FunctionCoverage& function : report.functions)
+			{
+				if (function.fileIndex != fileIndex)
+					continue;
+
+				AppendFormat(outText, "FNDA:%llu,%s\n", ToULL(function.callCount), function.functionHash.c_str());
+				functionCount++;
+				functionHitCount += function.callCount != 0 ? 1 : 0;
+			}
+
+			AppendFormat(outText, "FNF:%zu\nFNH:%zu\n", functionCount, functionHitCount);
+
+			size_t branchCount = 0;
+			size_t branchHitCount = 0;
+			Int lastLine = 0;
+			Int blockIndex = 0;
+
+			for (const BranchCoverage& branch : report.branches)
+			{
+				if (branch.fileIndex != fileIndex)
+					continue;
+
+				// each jump of a line is its own block
+				blockIndex = branch.line == lastLine ? blockIndex + 1 : 0;
+				lastLine = branch.line;
+
+				if (branch.count == 0)
+				{
+					AppendFormat(outText, "BRDA:%i,%i,0,-\nBRDA:%i,%i,1,-\n", branch.line, blockIndex, branch.line, blockIndex);
+				}
+				else
+				{
+					uint64_t fallThroughCount = branch.count - branch.takenCount;
+					AppendFormat(outText, "BRDA:%i,%i,0,%llu\n", branch.line, blockIndex, ToULL(branch.takenCount));
+					AppendFormat(outText, "BRDA:%i,%i,1,%llu\n", branch.line, blockIndex, ToULL(fallThroughCount));
+					branchHitCount += (branch.takenCount != 0 ? 1 : 0) + (fallThroughCount != 0 ? 1 : 0);
+				}
+
+				branchCount += 2;
+			}
+
+			AppendFormat(outText, "BRF:%zu\nBRH:%zu\n", branchCount, branchHitCount);
+
+			size_t lineCount = 0;
+			size_t lineHitCount = 0;
+
+			for (const LineCoverage& line : report.lines)
+			{
+				if (line.fileIndex != fileIndex)
+					continue;
+
+				AppendFormat(outText, "DA:%i,%llu\n", line.line, ToULL(line.count));
+				lineCount++;
+				lineHitCount += line.count != 0 ? 1 : 0;
+			}
+
+			AppendFormat(outText, "LF:%zu\nLH:%zu\nend_of_record\n", lineCount, lineHitCount);
+		}
+	}
+
+	void WriteCoverageText(const CoverageReport& report, size_t maxRows, std::string& outText)
+	{
+		outText.clear();
+
+		auto getPath = [&](Int fileIndex) -> const char*
+		{
+			return report.filePaths[static_cast<size_t>(fileIndex)].c_str();
+		};
+
+		size_t hitLineCount = 0;
+
+		for (const LineCoverage& line : report.lines)
+			hitLineCount += line.count != 0 ? 1 : 0;
+
+		AppendFormat(outText, "lines executed: %zu of %zu\n", hitLineCount, report.lines.size());
+
+		std::vector<const LineCoverage*> hotLines;
+
+		for (const LineCoverage& line : report.lines)
+			hotLines.push_back(&line);
+
+		std::stable_sort(hotLines.begin(), hotLines.end(), [](const LineCoverage* p_lhs, const LineCoverage* p_rhs)
+		{
+			return p_lhs->count > p_rhs->count;
+		});
+
+		AppendFormat(outText, "\n%14s  %s\n", "count", "line");
+
+		for (size_t i = 0; i < hotLines.size() && i < maxRows && hotLines[i]->count != 0; i++)
+			AppendFormat(outText, "%14llu  %s:%i\n", ToULL(hotLines[i]->count), getPath(hotLines[i]->fileIndex), hotLines[i]->line);
+
+		std::vector<const BranchCoverage*> hotBranches;
+
+		for (const BranchCoverage& branch : report.branches)
+			hotBranches.push_back(&branch);
+
+		std::stable_sort(hotBranches.begin(), hotBranches.end(), [](const BranchCoverage* p_lhs, const BranchCoverage* p_rhs)
+		{
+			return p_lhs->count > p_rhs->count;
+		});
+
+		AppendFormat(outText, "\n%-10s %14s %14s %7s  %s\n", "offset", "count", "taken", "taken %", "line");
+
+		for (size_t i = 0; i < hotBranches.size() && i < maxRows; i++)
+		{
+			const BranchCoverage& branch = *hotBranches[i];
+
+			AppendFormat(
+				outText, "%-10i %14llu %14llu %6.2f%%  %s:%i\n",
+				branch.codeOffset,
+				ToULL(branch.count),
+				ToULL(branch.takenCount),
+				branch.count > 0 ? 100.0 * static_cast<double>(branch.takenCount) / static_cast<double>(branch.count) : 0.0,
+				getPath(branch.fileIndex),
+				branch.line
+			);
+		}
+
+		outText += "\nnever executed\n";
+
+		for (const LineCoverage& line : report.lines)
+		{
+			if (line.count == 0)
+				AppendFormat(outText, "  %s:%i\n", getPath(line.fileIndex), line.line);
+		}
+	}
+}
\ No newline at end of file
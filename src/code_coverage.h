@@ -0,0 +1,100 @@
+#pragma once
+#include "common.h"
+#include "virtual_machine.h"
+#include "code_builder.h"
+#include "preprocessor.h"
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+namespace Tolo
+{
+	// executions of every instruction while covering, and how often each conditional jump was taken
+	struct CodeCoverage
+	{
+		Ptr p_stack;
+		std::vector<uint64_t> offsetCounts;
+		std::vector<uint64_t> takenCounts; // only counted at Write_IP_If
+
+		CodeCoverage();
+
+		// clears all counts for code up to codeEnd
+		void Reset(Ptr _p_stack, Int codeEnd);
+
+		void Cover(Ptr p_instructionPtr)
+		{
+			offsetCounts[static_cast<size_t>(p_instructionPtr - p_stack)]++;
+		}
+
+		// called after the instruction at p_instructionPtr ran and moved the ip to p_nextIp
+		void CoverJump(Ptr p_instructionPtr, Ptr p_nextIp)
+		{
+			if (static_cast<OpCode>(*p_instructionPtr) == OpCode::Write_IP_If && p_nextIp != p_instructionPtr + sizeof(Char))
+				takenCounts[static_cast<size_t>(p_instructionPtr - p_stack)]++;
+		}
+	};
+
+	// what the coverage is resolved to source lines with
+	struct CoverageContext
+	{
+		Ptr p_stack;
+		Int codeStart;
+		Int codeEnd; // end of the built code
+		std::vector<std::pair<Ptr, std::string>> functions; // current entry of each script function
+		const std::vector<CodeLine>* p_codeLines;
+		const SourceMap* p_sourceMap;
+
+		CoverageContext();
+	};
+
+	struct FunctionCoverage
+	{
+		std::string functionHash;
+		Int fileIndex;
+		Int line;
+		uint64_t callCount;
+
+		FunctionCoverage();
+	};
+
+	struct LineCoverage
+	{
+		Int fileIndex;
+		Int line;
+		uint64_t count; // most executions of an instruction built from the line
+
+		LineCoverage();
+	};
+
+	// a Write_IP_If, taken when it jumped
+	struct BranchCoverage
+	{
+		Int fileIndex;
+		Int line;
+		Int codeOffset;
+		uint64_t count;
+		uint64_t takenCount;
+
+		BranchCoverage();
+	};
+
+	// coverage per source line, every part sorted by file and line, code built from no line is
+	// left out
+	struct CoverageReport
+	{
+		std::vector<std::string> filePaths;
+		std::vector<FunctionCoverage> functions;
+		std::vector<LineCoverage> lines;
+		std::vector<BranchCoverage> branches;
+	};
+
+	void BuildCoverageReport(const CoverageContext& context, const CodeCoverage& coverage, CoverageReport& outReport);
+
+	// one record per file in the lcov tracefile format, branch 0 of each jump is taken and
+	// branch 1 falls through
+	void WriteCoverageLcov(const CoverageReport& report, std::string& outText);
+
+	// the most executed lines and branches, at most maxRows each, then the lines never executed
+	void WriteCoverageText(const CoverageReport& report, size_t maxRows, std::string& outText);
+}
\ No newline at end of file
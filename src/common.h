@@ -3,6 +3,10 @@
 #include <string>
 #include <cassert>
 
+// runs scripts on a VM that counts instructions and function calls for 'ProgramHandle::GetProfile',
+// which makes them slower
+//#define PROFILE_VM
+
 namespace Tolo
 {
 	typedef char Char;
@@ -70,6 +74,7 @@ namespace Tolo
 
 		Ptr_Add,//			-					Ptr Int				Ptr
 		Ptr_Sub,//			-					Ptr Int				Ptr
+		Ptr_Offset,//		-					Int Ptr				Ptr
 		Ptr_Less,//			-					Ptr Ptr				Char
 		Ptr_Greater,//		-					Ptr Ptr				Char
 		Ptr_Equal,//		-					Ptr Ptr				Char
@@ -0,0 +1,100 @@
+#include "compile_cache.h"
+#include "common.h"
+
+namespace Tolo
+{
+	uint64_t HashBytes(const char* p_data, size_t size)
+	{
+		uint64_t hash = 14695981039346656037ull;
+
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= static_cast<unsigned char>(p_data[i]);
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	CompileCache::Entry::Entry(const std::string& _key, const std::shared_ptr<const std::string>& _p_imageData) :
+		key(_key),
+		p_imageData(_p_imageData)
+	{}
+
+	CompileCache::CompileCache(size_t _capacity) :
+		capacity(_capacity),
+		hitCount(0),
+		missCount(0)
+	{
+		Affirm(capacity > 0, "compile cache capacity must be greater than 0");
+	}
+
+	std::shared_ptr<const std::string> CompileCache::Find(const std::string& key)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto it = keyToEntry.find(key);
+
+		if (it == keyToEntry.end())
+		{
+			missCount++;
+			return nullptr;
+		}
+
+		hitCount++;
+		entries.splice(entries.begin(), entries, it->second);
+
+		return it->second->p_imageData;
+	}
+
+	void CompileCache::Insert(const std::string& key, const std::shared_ptr<const std::string>& p_imageData)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto it = keyToEntry.find(key);
+
+		if (it != keyToEntry.end())
+		{
+			it->second->p_imageData = p_imageData;
+			entries.splice(entries.begin(), entries, it->second);
+			return;
+		}
+
+		if (entries.size() == capacity)
+		{
+			keyToEntry.erase(entries.back().key);
+			entries.pop_back();
+		}
+
+		entries.emplace_front(key, p_imageData);
+		keyToEntry[key] = entries.begin();
+	}
+
+	void CompileCache::Clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		entries.clear();
+		keyToEntry.clear();
+		hitCount = 0;
+		missCount = 0;
+	}
+
+	size_t CompileCache::GetHitCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return hitCount;
+	}
+
+	size_t CompileCache::GetMissCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return missCount;
+	}
+
+	size_t CompileCache::GetSize() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return entries.size();
+	}
+}
\ No newline at end of file
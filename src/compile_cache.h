@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <map>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+namespace Tolo
+{
+	// 64 bit FNV-1a
+	uint64_t HashBytes(const char* p_data, size_t size);
+
+	// least recently used cache of serialized program images, shared between program handles
+	// compiling the same source, safe to use from several threads
+	class CompileCache
+	{
+	private:
+		struct Entry
+		{
+			std::string key;
+			std::shared_ptr<const std::string> p_imageData;
+
+			Entry(const std::string& _key, const std::shared_ptr<const std::string>& _p_imageData);
+		};
+
+		size_t capacity;
+		size_t hitCount;
+		size_t missCount;
+		std::list<Entry> entries; // most recently used first
+		std::map<std::string, std::list<Entry>::iterator> keyToEntry;
+		mutable std::mutex mutex;
+
+	public:
+		CompileCache(size_t _capacity);
+
+		// returns nullptr on a miss
+		std::shared_ptr<const std::string> Find(const std::string& key);
+
+		void Insert(const std::string& key, const std::shared_ptr<const std::string>& p_imageData);
+
+		void Clear();
+
+		size_t GetHitCount() const;
+
+		size_t GetMissCount() const;
+
+		size_t GetSize() const;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "compile_stats.h"
+#include <cstdio>
+
+namespace Tolo
+{
+	CompileStats::CompileStats() :
+		readSeconds(0.0),
+		preprocessSeconds(0.0),
+		lexSeconds(0.0),
+		declarationsSeconds(0.0),
+		functionsSeconds(0.0),
+		codeSeconds(0.0),
+		totalSeconds(0.0),
+		sourceBytes(0),
+		tokenCount(0),
+		lexNodeCount(0),
+		expressionCount(0),
+		arenaUsedBytes(0),
+		arenaReservedBytes(0),
+		functionCount(0),
+		builtFunctionCount(0),
+		codeSize(0),
+		constStringsSize(0),
+		isFromImage(false)
+	{}
+
+	double SecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+		return seconds.count();
+	}
+
+	template<typename... ARGS>
+	static void AppendFormat(std::string& outText, const char* format, ARGS... args)
+	{
+		char buffer[256];
+		std::snprintf(buffer, sizeof(buffer), format, args...);
+		outText += buffer;
+	}
+
+	static void AppendPhase(std::string& outText, const char* name, double seconds, double totalSeconds)
+	{
+		AppendFormat(
+			outText, "%-14s %10.3f ms %6.2f%%\n",
+			name, seconds * 1000.0, totalSeconds > 0.0 ? 100.0 * seconds / totalSeconds : 0.0
+		);
+	}
+
+	void WriteCompileStatsText(const CompileStats& stats, std::string& outText)
+	{
+		outText.clear();
+
+		AppendPhase(outText, "read", stats.readSeconds, stats.totalSeconds);
+		AppendPhase(outText, "preprocess", stats.preprocessSeconds, stats.totalSeconds);
+		AppendPhase(outText, "lex", stats.lexSeconds, stats.totalSeconds);
+		AppendPhase(outText, "declarations", stats.declarationsSeconds, stats.totalSeconds);
+		AppendPhase(outText, "functions", stats.functionsSeconds, stats.totalSeconds);
+		AppendPhase(outText, "code", stats.codeSeconds, stats.totalSeconds);
+		AppendFormat(outText, "%-14s %10.3f ms%s\n", "total", stats.totalSeconds * 1000.0, stats.isFromImage ? " (from image)" : "");
+
+		AppendFormat(outText, "%-14s %10zu\n", "source bytes", stats.sourceBytes);
+		AppendFormat(outText, "%-14s %10zu\n", "tokens", stats.tokenCount);
+		AppendFormat(outText, "%-14s %10zu\n", "lex nodes", stats.lexNodeCount);
+		AppendFormat(outText, "%-14s %10zu\n", "expressions", stats.expressionCount);
+		AppendFormat(outText, "%-14s %10zu reserved %zu\n", "arena bytes", stats.arenaUsedBytes, stats.arenaReservedBytes);
+		AppendFormat(outText, "%-14s %10zu built %zu\n", "functions", stats.functionCount, stats.builtFunctionCount);
+		AppendFormat(outText, "%-14s %10i\n", "code bytes", stats.codeSize);
+		AppendFormat(outText, "%-14s %10i\n", "string bytes", stats.constStringsSize);
+	}
+}
\ No newline at end of file
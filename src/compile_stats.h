@@ -0,0 +1,41 @@
+#pragma once
+#include "common.h"
+#include <string>
+#include <chrono>
+#include <functional>
+
+namespace Tolo
+{
+	// where the last compile of a program spent its time and memory, phases that did not run stay 0
+	struct CompileStats
+	{
+		double readSeconds; // the main file, included files are read while preprocessing
+		double preprocessSeconds;
+		double lexSeconds; // tokens are streamed into the lexer, so this includes tokenizing
+		double declarationsSeconds;
+		double functionsSeconds; // parsing and building the function bodies
+		double codeSeconds; // building the rest of the program and resolving labels
+		double totalSeconds;
+		size_t sourceBytes; // of the preprocessed code
+		size_t tokenCount;
+		size_t lexNodeCount; // allocated in the arena of the lexer
+		size_t expressionCount; // allocated in the arenas of the parsers
+		size_t arenaUsedBytes;
+		size_t arenaReservedBytes;
+		size_t functionCount;
+		size_t builtFunctionCount; // the rest was reused from a cache or is built lazily
+		Int codeSize; // without the capacity kept for hot reloads and lazy functions
+		Int constStringsSize;
+		bool isFromImage; // loaded from a compile cache, nothing was lexed or parsed
+
+		CompileStats();
+	};
+
+	// receives the stats of each compile with the path of the compiled program
+	typedef std::function<void(const std::string& codePath, const CompileStats& stats)> CompileStatsSink;
+
+	double SecondsSince(std::chrono::steady_clock::time_point start);
+
+	// one line per phase and count
+	void WriteCompileStatsText(const CompileStats& stats, std::string& outText);
+}
\ No newline at end of file
@@ -0,0 +1,248 @@
+#include "disassembler.h"
+#include "virtual_machine.h"
+#include <cstdio>
+
+namespace Tolo
+{
+	DisassemblyContext::DisassemblyContext() :
+		p_stack(nullptr),
+		constStringsSize(0),
+		codeEnd(0),
+		p_offsetToNativeFunctionHash(nullptr),
+		p_codeLines(nullptr),
+		p_sourceMap(nullptr)
+	{}
+
+	template<typename... ARGS>
+	static void AppendFormat(std::string& outText, const char* format, ARGS... args)
+	{
+		char buffer[512];
+		std::snprintf(buffer, sizeof(buffer), format, args...);
+		outText += buffer;
+	}
+
+	static void AppendEscaped(std::string& outText, const char* p_str)
+	{
+		for (; *p_str != '\0'; p_str++)
+		{
+			switch (*p_str)
+			{
+			case '\n': outText += "\\n"; break;
+			case '\t': outText += "\\t"; break;
+			case '"': outText += "\\\""; break;
+			case '\\': outText += "\\\\"; break;
+			default: outText += *p_str; break;
+			}
+		}
+	}
+
+	// names what a pointer in the code at offset points at
+	static void AppendPtr(const DisassemblyContext& context, Int offset, std::string& outText)
+	{
+		auto nativeIt = context.p_offsetToNativeFunctionHash->find(offset);
+
+		if (nativeIt != context.p_offsetToNativeFunctionHash->end())
+		{
+			outText += "native " + nativeIt->second;
+			return;
+		}
+
+		Ptr p_val = Get<Ptr>(context.p_stack + offset);
+
+		if (p_val >= context.p_stack && p_val < context.p_stack + context.constStringsSize)
+		{
+			outText += '"';
+			AppendEscaped(outText, p_val);
+			outText += '"';
+			return;
+		}
+
+		// the label main returns to, behind the code and the space kept for appended code
+		if (p_val == context.p_stack + context.codeEnd)
+		{
+			AppendFormat(outText, "@%i <program end>", context.codeEnd);
+			return;
+		}
+
+		if (p_val >= context.p_stack && p_val < context.p_stack + context.codeEnd)
+		{
+			const std::pair<Ptr, std::string>* p_entry = context.functionEntries.FindEntry(p_val);
+			AppendFormat(outText, "@%i", static_cast<Int>(p_val - context.p_stack));
+
+			if (p_entry == nullptr)
+				return;
+
+			outText += " " + p_entry->second;
+
+			if (p_entry->first != p_val)
+				AppendFormat(outText, "+%i", static_cast<Int>(p_val - p_entry->first));
+
+			return;
+		}
+
+		AppendFormat(outText, "%p", static_cast<void*>(p_val));
+	}
+
+	static void AppendSourceLine(
+		const DisassemblyContext& context,
+		const std::vector<std::vector<size_t>>& fileLineStarts,
+		Int line,
+		std::string& outText
+	)
+	{
+		SourceLocation location;
+
+		if (!context.p_sourceMap->TryGetLocationOfLine(line, location))
+		{
+			AppendFormat(outText, "    ; line %i\n", line);
+			return;
+		}
+
+		const std::string& filePath = context.p_sourceMap->filePaths[location.fileIndex];
+		AppendFormat(outText, "    ; %s:%i", filePath.c_str(), location.line);
+
+		size_t fileIndex = static_cast<size_t>(location.fileIndex);
+		size_t lineIndex = static_cast<size_t>(location.line - 1);
+
+		if (fileIndex < fileLineStarts.size() && lineIndex < fileLineStarts[fileIndex].size())
+		{
+			const std::string& text = context.fileTexts[fileIndex];
+			size_t start = fileLineStarts[fileIndex][lineIndex];
+			size_t end = text.find('\n', start);
+
+			if (end == std::string::npos)
+				end = text.size();
+
+			while (start < end && (text[start] == ' ' || text[start] == '\t'))
+				start++;
+
+			while (end > start && (text[end - 1] == '\r' || text[end - 1] == ' ' || text[end - 1] == '\t'))
+				end--;
+
+			outText += "  " + text.substr(start, end - start);
+		}
+
+		outText += '\n';
+	}
+
+	void WriteDisassembly(const DisassemblyContext& context, Int startOffset, Int endOffset, std::string& outText)
+	{
+		outText.clear();
+
+		std::vector<std::vector<size_t>> fileLineStarts(context.fileTexts.size());
+
+		for (size_t i = 0; i < context.fileTexts.size(); i++)
+		{
+			const std::string& text = context.fileTexts[i];
+
+			if (text.empty())
+				continue;
+
+			fileLineStarts[i].push_back(0);
+
+			for (size_t c = 0; c < text.size(); c++)
+			{
+				if (text[c] == '\n' && c + 1 < text.size())
+					fileLineStarts[i].push_back(c + 1);
+			}
+		}
+
+		const auto& entries = context.functionEntries.entries;
+		size_t nextEntry = 0;
+		bool isReplaced = false;
+		Int lastLine = 0;
+
+		if (entries.empty() || entries.front().first != context.p_stack + startOffset)
+			outText += "<program>:\n";
+
+		for (Int offset = startOffset; offset < endOffset;)
+		{
+			Ptr p_ip = context.p_stack + offset;
+
+			// functions start at their entries
+			for (; nextEntry < entries.size() && entries[nextEntry].first <= p_ip; nextEntry++)
+			{
+				if (entries[nextEntry].first != p_ip)
+					continue;
+
+				isReplaced = context.replacedEntries.count(p_ip) != 0;
+				lastLine = 0;
+				AppendFormat(outText, "\n%s:%s\n", entries[nextEntry].second.c_str(), isReplaced ? " (replaced)" : "");
+			}
+
+			Int line = FindCodeLine(*context.p_codeLines, offset);
+
+			if (line != lastLine && line > 0)
+				AppendSourceLine(context, fileLineStarts, line, outText);
+
+			lastLine = line;
+
+			if (line == DATA_CODE_LINE)
+			{
+				AppendFormat(outText, "  %8i  %-20s ", offset, "data");
+
+				if (offset + static_cast<Int>(sizeof(Ptr)) <= endOffset)
+					AppendPtr(context, offset, outText);
+
+				outText += '\n';
+				offset += sizeof(Ptr);
+				continue;
+			}
+
+			OpCode opCode = static_cast<OpCode>(*p_ip);
+			Int immediateSize = GetImmediateSize(opCode);
+
+			AppendFormat(outText, "  %8i  %-20s", offset, GetOpCodeName(opCode));
+
+			if (offset + 1 + immediateSize > endOffset)
+			{
+				outText += " <truncated>\n";
+				break;
+			}
+
+			Ptr p_immediate = p_ip + sizeof(Char);
+
+			switch (opCode)
+			{
+			case OpCode::Load_Const_Char:
+			{
+				Char val = Get<Char>(p_immediate);
+				AppendFormat(outText, " %i", static_cast<int>(val));
+
+				if (val >= ' ' && val <= '~')
+					AppendFormat(outText, " '%c'", val);
+				break;
+			}
+			case OpCode::Load_Const_Int:
+				AppendFormat(outText, " %i", Get<Int>(p_immediate));
+				break;
+			case OpCode::Load_Const_Float:
+				AppendFormat(outText, " %g", static_cast<double>(Get<Float>(p_immediate)));
+				break;
+			case OpCode::Load_Const_Ptr:
+				outText += ' ';
+				AppendPtr(context, offset + static_cast<Int>(sizeof(Char)), outText);
+				break;
+			case OpCode::Call:
+				AppendFormat(outText, " params %i locals %i", Get<Int>(p_immediate), Get<Int>(p_immediate + sizeof(Int)));
+				break;
+			case OpCode::Return:
+				AppendFormat(outText, " size %i", Get<Int>(p_immediate));
+				break;
+			default:
+				// no immediate
+				break;
+			}
+
+			outText += '\n';
+			offset += 1 + immediateSize;
+
+			// the rest of a replaced function is never run and may start inside an instruction
+			if (isReplaced && opCode == OpCode::Write_IP)
+			{
+				isReplaced = false;
+				offset = nextEntry < entries.size() ? static_cast<Int>(entries[nextEntry].first - context.p_stack) : endOffset;
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+#include "common.h"
+#include "code_builder.h"
+#include "preprocessor.h"
+#include "profiler.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+namespace Tolo
+{
+	// what the disassembler resolves pointers and source lines with
+	struct DisassemblyContext
+	{
+		Ptr p_stack;
+		Int constStringsSize;
+		Int codeEnd;
+		FunctionEntries functionEntries;
+		std::set<Ptr> replacedEntries; // old entries that only jump to the new code of their function
+		const std::map<Int, std::string>* p_offsetToNativeFunctionHash;
+		const std::vector<CodeLine>* p_codeLines;
+		const SourceMap* p_sourceMap;
+		std::vector<std::string> fileTexts; // text of each file of the source map, empty skips the text
+
+		DisassemblyContext();
+	};
+
+	// writes one instruction per line with its decoded immediate, the name of each function
+	// and the source line the following instructions were built from are written above them
+	void WriteDisassembly(const DisassemblyContext& context, Int startOffset, Int endOffset, std::string& outText);
+}
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "execution_trace.h"
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+#define TRACE_VERSION 1
+
+namespace Tolo
+{
+	VMTracer::VMTracer() :
+		p_stack(nullptr),
+		nextRecord(0),
+		recordCount(0)
+	{}
+
+	void VMTracer::Start(Ptr _p_stack, size_t recordCapacity)
+	{
+		Affirm(recordCapacity > 0, "trace capacity must be greater than 0");
+
+		p_stack = _p_stack;
+		records.assign(recordCapacity, TraceRecord{});
+		nextRecord = 0;
+		recordCount = 0;
+	}
+
+	size_t VMTracer::GetHeldRecordCount() const
+	{
+		return static_cast<size_t>(std::min<uint64_t>(recordCount, records.size()));
+	}
+
+
+	ExecutionTrace::ExecutionTrace() :
+		header{}
+	{
+		std::memcpy(header.magic, "TRCE", 4);
+		header.version = TRACE_VERSION;
+		header.recordCount = 0;
+		header.nativeCount = 0;
+		header.executedCount = 0;
+	}
+
+	void CaptureExecutionTrace(const VMTracer& tracer, const std::map<Ptr, std::string>& nativePtrToHash, ExecutionTrace& outTrace)
+	{
+		std::map<Ptr, Int> nativePtrToIndex;
+		size_t heldCount = tracer.GetHeldRecordCount();
+
+		outTrace.records.clear();
+		outTrace.records.reserve(heldCount);
+		outTrace.nativeFunctionHashes.clear();
+
+		// the oldest held record is overwritten next
+		size_t firstRecord = heldCount < tracer.records.size() ? 0 : tracer.nextRecord;
+
+		for (size_t i = 0; i < heldCount; i++)
+		{
+			const TraceRecord& record = tracer.records[(firstRecord + i) % tracer.records.size()];
+			TraceDumpRecord& dumpRecord = outTrace.records.emplace_back();
+			dumpRecord.codeOffset = record.codeOffset;
+			dumpRecord.opCode = static_cast<unsigned char>(record.opCode);
+			dumpRecord.stackDelta = record.stackDelta;
+			dumpRecord.target = -1;
+
+			if (static_cast<OpCode>(record.opCode) == OpCode::Call)
+			{
+				dumpRecord.target = static_cast<Int>(record.p_target - tracer.p_stack);
+			}
+			else if (static_cast<OpCode>(record.opCode) == OpCode::Call_Native)
+			{
+				auto hashIt = nativePtrToHash.find(record.p_target);
+
+				if (hashIt == nativePtrToHash.end())
+					continue;
+
+				auto indexIt = nativePtrToIndex.find(record.p_target);
+
+				if (indexIt == nativePtrToIndex.end())
+				{
+					indexIt = nativePtrToIndex.emplace(record.p_target, static_cast<Int>(outTrace.nativeFunctionHashes.size())).first;
+					outTrace.nativeFunctionHashes.push_back(hashIt->second);
+				}
+
+				dumpRecord.target = indexIt->second;
+			}
+		}
+
+		outTrace.header.recordCount = static_cast<Int>(outTrace.records.size());
+		outTrace.header.nativeCount = static_cast<Int>(outTrace.nativeFunctionHashes.size());
+		outTrace.header.executedCount = tracer.recordCount;
+	}
+
+	template<typename T>
+	static void WriteArray(std::string& outData, const T* p_values, size_t count)
+	{
+		outData.append(reinterpret_cast<const char*>(p_values), sizeof(T) * count);
+	}
+
+	void SerializeExecutionTrace(const ExecutionTrace& trace, std::string& outData)
+	{
+		outData.reserve(sizeof(TraceHeader) + sizeof(TraceDumpRecord) * trace.records.size());
+
+		WriteArray(outData, &trace.header, 1);
+		WriteArray(outData, trace.records.data(), trace.records.size());
+
+		for (const std::string& hash : trace.nativeFunctionHashes)
+		{
+			Int length = static_cast<Int>(hash.size());
+			WriteArray(outData, &length, 1);
+			outData.append(hash);
+		}
+	}
+
+	struct TraceReader
+	{
+		const char* p_data;
+		size_t size;
+		size_t offset;
+
+		void Read(void* p_dst, size_t byteCount)
+		{
+			Affirm(offset + byteCount <= size, "trace is truncated");
+
+			std::memcpy(p_dst, p_data + offset, byteCount);
+			offset += byteCount;
+		}
+	};
+
+	void DeserializeExecutionTrace(const char* p_data, size_t size, ExecutionTrace& outTrace)
+	{
+		TraceReader reader{ p_data, size, 0 };
+		TraceHeader& header = outTrace.header;
+
+		reader.Read(&header, sizeof(TraceHeader));
+
+		Affirm(
+			std::memcmp(header.magic, "TRCE", 4) == 0,
+			"data is not a trace"
+		);
+
+		Affirm(
+			header.version == TRACE_VERSION,
+			"trace version %i is not supported, expected version %i",
+			header.version, TRACE_VERSION
+		);
+
+		Affirm(
+			header.recordCount >= 0 &&
+			header.nativeCount >= 0,
+			"trace is corrupt"
+		);
+
+		outTrace.records.resize(static_cast<size_t>(header.recordCount));
+		reader.Read(outTrace.records.data(), sizeof(TraceDumpRecord) * outTrace.records.size());
+
+		outTrace.nativeFunctionHashes.resize(static_cast<size_t>(header.nativeCount));
+
+		for (std::string& hash : outTrace.nativeFunctionHashes)
+		{
+			Int length = 0;
+			reader.Read(&length, sizeof(Int));
+
+			Affirm(length >= 0 && reader.offset + length <= size, "trace is corrupt");
+
+			hash.assign(p_data + reader.offset, static_cast<size_t>(length));
+			reader.offset += static_cast<size_t>(length);
+		}
+
+		for (const TraceDumpRecord& record : outTrace.records)
+		{
+			Affirm(
+				record.opCode >= 0 &&
+				record.opCode < static_cast<Int>(OpCode::INVALID) &&
+				(static_cast<OpCode>(record.opCode) != OpCode::Call_Native || record.target < header.nativeCount),
+				"trace is corrupt"
+			);
+		}
+	}
+
+
+	TraceDecodeContext::TraceDecodeContext() :
+		p_stack(nullptr),
+		p_codeLines(nullptr),
+		p_sourceMap(nullptr)
+	{}
+
+	template<typename... ARGS>
+	static void AppendFormat(std::string& outText, const char* format, ARGS... args)
+	{
+		char buffer[256];
+		std::snprintf(buffer, sizeof(buffer), format, args...);
+		outText += buffer;
+	}
+
+	static const char* GetFunctionName(const TraceDecodeContext& context, Int offset)
+	{
+		const std::string* p_functionHash = context.functionEntries.Find(context.p_stack + offset);
+		return p_functionHash != nullptr ? p_functionHash->c_str() : "<program>";
+	}
+
+	void WriteTraceText(const TraceDecodeContext& context, const ExecutionTrace& trace, std::string& outText)
+	{
+		outText.clear();
+
+		AppendFormat(
+			outText, "%llu instructions traced, the last %i follow\n",
+			static_cast<unsigned long long>(trace.header.executedCount), trace.header.recordCount
+		);
+
+		for (const TraceDumpRecord& record : trace.records)
+		{
+			OpCode opCode = static_cast<OpCode>(record.opCode);
+
+			AppendFormat(
+				outText, "%8i  %-24s %+6i  %s",
+				record.codeOffset, GetOpCodeName(opCode), record.stackDelta, GetFunctionName(context, record.codeOffset)
+			);
+
+			SourceLocation location;
+
+			if (context.p_sourceMap->TryGetLocationOfLine(FindCodeLine(*context.p_codeLines, record.codeOffset), location))
+				AppendFormat(outText, "  %s:%i", context.p_sourceMap->filePaths[location.fileIndex].c_str(), location.line);
+
+			if (opCode == OpCode::Call)
+				outText += std::string("  -> ") + GetFunctionName(context, record.target);
+			else if (opCode == OpCode::Call_Native && record.target >= 0)
+				outText += "  -> native " + trace.nativeFunctionHashes[static_cast<size_t>(record.target)];
+
+			outText += '\n';
+		}
+	}
+}
\ No newline at end of file
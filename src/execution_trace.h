@@ -0,0 +1,120 @@
+#pragma once
+#include "common.h"
+#include "virtual_machine.h"
+#include "code_builder.h"
+#include "preprocessor.h"
+#include "profiler.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <map>
+
+namespace Tolo
+{
+	// one executed instruction, written before it runs so that a run that fails ends with the
+	// instruction that failed
+	struct TraceRecord
+	{
+		Ptr p_target; // the called script function or native, nullptr for other instructions
+		Int codeOffset;
+		Int stackDelta; // sp after the instruction minus sp before, 0 if it did not finish
+		Char opCode;
+	};
+
+	// keeps the last records of everything the VM executed while tracing, older ones are overwritten
+	struct VMTracer
+	{
+		Ptr p_stack;
+		std::vector<TraceRecord> records;
+		size_t nextRecord;
+		uint64_t recordCount;
+
+		VMTracer();
+
+		void Start(Ptr _p_stack, size_t recordCapacity);
+
+		// returns the number of the record to finish
+		uint64_t Begin(const VirtualMachine& vm)
+		{
+			TraceRecord& record = records[nextRecord];
+			record.codeOffset = static_cast<Int>(vm.p_instructionPtr - p_stack);
+			record.opCode = *vm.p_instructionPtr;
+			record.stackDelta = 0;
+
+			// both calls pop their target
+			OpCode opCode = static_cast<OpCode>(record.opCode);
+			bool isCall = opCode == OpCode::Call || opCode == OpCode::Call_Native;
+			record.p_target = isCall ? Get<Ptr>(vm.p_stackPtr - sizeof(Ptr)) : nullptr;
+
+			nextRecord = nextRecord + 1 == records.size() ? 0 : nextRecord + 1;
+			return recordCount++;
+		}
+
+		void Finish(uint64_t recordNumber, Int stackDelta)
+		{
+			// natives calling back into the script may have overwritten the record
+			if (recordCount - recordNumber <= records.size())
+				records[static_cast<size_t>(recordNumber % records.size())].stackDelta = stackDelta;
+		}
+
+		// number of records held, older ones are overwritten
+		size_t GetHeldRecordCount() const;
+	};
+
+	/*
+	binary dump of a trace, independent of where the program was loaded, all sections follow each
+	other in this order:
+
+	TraceHeader
+	records			TraceDumpRecord[recordCount], oldest first
+	natives			hashes of the called natives, each stored as an Int length followed by the chars
+	*/
+
+	struct TraceHeader
+	{
+		Char magic[4];
+		Int version;
+		Int recordCount;
+		Int nativeCount;
+		uint64_t executedCount; // records written while tracing, the held ones included
+	};
+
+	struct TraceDumpRecord
+	{
+		Int codeOffset;
+		Int opCode;
+		Int stackDelta;
+		Int target; // code offset of the called script function, index of the called native, -1 otherwise
+	};
+
+	struct ExecutionTrace
+	{
+		TraceHeader header;
+		std::vector<TraceDumpRecord> records;
+		std::vector<std::string> nativeFunctionHashes;
+
+		ExecutionTrace();
+	};
+
+	// copies the held records of the tracer, natives not in nativePtrToHash get no target
+	void CaptureExecutionTrace(const VMTracer& tracer, const std::map<Ptr, std::string>& nativePtrToHash, ExecutionTrace& outTrace);
+
+	void SerializeExecutionTrace(const ExecutionTrace& trace, std::string& outData);
+
+	void DeserializeExecutionTrace(const char* p_data, size_t size, ExecutionTrace& outTrace);
+
+	// what a trace is decoded with, must be the program that wrote it
+	struct TraceDecodeContext
+	{
+		Ptr p_stack;
+		FunctionEntries functionEntries;
+		const std::vector<CodeLine>* p_codeLines;
+		const SourceMap* p_sourceMap;
+
+		TraceDecodeContext();
+	};
+
+	// one line per record, oldest first, with the function and source line of each instruction
+	// and the name of each called function
+	void WriteTraceText(const TraceDecodeContext& context, const ExecutionTrace& trace, std::string& outText);
+}
\ No newline at end of file
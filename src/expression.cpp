@@ -64,6 +64,18 @@ namespace Tolo
 	}
 
 
+	ELoadNativeFunctionPtr::ELoadNativeFunctionPtr(const std::string& _functionHash, Ptr _p_function) :
+		functionHash(_functionHash),
+		p_function(_p_function)
+	{}
+
+	void ELoadNativeFunctionPtr::Evaluate(CodeBuilder& cb)
+	{
+		cb.Op(OpCode::Load_Const_Ptr);
+		cb.ConstNativeFunctionPtr(functionHash, p_function);
+	}
+
+
 	ELoadConstPtrToLabel::ELoadConstPtrToLabel(const std::string& _labelName) :
 		labelName(_labelName)
 	{}
@@ -101,12 +113,19 @@ namespace Tolo
 
 
 	EDefineFunction::EDefineFunction(const std::string& _functionName) :
-		functionName(_functionName)
+		functionName(_functionName),
+		p_code(nullptr)
 	{}
 
 
 	void EDefineFunction::Evaluate(CodeBuilder& cb) 
 	{
+		if (p_code != nullptr)
+		{
+			cb.Append(*p_code);
+			return;
+		}
+
 		cb.DefineLabel(functionName);
 
 		for (auto e : body)
@@ -145,7 +164,7 @@ namespace Tolo
 
 	void EPtrAdd::Evaluate(CodeBuilder& cb)
 	{
-		cb.Op(OpCode::Ptr_Add);
+		cb.Op(OpCode::Ptr_Offset);
 	}
 
 
@@ -226,6 +245,22 @@ namespace Tolo
 	}
 
 
+	EStatement::EStatement(Int _line, ExpPtr _statement) :
+		line(_line),
+		statement(_statement)
+	{}
+
+	void EStatement::Evaluate(CodeBuilder& cb)
+	{
+		// code after a nested statement belongs to the enclosing one again
+		Int outerLine = cb.currentLine;
+
+		cb.SetLine(line);
+		statement->Evaluate(cb);
+		cb.SetLine(outerLine);
+	}
+
+
 	EScope::EScope()
 	{}
 
@@ -266,27 +301,26 @@ namespace Tolo
 
 	void EWhile::Evaluate(CodeBuilder& cb)
 	{
-		cb.currentWhileDepth++;
-		std::string depthId = std::to_string(cb.currentWhileDepth);
+		LabelId bodyLabel = cb.CreateLabel();
+		LabelId conditionLabel = cb.CreateLabel();
+		LabelId endLabel = cb.CreateLabel();
+		cb.whileStack.push_back({ conditionLabel, endLabel });
 
-		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(depthId + "while_condition");
+		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(conditionLabel);
 		cb.Op(OpCode::Write_IP);
 
-		cb.DefineLabel(depthId + "while_body");
+		cb.DefineLabel(bodyLabel);
 		for (auto e : body)
 			e->Evaluate(cb);
 
-		cb.DefineLabel(depthId + "while_condition");
-		cb.RemoveLabel(depthId + "while_condition");
-		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(depthId + "while_body");
-		cb.RemoveLabel(depthId + "while_body");
+		cb.DefineLabel(conditionLabel);
+		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(bodyLabel);
 		conditionLoad->Evaluate(cb);
 		cb.Op(OpCode::Write_IP_If);
 
-		cb.DefineLabel(depthId + "while_end");
-		cb.RemoveLabel(depthId + "while_end");
+		cb.DefineLabel(endLabel);
 
-		cb.currentWhileDepth--;
+		cb.whileStack.pop_back();
 	}
 
 
@@ -295,26 +329,22 @@ namespace Tolo
 
 	void EIfSingle::Evaluate(CodeBuilder& cb)
 	{
-		cb.currentBranchDepth++;
-		std::string depthId = std::to_string(cb.currentBranchDepth);
+		LabelId bodyLabel = cb.CreateLabel();
+		LabelId endLabel = cb.CreateLabel();
 
-		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(depthId + "if_body");
+		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(bodyLabel);
 		conditionLoad->Evaluate(cb);
 		cb.Op(OpCode::Write_IP_If);
 
-		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(depthId + "if_end");
+		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(endLabel);
 		cb.Op(OpCode::Write_IP);
 
-		cb.DefineLabel(depthId + "if_body");
-		cb.RemoveLabel(depthId + "if_body");
+		cb.DefineLabel(bodyLabel);
 
 		for (auto e : body)
 			e->Evaluate(cb);
 
-		cb.DefineLabel(depthId + "if_end");
-		cb.RemoveLabel(depthId + "if_end");
-
-		cb.currentBranchDepth--;
+		cb.DefineLabel(endLabel);
 	}
 
 
@@ -323,34 +353,33 @@ namespace Tolo
 
 	void EIfChain::Evaluate(CodeBuilder& cb)
 	{
-		cb.currentBranchDepth++;
-		std::string depthId = std::to_string(cb.currentBranchDepth);
+		LabelId bodyLabel = cb.CreateLabel();
+		LabelId endLabel = cb.CreateLabel();
+		LabelId chainEndLabel = cb.CreateLabel();
+		cb.chainEndStack.push_back(chainEndLabel);
 
-		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(depthId + "if_body");
+		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(bodyLabel);
 		conditionLoad->Evaluate(cb);
 		cb.Op(OpCode::Write_IP_If);
 
-		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(depthId + "if_end");
+		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(endLabel);
 		cb.Op(OpCode::Write_IP);
 
-		cb.DefineLabel(depthId + "if_body");
-		cb.RemoveLabel(depthId + "if_body");
+		cb.DefineLabel(bodyLabel);
 
 		for (auto e : body)
 			e->Evaluate(cb);
 
-		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(depthId + "chain_end");
+		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(chainEndLabel);
 		cb.Op(OpCode::Write_IP);
 
-		cb.DefineLabel(depthId + "if_end");
-		cb.RemoveLabel(depthId + "if_end");
+		cb.DefineLabel(endLabel);
 
 		chain->Evaluate(cb);
 
-		cb.DefineLabel(depthId + "chain_end");
-		cb.RemoveLabel(depthId + "chain_end");
+		cb.DefineLabel(chainEndLabel);
 
-		cb.currentBranchDepth--;
+		cb.chainEndStack.pop_back();
 	}
 
 
@@ -359,23 +388,22 @@ namespace Tolo
 
 	void EElseIfSingle::Evaluate(CodeBuilder& cb)
 	{
-		std::string depthId = std::to_string(cb.currentBranchDepth);
+		LabelId bodyLabel = cb.CreateLabel();
+		LabelId endLabel = cb.CreateLabel();
 
-		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(depthId + "if_body");
+		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(bodyLabel);
 		conditionLoad->Evaluate(cb);
 		cb.Op(OpCode::Write_IP_If);
 
-		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(depthId + "if_end");
+		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(endLabel);
 		cb.Op(OpCode::Write_IP);
 
-		cb.DefineLabel(depthId + "if_body");
-		cb.RemoveLabel(depthId + "if_body");
+		cb.DefineLabel(bodyLabel);
 
 		for (auto e : body)
 			e->Evaluate(cb);
 
-		cb.DefineLabel(depthId + "if_end");
-		cb.RemoveLabel(depthId + "if_end");
+		cb.DefineLabel(endLabel);
 	}
 
 
@@ -384,26 +412,25 @@ namespace Tolo
 
 	void EElseIfChain::Evaluate(CodeBuilder& cb)
 	{
-		std::string depthId = std::to_string(cb.currentBranchDepth);
+		LabelId bodyLabel = cb.CreateLabel();
+		LabelId endLabel = cb.CreateLabel();
 
-		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(depthId + "if_body");
+		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(bodyLabel);
 		conditionLoad->Evaluate(cb);
 		cb.Op(OpCode::Write_IP_If);
 
-		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(depthId + "if_end");
+		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(endLabel);
 		cb.Op(OpCode::Write_IP);
 
-		cb.DefineLabel(depthId + "if_body");
-		cb.RemoveLabel(depthId + "if_body");
+		cb.DefineLabel(bodyLabel);
 
 		for (auto e : body)
 			e->Evaluate(cb);
 
-		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(depthId + "chain_end");
+		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(cb.chainEndStack.back());
 		cb.Op(OpCode::Write_IP);
 
-		cb.DefineLabel(depthId + "if_end");
-		cb.RemoveLabel(depthId + "if_end");
+		cb.DefineLabel(endLabel);
 
 		chain->Evaluate(cb);
 	}
@@ -426,10 +453,11 @@ namespace Tolo
 
 	void EBreak::Evaluate(CodeBuilder& cb)
 	{
-		Int destinationDepth = cb.currentWhileDepth - (depth - 1);
+		Int currentWhileDepth = static_cast<Int>(cb.whileStack.size());
+		Int destinationDepth = currentWhileDepth - (depth - 1);
 
 		Affirm(
-			destinationDepth <= cb.currentWhileDepth,
+			destinationDepth <= currentWhileDepth,
 			"break depth at line %i must be 1 or greater",
 			line
 		);
@@ -440,8 +468,7 @@ namespace Tolo
 			line
 		);
 
-		std::string depthId = std::to_string(destinationDepth);
-		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(depthId + "while_end");
+		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(cb.whileStack[destinationDepth - 1].endLabel);
 		cb.Op(OpCode::Write_IP);
 	}
 
@@ -453,10 +480,11 @@ namespace Tolo
 
 	void EContinue::Evaluate(CodeBuilder& cb)
 	{
-		Int destinationDepth = cb.currentWhileDepth - (depth - 1);
+		Int currentWhileDepth = static_cast<Int>(cb.whileStack.size());
+		Int destinationDepth = currentWhileDepth - (depth - 1);
 
 		Affirm(
-			destinationDepth <= cb.currentWhileDepth,
+			destinationDepth <= currentWhileDepth,
 			"continue depth at line %i must be 1 or greater",
 			line
 		);
@@ -467,8 +495,7 @@ namespace Tolo
 			line
 		);
 
-		std::string depthId = std::to_string(destinationDepth);
-		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(depthId + "while_condition");
+		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(cb.whileStack[destinationDepth - 1].conditionLabel);
 		cb.Op(OpCode::Write_IP);
 	}
 
@@ -497,9 +524,14 @@ namespace Tolo
 	void EDefineVTable::Evaluate(CodeBuilder& cb)
 	{
 		cb.DefineLabel("0virtual_table_" + vTableName);
+
+		Int outerLine = cb.currentLine;
+		cb.SetLine(DATA_CODE_LINE);
 		
 		for (const std::string& funcLabel : functionLabels)
 			cb.ConstPtrToLabel(funcLabel);
+
+		cb.SetLine(outerLine);
 	}
 
 
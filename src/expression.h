@@ -1,12 +1,11 @@
 #pragma once
 #include "code_builder.h"
-#include <memory>
 
 namespace Tolo
 {
 	struct Expression
 	{
-		using SharedExp = std::shared_ptr<Expression>;
+		using ExpPtr = Expression*;
 
 		Expression();
 
@@ -60,6 +59,16 @@ namespace Tolo
 		virtual void Evaluate(CodeBuilder& cb) override;
 	};
 
+	struct ELoadNativeFunctionPtr : public Expression
+	{
+		std::string functionHash;
+		Ptr p_function;
+
+		ELoadNativeFunctionPtr(const std::string& _functionHash, Ptr _p_function);
+
+		virtual void Evaluate(CodeBuilder& cb) override;
+	};
+
 	struct ELoadConstPtrToLabel : public Expression
 	{
 		std::string labelName;
@@ -82,7 +91,7 @@ namespace Tolo
 	struct ELoadBytesFromPtr : public Expression
 	{
 		Int bytesSize;
-		SharedExp ptrLoad;
+		ExpPtr ptrLoad;
 
 		ELoadBytesFromPtr(Int _bytesSize);
 
@@ -92,7 +101,8 @@ namespace Tolo
 	struct EDefineFunction : public Expression
 	{
 		std::string functionName;
-		std::vector<SharedExp> body;
+		std::vector<ExpPtr> body;
+		const CodeBuilder* p_code; // body built separately by a compile thread
 
 		EDefineFunction(const std::string& _functionName);
 
@@ -134,9 +144,9 @@ namespace Tolo
 
 	struct EWriteBytesTo : public Expression
 	{
-		SharedExp bytesSizeLoad;
-		SharedExp writePtrLoad;
-		SharedExp dataLoad;
+		ExpPtr bytesSizeLoad;
+		ExpPtr writePtrLoad;
+		ExpPtr dataLoad;
 
 		EWriteBytesTo();
 
@@ -147,8 +157,8 @@ namespace Tolo
 	{
 		Int paramsSize;
 		Int localsSize;
-		std::vector<SharedExp> argumentLoads;
-		SharedExp functionIpLoad;
+		std::vector<ExpPtr> argumentLoads;
+		ExpPtr functionIpLoad;
 
 		ECallFunction(Int _paramsSize, Int _localsSize);
 
@@ -157,8 +167,8 @@ namespace Tolo
 
 	struct ECallNativeFunction : public Expression
 	{
-		std::vector<SharedExp> argumentLoads;
-		SharedExp functionPtrLoad;
+		std::vector<ExpPtr> argumentLoads;
+		ExpPtr functionPtrLoad;
 
 		ECallNativeFunction();
 
@@ -168,8 +178,8 @@ namespace Tolo
 	struct EBinaryOp : public Expression
 	{
 		OpCode op;
-		SharedExp lhsLoad;
-		SharedExp rhsLoad;
+		ExpPtr lhsLoad;
+		ExpPtr rhsLoad;
 
 		EBinaryOp(OpCode _op);
 
@@ -179,16 +189,27 @@ namespace Tolo
 	struct EUnaryOp : public Expression
 	{
 		OpCode op;
-		SharedExp valLoad;
+		ExpPtr valLoad;
 
 		EUnaryOp(OpCode _op);
 
 		virtual void Evaluate(CodeBuilder& cb) override;
 	};
 
+	// marks the code of a statement with its line
+	struct EStatement : public Expression
+	{
+		Int line;
+		ExpPtr statement;
+
+		EStatement(Int _line, ExpPtr _statement);
+
+		virtual void Evaluate(CodeBuilder& cb) override;
+	};
+
 	struct EScope : public Expression
 	{
-		std::vector<SharedExp> statements;
+		std::vector<ExpPtr> statements;
 
 		EScope();
 
@@ -198,7 +219,7 @@ namespace Tolo
 	struct EReturn : public Expression
 	{
 		Int retValSize;
-		SharedExp retValLoad;
+		ExpPtr retValLoad;
 
 		EReturn(Int _retValSize);
 
@@ -207,7 +228,7 @@ namespace Tolo
 
 	struct EGoto : public Expression
 	{
-		SharedExp instrPtrLoad;
+		ExpPtr instrPtrLoad;
 
 		EGoto();
 
@@ -216,8 +237,8 @@ namespace Tolo
 
 	struct EIfSingle : public Expression
 	{
-		SharedExp conditionLoad;
-		std::vector<SharedExp> body;
+		ExpPtr conditionLoad;
+		std::vector<ExpPtr> body;
 
 		EIfSingle();
 
@@ -227,9 +248,9 @@ namespace Tolo
 
 	struct EIfChain : public Expression
 	{
-		SharedExp conditionLoad;
-		std::vector<SharedExp> body;
-		SharedExp chain;
+		ExpPtr conditionLoad;
+		std::vector<ExpPtr> body;
+		ExpPtr chain;
 
 		EIfChain();
 
@@ -238,8 +259,8 @@ namespace Tolo
 
 	struct EElseIfSingle : public Expression
 	{
-		SharedExp conditionLoad;
-		std::vector<SharedExp> body;
+		ExpPtr conditionLoad;
+		std::vector<ExpPtr> body;
 
 		EElseIfSingle();
 
@@ -248,9 +269,9 @@ namespace Tolo
 
 	struct EElseIfChain : public Expression
 	{
-		SharedExp conditionLoad;
-		std::vector<SharedExp> body;
-		SharedExp chain;
+		ExpPtr conditionLoad;
+		std::vector<ExpPtr> body;
+		ExpPtr chain;
 
 		EElseIfChain();
 
@@ -259,7 +280,7 @@ namespace Tolo
 
 	struct EElse : public Expression
 	{
-		std::vector<SharedExp> body;
+		std::vector<ExpPtr> body;
 
 		EElse();
 
@@ -268,8 +289,8 @@ namespace Tolo
 
 	struct EWhile : public Expression
 	{
-		SharedExp conditionLoad;
-		std::vector<SharedExp> body;
+		ExpPtr conditionLoad;
+		std::vector<ExpPtr> body;
 
 		EWhile();
 
@@ -305,7 +326,7 @@ namespace Tolo
 
 	struct ELoadMulti : public Expression
 	{
-		std::vector<SharedExp> loaders;
+		std::vector<ExpPtr> loaders;
 
 		ELoadMulti();
 
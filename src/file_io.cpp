@@ -3,8 +3,25 @@
 #include <fstream>
 #include <sstream>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace Tolo
 {
+	MappedFile::MappedFile() :
+		p_data(nullptr),
+		size(0),
+		p_fileHandle(nullptr),
+		p_mappingHandle(nullptr)
+	{}
+
 	void ReadTextFile(const std::string& filePath, std::string& outText)
 	{
 		std::ifstream file;
@@ -33,4 +50,89 @@ namespace Tolo
 		file.close();
 		return true;
 	}
+
+	void WriteBinaryFile(const std::string& path, const std::string& data)
+	{
+		std::ofstream file;
+		file.open(path, std::ios::binary);
+
+		Affirm(file.is_open(), "failed to open file '%s'", path.c_str());
+
+		file.write(data.data(), static_cast<std::streamsize>(data.size()));
+
+		file.close();
+	}
+
+	void MapFile(const std::string& filePath, MappedFile& outFile)
+	{
+#ifdef _WIN32
+		HANDLE fileHandle = CreateFileA(
+			filePath.c_str(), 
+			GENERIC_READ, 
+			FILE_SHARE_READ, 
+			nullptr, 
+			OPEN_EXISTING, 
+			FILE_ATTRIBUTE_NORMAL, 
+			nullptr
+		);
+
+		Affirm(fileHandle != INVALID_HANDLE_VALUE, "failed to open file '%s'", filePath.c_str());
+
+		LARGE_INTEGER fileSize;
+		GetFileSizeEx(fileHandle, &fileSize);
+
+		HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (mappingHandle == nullptr)
+		{
+			CloseHandle(fileHandle);
+			Affirm(false, "failed to map file '%s'", filePath.c_str());
+		}
+
+		outFile.p_data = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+		outFile.size = static_cast<size_t>(fileSize.QuadPart);
+		outFile.p_fileHandle = fileHandle;
+		outFile.p_mappingHandle = mappingHandle;
+
+		if (outFile.p_data == nullptr)
+		{
+			UnmapFile(outFile);
+			Affirm(false, "failed to map file '%s'", filePath.c_str());
+		}
+#else
+		int fd = open(filePath.c_str(), O_RDONLY);
+		Affirm(fd >= 0, "failed to open file '%s'", filePath.c_str());
+
+		struct stat fileStat;
+		if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+		{
+			close(fd);
+			Affirm(false, "failed to map file '%s'", filePath.c_str());
+		}
+
+		void* p_mapping = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+
+		Affirm(p_mapping != MAP_FAILED, "failed to map file '%s'", filePath.c_str());
+
+		outFile.p_data = static_cast<const char*>(p_mapping);
+		outFile.size = static_cast<size_t>(fileStat.st_size);
+#endif
+	}
+
+	void UnmapFile(MappedFile& file)
+	{
+#ifdef _WIN32
+		if (file.p_data != nullptr)
+			UnmapViewOfFile(file.p_data);
+		if (file.p_mappingHandle != nullptr)
+			CloseHandle(file.p_mappingHandle);
+		if (file.p_fileHandle != nullptr)
+			CloseHandle(file.p_fileHandle);
+#else
+		if (file.p_data != nullptr)
+			munmap(const_cast<char*>(file.p_data), file.size);
+#endif
+		file = MappedFile();
+	}
 }
\ No newline at end of file
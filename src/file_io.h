@@ -3,6 +3,20 @@
 
 namespace Tolo
 {
+	// read-only memory mapped view of a whole file
+	struct MappedFile
+	{
+		const char* p_data;
+		size_t size;
+		void* p_fileHandle;
+		void* p_mappingHandle;
+
+		MappedFile();
+	};
+
 	void ReadTextFile(const std::string& filePath, std::string& outText);
 	bool WriteTextFile(const std::string& path, const std::string& text, bool append);
+	void WriteBinaryFile(const std::string& path, const std::string& data);
+	void MapFile(const std::string& filePath, MappedFile& outFile);
+	void UnmapFile(MappedFile& file);
 }
\ No newline at end of file
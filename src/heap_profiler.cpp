@@ -0,0 +1,177 @@
+#include "heap_profiler.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace Tolo
+{
+	AllocationSite::AllocationSite() :
+		allocationCount(0),
+		allocatedBytes(0),
+		liveBlockCount(0),
+		liveBytes(0)
+	{}
+
+
+	HeapProfiler::HeapProfiler() :
+		p_stack(nullptr),
+		allocationCount(0),
+		freeCount(0),
+		allocatedBytes(0),
+		liveBytes(0),
+		peakBytes(0),
+		sizeHistogram{}
+	{}
+
+	void HeapProfiler::Reset(Ptr _p_stack)
+	{
+		*this = HeapProfiler();
+		p_stack = _p_stack;
+	}
+
+	void HeapProfiler::Allocate(const VirtualMachine& vm, Ptr p_data, Int size)
+	{
+		Int siteOffset = static_cast<Int>(vm.p_instructionPtr - p_stack);
+		uint64_t byteCount = static_cast<uint64_t>(size);
+
+		allocationCount++;
+		allocatedBytes += byteCount;
+		liveBytes += byteCount;
+		peakBytes = std::max(peakBytes, liveBytes);
+
+		size_t bucket = 0;
+
+		while (bucket + 1 < sizeHistogram.size() && (uint64_t(1) << bucket) < byteCount)
+			bucket++;
+
+		sizeHistogram[bucket]++;
+
+		AllocationSite& site = offsetToSite[siteOffset];
+		site.allocationCount++;
+		site.allocatedBytes += byteCount;
+		site.liveBlockCount++;
+		site.liveBytes += byteCount;
+
+		liveBlocks[p_data] = { size, siteOffset };
+	}
+
+	void HeapProfiler::Free(Ptr p_data)
+	{
+		auto blockIt = liveBlocks.find(p_data);
+
+		if (blockIt == liveBlocks.end())
+			return;
+
+		uint64_t byteCount = static_cast<uint64_t>(blockIt->second.size);
+
+		freeCount++;
+		liveBytes -= byteCount;
+
+		AllocationSite& site = offsetToSite[blockIt->second.siteOffset];
+		site.liveBlockCount--;
+		site.liveBytes -= byteCount;
+
+		liveBlocks.erase(blockIt);
+	}
+
+
+	AllocationSiteProfile::AllocationSiteProfile() :
+		codeOffset(0)
+	{}
+
+
+	HeapProfile::HeapProfile() :
+		allocationCount(0),
+		freeCount(0),
+		allocatedBytes(0),
+		liveBytes(0),
+		peakBytes(0),
+		liveBlockCount(0),
+		sizeHistogram{}
+	{}
+
+
+	template<typename... ARGS>
+	static void AppendFormat(std::string& outText, const char* format, ARGS... args)
+	{
+		char buffer[512];
+		std::snprintf(buffer, sizeof(buffer), format, args...);
+		outText += buffer;
+	}
+
+	static unsigned long long ToULL(uint64_t value)
+	{
+		return static_cast<unsigned long long>(value);
+	}
+
+	void WriteHeapProfileText(const HeapProfile& profile, size_t maxRows, std::string& outText)
+	{
+		outText.clear();
+
+		AppendFormat(
+			outText, "allocations: %llu, frees: %llu, allocated bytes: %llu, live bytes: %llu in %llu blocks, peak bytes: %llu\n",
+			ToULL(profile.allocationCount), ToULL(profile.freeCount), ToULL(profile.allocatedBytes),
+			ToULL(profile.liveBytes), ToULL(profile.liveBlockCount), ToULL(profile.peakBytes)
+		);
+
+		AppendFormat(outText, "\n%-14s %14s\n", "size up to", "allocations");
+
+		for (size_t i = 0; i < profile.sizeHistogram.size(); i++)
+		{
+			if (profile.sizeHistogram[i] != 0)
+				AppendFormat(outText, "%-14llu %14llu\n", 1ull << i, ToULL(profile.sizeHistogram[i]));
+		}
+
+		AppendFormat(
+			outText, "\n%-10s %-29s %12s %14s %10s %14s  %s\n",
+			"offset", "function", "allocations", "bytes", "live", "live bytes", "source"
+		);
+
+		for (size_t i = 0; i < profile.sites.size() && i < maxRows; i++)
+		{
+			const AllocationSiteProfile& site = profile.sites[i];
+
+			AppendFormat(
+				outText, "%-10i %-29s %12llu %14llu %10llu %14llu  %s\n",
+				site.codeOffset,
+				site.functionHash.c_str(),
+				ToULL(site.site.allocationCount),
+				ToULL(site.site.allocatedBytes),
+				ToULL(site.site.liveBlockCount),
+				ToULL(site.site.liveBytes),
+				site.sourceLine.c_str()
+			);
+		}
+	}
+
+	void WriteLeakReport(const HeapProfile& profile, std::string& outText)
+	{
+		outText.clear();
+
+		std::vector<const AllocationSiteProfile*> leakingSites;
+
+		for (const AllocationSiteProfile& site : profile.sites)
+		{
+			if (site.site.liveBlockCount != 0)
+				leakingSites.push_back(&site);
+		}
+
+		std::stable_sort(leakingSites.begin(), leakingSites.end(), [](const AllocationSiteProfile* p_lhs, const AllocationSiteProfile* p_rhs)
+		{
+			return p_lhs->site.liveBytes > p_rhs->site.liveBytes;
+		});
+
+		AppendFormat(outText, "%llu bytes in %llu blocks not freed\n", ToULL(profile.liveBytes), ToULL(profile.liveBlockCount));
+
+		for (const AllocationSiteProfile* p_site : leakingSites)
+		{
+			AppendFormat(
+				outText, "%14llu bytes in %8llu blocks allocated at %i in %s  %s\n",
+				ToULL(p_site->site.liveBytes),
+				ToULL(p_site->site.liveBlockCount),
+				p_site->codeOffset,
+				p_site->functionHash.c_str(),
+				p_site->sourceLine.c_str()
+			);
+		}
+	}
+}
\ No newline at end of file
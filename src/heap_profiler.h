@@ -0,0 +1,87 @@
+#pragma once
+#include "common.h"
+#include "virtual_machine.h"
+#include <string>
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <map>
+#include <cstdint>
+
+namespace Tolo
+{
+	// a block the script allocated and did not free yet
+	struct HeapBlock
+	{
+		Int size;
+		Int siteOffset;
+	};
+
+	// the allocations made at one call of 'malloc' in the code
+	struct AllocationSite
+	{
+		uint64_t allocationCount;
+		uint64_t allocatedBytes;
+		uint64_t liveBlockCount;
+		uint64_t liveBytes;
+
+		AllocationSite();
+	};
+
+	// accounting of the script heap, kept by the memory toolkit natives while the program is
+	// heap profiled
+	struct HeapProfiler
+	{
+		Ptr p_stack;
+		uint64_t allocationCount;
+		uint64_t freeCount;
+		uint64_t allocatedBytes;
+		uint64_t liveBytes;
+		uint64_t peakBytes;
+		std::array<uint64_t, 32> sizeHistogram; // allocations by the smallest power of 2 their size fits in
+		std::unordered_map<Ptr, HeapBlock> liveBlocks;
+		std::map<Int, AllocationSite> offsetToSite; // by the code offset of the native call
+
+		HeapProfiler();
+
+		void Reset(Ptr _p_stack);
+
+		// the ip of vm is still at the native call
+		void Allocate(const VirtualMachine& vm, Ptr p_data, Int size);
+
+		// blocks allocated before profiling started are not known and ignored
+		void Free(Ptr p_data);
+	};
+
+	struct AllocationSiteProfile
+	{
+		Int codeOffset;
+		std::string functionHash;
+		std::string sourceLine; // 'path:line', empty for code built from no line
+		AllocationSite site;
+
+		AllocationSiteProfile();
+	};
+
+	// counts of a heap profiler with its call sites resolved to functions and source lines,
+	// sorted by allocated bytes
+	struct HeapProfile
+	{
+		uint64_t allocationCount;
+		uint64_t freeCount;
+		uint64_t allocatedBytes;
+		uint64_t liveBytes;
+		uint64_t peakBytes;
+		uint64_t liveBlockCount;
+		std::array<uint64_t, 32> sizeHistogram;
+		std::vector<AllocationSiteProfile> sites;
+
+		HeapProfile();
+	};
+
+	// writes the totals, the size histogram and a table of at most maxRows call sites
+	void WriteHeapProfileText(const HeapProfile& profile, size_t maxRows, std::string& outText);
+
+	// one line per call site with blocks that were not freed, the most live bytes first
+	void WriteLeakReport(const HeapProfile& profile, std::string& outText);
+}
\ No newline at end of file
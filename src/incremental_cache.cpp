@@ -0,0 +1,286 @@
+#include "incremental_cache.h"
+#include "compile_cache.h"
+#include "tokenizer.h"
+#include "lexer.h"
+#include <algorithm>
+
+namespace Tolo
+{
+	IncrementalCache::CachedFunction::CachedFunction() :
+		calleesHash(0),
+		isBuilt(false)
+	{}
+
+	IncrementalCache::Chunk::Chunk() :
+		firstLine(1),
+		declarationsHash(0),
+		isUsed(false)
+	{}
+
+	IncrementalCache::IncrementalCache() :
+		declarationsHash(0),
+		lexedChunkCount(0),
+		lexedTokenCount(0),
+		lexedNodeCount(0),
+		builtFunctionCount(0),
+		reusedFunctionCount(0)
+	{}
+
+	uint64_t IncrementalCache::HashDeclarations(const Parser& parser)
+	{
+		// every function signature, as adding an overload can change which function a call picks
+		std::string declarations;
+
+		for (const auto& e : parser.hashToUserFunctions)
+			declarations += e.first + ";";
+
+		for (const auto& e : parser.hashToNativeFunctions)
+			declarations += e.first + "=" + std::to_string(reinterpret_cast<uintptr_t>(e.second.p_functionPtr)) + ";";
+
+		// struct layouts
+		std::vector<std::pair<std::string, SymbolId>> structNames;
+
+		for (const auto& e : parser.typeIdToStructInfo)
+			structNames.emplace_back(parser.GetTypeName(e.first), e.first);
+
+		std::sort(structNames.begin(), structNames.end());
+
+		for (const auto& e : structNames)
+		{
+			declarations += e.first + "{";
+
+			const StructInfo& structInfo = parser.typeIdToStructInfo.at(e.second);
+
+			for (SymbolId memberId : structInfo.memberIds)
+			{
+				const VariableInfo& memberInfo = structInfo.memberIdToVarInfo.at(memberId);
+				declarations += parser.GetTypeName(memberInfo.typeId) + " " + parser.p_symbols->GetName(memberId) + "@" + std::to_string(memberInfo.offset) + ";";
+			}
+
+			declarations += "}";
+		}
+
+		// enums
+		std::vector<std::pair<std::string, Int>> enumValues(parser.nameToEnumValue.begin(), parser.nameToEnumValue.end());
+		std::sort(enumValues.begin(), enumValues.end());
+
+		for (const auto& e : enumValues)
+			declarations += e.first + "=" + std::to_string(e.second) + ";";
+
+		// v-tables
+		for (const auto& vTablePair : parser.structNameToVTable)
+		{
+			declarations += vTablePair.first + "[";
+
+			for (const auto& e : vTablePair.second)
+				declarations += e.first + "=" + e.second.globalHash + "@" + std::to_string(e.second.vTableOffset) + ";";
+
+			declarations += "]";
+		}
+
+		return HashBytes(declarations.data(), declarations.size());
+	}
+
+	uint64_t IncrementalCache::HashCallees(const Parser& parser, const std::vector<std::string>& calleeHashes)
+	{
+		// calls embed the parameter and locals sizes of the called function
+		std::string sizes;
+
+		for (const std::string& hash : calleeHashes)
+		{
+			auto it = parser.hashToUserFunctions.find(hash);
+
+			if (it == parser.hashToUserFunctions.end())
+				continue;
+
+			sizes += std::to_string(it->second.parametersSize) + "," + std::to_string(it->second.localsSize) + ";";
+		}
+
+		return HashBytes(sizes.data(), sizes.size());
+	}
+
+	void IncrementalCache::MoveLines(LexNode* p_node, int lineDelta)
+	{
+		p_node->token.line += lineDelta;
+
+		for (LexNode* p_child : p_node->children)
+			MoveLines(p_child, lineDelta);
+	}
+
+	SymbolTable& IncrementalCache::GetSymbols()
+	{
+		return symbols;
+	}
+
+	void IncrementalCache::Lex(const std::string& code, const SourceMap& sourceMap, std::vector<LexNode*>& outLexNodes)
+	{
+		lexedChunkCount = 0;
+		lexedTokenCount = 0;
+		lexedNodeCount = 0;
+		builtFunctionCount = 0;
+		reusedFunctionCount = 0;
+		nodeToChunk.clear();
+
+		for (auto& e : hashToChunk)
+			e.second->isUsed = false;
+
+		const size_t lineCount = sourceMap.lineOffsets.size();
+
+		for (size_t line = 0; line < lineCount;)
+		{
+			// a chunk ends where the next file starts
+			size_t endLine = line + 1;
+
+			while (endLine < lineCount && sourceMap.lineLocations[endLine].fileIndex == sourceMap.lineLocations[line].fileIndex)
+				endLine++;
+
+			size_t start = sourceMap.lineOffsets[line];
+			size_t end = endLine < lineCount ? sourceMap.lineOffsets[endLine] : code.size();
+			int firstLine = static_cast<int>(line + 1);
+			uint64_t hash = HashBytes(code.data() + start, end - start);
+			auto it = hashToChunk.find(hash);
+
+			if (it == hashToChunk.end())
+			{
+				auto p_chunk = std::make_unique<Chunk>();
+				p_chunk->firstLine = firstLine;
+
+				std::string chunkCode = code.substr(start, end - start);
+				TokenStream tokenStream(chunkCode, symbols, firstLine);
+
+				Lexer lexer(p_chunk->arena);
+				lexer.Lex(tokenStream, p_chunk->lexNodes);
+				lexedTokenCount += tokenStream.GetReadTokenCount();
+				lexedNodeCount += p_chunk->arena.GetAllocationCount();
+
+				it = hashToChunk.emplace(hash, std::move(p_chunk)).first;
+				lexedChunkCount++;
+			}
+
+			Chunk& chunk = *it->second;
+
+			// the same code moved up or down
+			if (chunk.firstLine != firstLine)
+			{
+				for (LexNode* p_node : chunk.lexNodes)
+					MoveLines(p_node, firstLine - chunk.firstLine);
+
+				for (auto& e : chunk.hashToFunction)
+				{
+					for (CodeLine& codeLine : e.second.code.codeLines)
+					{
+						if (codeLine.line > 0)
+							codeLine.line += firstLine - chunk.firstLine;
+					}
+				}
+
+				chunk.firstLine = firstLine;
+			}
+
+			chunk.isUsed = true;
+
+			for (LexNode* p_node : chunk.lexNodes)
+			{
+				outLexNodes.push_back(p_node);
+				nodeToChunk[p_node] = &chunk;
+			}
+
+			line = endLine;
+		}
+	}
+
+	void IncrementalCache::SetDeclarations(const Parser& parser)
+	{
+		declarationsHash = HashDeclarations(parser);
+	}
+
+	const CodeBuilder* IncrementalCache::FindFunctionCode(const Parser& parser, const PendingFunctionBody& body)
+	{
+		Chunk& chunk = *nodeToChunk.at(body.p_lexNode);
+
+		if (chunk.declarationsHash != declarationsHash)
+		{
+			chunk.hashToFunction.clear();
+			chunk.declarationsHash = declarationsHash;
+			return nullptr;
+		}
+
+		auto it = chunk.hashToFunction.find(body.funcHash);
+
+		if (it == chunk.hashToFunction.end() || 
+			!it->second.isBuilt || 
+			it->second.calleesHash != HashCallees(parser, it->second.calleeHashes))
+		{
+			return nullptr;
+		}
+
+		reusedFunctionCount++;
+
+		return &it->second.code;
+	}
+
+	CodeBuilder& IncrementalCache::AddFunctionCode(const PendingFunctionBody& body)
+	{
+		Chunk& chunk = *nodeToChunk.at(body.p_lexNode);
+		chunk.hashToFunction.erase(body.funcHash);
+		builtFunctionCount++;
+
+		return chunk.hashToFunction[body.funcHash].code;
+	}
+
+	void IncrementalCache::SetFunctionCallees(const Parser& parser, const PendingFunctionBody& body, const std::set<std::string>& calleeHashes)
+	{
+		CachedFunction& function = nodeToChunk.at(body.p_lexNode)->hashToFunction.at(body.funcHash);
+		function.calleeHashes.assign(calleeHashes.begin(), calleeHashes.end());
+		function.calleesHash = HashCallees(parser, function.calleeHashes);
+		function.isBuilt = true;
+	}
+
+	void IncrementalCache::RemoveFunctionCode(const PendingFunctionBody& body)
+	{
+		nodeToChunk.at(body.p_lexNode)->hashToFunction.erase(body.funcHash);
+	}
+
+	void IncrementalCache::RemoveUnusedChunks()
+	{
+		for (auto it = hashToChunk.begin(); it != hashToChunk.end();)
+		{
+			if (it->second->isUsed)
+				++it;
+			else
+				it = hashToChunk.erase(it);
+		}
+	}
+
+	void IncrementalCache::Clear()
+	{
+		nodeToChunk.clear();
+		hashToChunk.clear();
+		declarationsHash = 0;
+	}
+
+	size_t IncrementalCache::GetLexedChunkCount() const
+	{
+		return lexedChunkCount;
+	}
+
+	size_t IncrementalCache::GetLexedTokenCount() const
+	{
+		return lexedTokenCount;
+	}
+
+	size_t IncrementalCache::GetLexedNodeCount() const
+	{
+		return lexedNodeCount;
+	}
+
+	size_t IncrementalCache::GetBuiltFunctionCount() const
+	{
+		return builtFunctionCount;
+	}
+
+	size_t IncrementalCache::GetReusedFunctionCount() const
+	{
+		return reusedFunctionCount;
+	}
+}
\ No newline at end of file
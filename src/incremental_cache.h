@@ -0,0 +1,100 @@
+#pragma once
+#include "parser.h"
+#include "preprocessor.h"
+#include "code_builder.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+
+namespace Tolo
+{
+	// keeps the lexed code and the built functions of earlier compiles of a program, so compiling
+	// it again after an edit only lexes the changed files and rebuilds the functions they affect,
+	// can be handed to a new program handle for every reload but not used by two at once
+	class IncrementalCache
+	{
+	private:
+		struct CachedFunction
+		{
+			CodeBuilder code;
+			std::vector<std::string> calleeHashes;
+			uint64_t calleesHash;
+			bool isBuilt;
+
+			CachedFunction();
+		};
+
+		// a run of lines from one file, the code between two includes
+		struct Chunk
+		{
+			Arena arena; // owns the lex nodes
+			std::vector<LexNode*> lexNodes;
+			int firstLine;
+			uint64_t declarationsHash; // the functions are only valid for these declarations
+			std::unordered_map<std::string, CachedFunction> hashToFunction;
+			bool isUsed;
+
+			Chunk();
+		};
+
+		SymbolTable symbols; // the lex nodes of all chunks refer to it
+		std::unordered_map<uint64_t, std::unique_ptr<Chunk>> hashToChunk;
+		std::unordered_map<const LexNode*, Chunk*> nodeToChunk;
+		uint64_t declarationsHash;
+		size_t lexedChunkCount;
+		size_t lexedTokenCount;
+		size_t lexedNodeCount;
+		size_t builtFunctionCount;
+		size_t reusedFunctionCount;
+
+		static uint64_t HashDeclarations(const Parser& parser);
+
+		static uint64_t HashCallees(const Parser& parser, const std::vector<std::string>& calleeHashes);
+
+		static void MoveLines(LexNode* p_node, int lineDelta);
+
+	public:
+		IncrementalCache();
+
+		SymbolTable& GetSymbols();
+
+		// outputs the lex nodes of the preprocessed code, only the chunks not seen in the last
+		// compile are lexed again
+		void Lex(const std::string& code, const SourceMap& sourceMap, std::vector<LexNode*>& outLexNodes);
+
+		// has to be called once all declarations are parsed, before looking up functions
+		void SetDeclarations(const Parser& parser);
+
+		// returns nullptr if the function has to be built because its code, or a function it 
+		// calls, changed
+		const CodeBuilder* FindFunctionCode(const Parser& parser, const PendingFunctionBody& body);
+
+		// returns a fresh code builder to build the function into
+		CodeBuilder& AddFunctionCode(const PendingFunctionBody& body);
+
+		// stores the functions called by a built function, its code is reused while they keep 
+		// their sizes
+		void SetFunctionCallees(const Parser& parser, const PendingFunctionBody& body, const std::set<std::string>& calleeHashes);
+
+		// forgets the code of a function, so the next compile builds it again
+		void RemoveFunctionCode(const PendingFunctionBody& body);
+
+		// drops the chunks that were not part of the last compile
+		void RemoveUnusedChunks();
+
+		void Clear();
+
+		// counts of the last compile
+		size_t GetLexedChunkCount() const;
+
+		size_t GetLexedTokenCount() const;
+
+		size_t GetLexedNodeCount() const;
+
+		size_t GetBuiltFunctionCount() const;
+
+		size_t GetReusedFunctionCount() const;
+	};
+}
\ No newline at end of file
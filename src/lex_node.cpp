@@ -1,7 +1,16 @@
 #include "lex_node.h"
+#include "tokenizer.h"
 
 namespace Tolo
 {
+	LexToken::LexToken(const Token& _token) :
+		type(_token.type),
+		line(_token.line),
+		symbol(_token.symbol)
+	{
+		DecodeTokenText(_token, text);
+	}
+
 	LexNode::LexNode(Type _type, const Token& _token) :
 		type(_type),
 		token(_token)
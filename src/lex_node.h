@@ -1,10 +1,21 @@
 #pragma once
 #include "token.h"
+#include <string>
 #include <vector>
-#include <memory>
 
 namespace Tolo
 {
+	// token owning its text, with the escapes of char and string literals decoded
+	struct LexToken
+	{
+		Token::Type type;
+		std::string text;
+		int line;
+		SymbolId symbol;
+
+		LexToken(const Token& _token);
+	};
+
 	struct LexNode
 	{
 		enum class Type
@@ -46,8 +57,8 @@ namespace Tolo
 		};
 
 		Type type;
-		Token token;
-		std::vector<std::shared_ptr<LexNode>> children;
+		LexToken token;
+		std::vector<LexNode*> children;
 
 		LexNode(Type _type, const Token& _token);
 	};
@@ -3,16 +3,21 @@
 
 namespace Tolo
 {
-	Lexer::Lexer() :
-		p_tokens(nullptr),
-		tokenIndex(0),
+	Lexer::Lexer(Arena& _arena) :
+		p_arena(&_arena),
+		p_tokenStream(nullptr),
 		isInsideWhile(false)
 	{}
 
+	bool Lexer::HasTokensLeft()
+	{
+		return p_tokenStream->Peek() != nullptr;
+	}
+
 	void Lexer::AffirmTokensLeft()
 	{
 		Affirm(
-			tokenIndex < p_tokens->size(),
+			HasTokensLeft(),
 			"unexpected end of tokens"
 		);
 	}
@@ -23,29 +28,29 @@ namespace Tolo
 
 		Affirm(
 			token.type == affirmType,
-			"unexpected '%s' at line %i",
-			token.text.c_str(), token.line
+			"unexpected '%.*s' at line %i",
+			static_cast<int>(token.text.size()), token.text.data(), token.line
 		);
 
-		tokenIndex++;
+		p_tokenStream->Advance();
 	}
 
 	void Lexer::ConsumeNextToken(Token::Type affirmType)
 	{
-		tokenIndex++;
+		p_tokenStream->Advance();
 		ConsumeCurrentToken(affirmType);
 	}
 
 	const Token& Lexer::NextToken(Token::Type affirmType)
 	{
-		tokenIndex++;
+		p_tokenStream->Advance();
 		AffirmTokensLeft();
 
 		const Token& token = CurrentToken();
 		Affirm(
 			token.type == affirmType,
-			"unexpected token '%s' at line %i",
-			token.text.c_str(), token.line
+			"unexpected token '%.*s' at line %i",
+			static_cast<int>(token.text.size()), token.text.data(), token.line
 		);
 
 		return token;
@@ -53,30 +58,32 @@ namespace Tolo
 
 	bool Lexer::TryCompareCurrentToken(Token::Type compareType)
 	{
-		return tokenIndex < p_tokens->size() && p_tokens->at(tokenIndex).type == compareType;
+		const Token* p_token = p_tokenStream->Peek();
+		return p_token != nullptr && p_token->type == compareType;
 	}
 
 	bool Lexer::TryCompareNextToken(Token::Type compareType)
 	{
-		return tokenIndex + 1 < p_tokens->size() && p_tokens->at(tokenIndex + 1).type == compareType;
+		const Token* p_token = p_tokenStream->Peek(1);
+		return p_token != nullptr && p_token->type == compareType;
 	}
 
 	const Token& Lexer::CurrentToken()
 	{
 		AffirmTokensLeft();
-		return p_tokens->at(tokenIndex);
+		return *p_tokenStream->Peek();
 	}
 
 	const Token& Lexer::CurrentToken(Token::Type affirmType)
 	{
 		AffirmTokensLeft();
 
-		const Token& token = p_tokens->at(tokenIndex);
+		const Token& token = *p_tokenStream->Peek();
 
 		Affirm(
 			token.type == affirmType,
-			"unexpected '%s' at line %i",
-			token.text.c_str(), token.line
+			"unexpected '%.*s' at line %i",
+			static_cast<int>(token.text.size()), token.text.data(), token.line
 		);
 
 		return token;
@@ -131,17 +138,20 @@ namespace Tolo
 	}
 
 
-	void Lexer::Lex(const std::vector<Token>& tokens, std::vector<SharedNode>& lexNodes)
+	void Lexer::Lex(TokenStream& tokenStream, std::vector<NodePtr>& lexNodes)
 	{
-		p_tokens = &tokens;
-		tokenIndex = 0;
+		p_tokenStream = &tokenStream;
 
-		while (tokenIndex < p_tokens->size())
+		// lex nodes own their text, so the tokens of a global structure are freed once it is lexed
+		while (HasTokensLeft())
+		{
 			lexNodes.push_back(LGlobalStructure());
+			p_tokenStream->ReleaseConsumedTokens();
+		}
 	}
 
 
-	Lexer::SharedNode Lexer::LGlobalStructure() 
+	Lexer::NodePtr Lexer::LGlobalStructure() 
 	{
 		const Token& idToken = CurrentToken(Token::Type::Name);
 
@@ -157,13 +167,14 @@ namespace Tolo
 			idToken.line
 		);
 
-		const Token& nameToken = p_tokens->at(tokenIndex + 1);
+		const Token& nameToken = *p_tokenStream->Peek(1);
 
 		if (nameToken.text == "operator")
 			return LOperatorDefinition();
 		
-		if (tokenIndex + 2 < p_tokens->size() &&
-			p_tokens->at(tokenIndex + 2).type == Token::Type::DoubleColon)
+		const Token* p_afterNameToken = p_tokenStream->Peek(2);
+
+		if (p_afterNameToken != nullptr && p_afterNameToken->type == Token::Type::DoubleColon)
 		{
 			return LMemberFunctionDefinition();
 		}
@@ -171,19 +182,19 @@ namespace Tolo
 		return LFunctionDefinition();
 	}
 
-	Lexer::SharedNode Lexer::LStructDefinition()
+	Lexer::NodePtr Lexer::LStructDefinition()
 	{
 		ConsumeCurrentToken(Token::Type::Name);
 
 		const Token& nameToken = CurrentToken(Token::Type::Name);
-		auto structDefNode = std::make_shared<LexNode>(LexNode::Type::StructDefinition, nameToken);
+		auto structDefNode = p_arena->New<LexNode>(LexNode::Type::StructDefinition, nameToken);
 
 		// handle inheritance
 		if (TryCompareNextToken(Token::Type::Colon))
 		{
 			ConsumeNextToken(Token::Type::Colon);
 			structDefNode->type = LexNode::Type::StructDefinitionInheritance;
-			structDefNode->children.push_back(std::make_shared<LexNode>(
+			structDefNode->children.push_back(p_arena->New<LexNode>(
 				LexNode::Type::Identifier, 
 				CurrentToken(Token::Type::Name
 			)));
@@ -205,25 +216,25 @@ namespace Tolo
 
 			ConsumeNextToken(Token::Type::Semicolon);
 
-			structDefNode->children.push_back(std::make_shared<LexNode>(LexNode::Type::Identifier, membNameToken));
+			structDefNode->children.push_back(p_arena->New<LexNode>(LexNode::Type::Identifier, membNameToken));
 		}
 
 		return structDefNode;
 	}
 
-	Lexer::SharedNode Lexer::LFunctionDefinition() 
+	Lexer::NodePtr Lexer::LFunctionDefinition() 
 	{
 		auto funcDefNode = LIdentifier();
 		funcDefNode->type = LexNode::Type::FunctionDefinition;
 
 		const Token& nameToken = CurrentToken(Token::Type::Name);
-		funcDefNode->children.push_back(std::make_shared<LexNode>(LexNode::Type::Identifier, nameToken));
+		funcDefNode->children.push_back(p_arena->New<LexNode>(LexNode::Type::Identifier, nameToken));
 
 		ConsumeNextToken(Token::Type::StartPar);
 
 		if (CurrentToken().type == Token::Type::EndPar)
 		{
-			tokenIndex++;
+			p_tokenStream->Advance();
 		}
 		else
 		{
@@ -231,11 +242,11 @@ namespace Tolo
 			{
 				funcDefNode->children.push_back(LIdentifier());
 				const Token& argNameToken = CurrentToken(Token::Type::Name);
-				funcDefNode->children.push_back(std::make_shared<LexNode>(LexNode::Type::Identifier, argNameToken));
+				funcDefNode->children.push_back(p_arena->New<LexNode>(LexNode::Type::Identifier, argNameToken));
 
 				if (TryCompareNextToken(Token::Type::EndPar))
 				{
-					tokenIndex += 2;
+					p_tokenStream->Advance(2);
 					break;
 				}
 
@@ -248,7 +259,7 @@ namespace Tolo
 		return funcDefNode;
 	}
 
-	Lexer::SharedNode Lexer::LOperatorDefinition() 
+	Lexer::NodePtr Lexer::LOperatorDefinition() 
 	{
 		auto opDefNode = LIdentifier();
 		opDefNode->type = LexNode::Type::OperatorDefinition;
@@ -256,7 +267,7 @@ namespace Tolo
 		ConsumeCurrentToken(Token::Type::Name);
 
 		const Token& opToken = CurrentToken();
-		opDefNode->children.push_back(std::make_shared<LexNode>(LexNode::Type::Identifier, opToken));
+		opDefNode->children.push_back(p_arena->New<LexNode>(LexNode::Type::Identifier, opToken));
 
 		switch (opToken.type)
 		{
@@ -272,7 +283,7 @@ namespace Tolo
 		case Token::Type::ExclamationMarkEqualSign:
 			break;
 		default:
-			Affirm(false, "unexpected token '%s' at line %i", opToken.text.c_str(), opToken.line);
+			Affirm(false, "unexpected token '%.*s' at line %i", static_cast<int>(opToken.text.size()), opToken.text.data(), opToken.line);
 			break;
 		}
 
@@ -280,7 +291,7 @@ namespace Tolo
 
 		if (CurrentToken().type == Token::Type::EndPar)
 		{
-			tokenIndex++;
+			p_tokenStream->Advance();
 		}
 		else
 		{
@@ -288,11 +299,11 @@ namespace Tolo
 			{
 				opDefNode->children.push_back(LIdentifier());
 				const Token& argNameToken = CurrentToken(Token::Type::Name);
-				opDefNode->children.push_back(std::make_shared<LexNode>(LexNode::Type::Identifier, argNameToken));
+				opDefNode->children.push_back(p_arena->New<LexNode>(LexNode::Type::Identifier, argNameToken));
 
 				if (TryCompareNextToken(Token::Type::EndPar))
 				{
-					tokenIndex += 2;
+					p_tokenStream->Advance(2);
 					break;
 				}
 
@@ -305,7 +316,7 @@ namespace Tolo
 		return opDefNode;
 	}
 
-	Lexer::SharedNode Lexer::LMemberFunctionDefinition()
+	Lexer::NodePtr Lexer::LMemberFunctionDefinition()
 	{
 		auto membFuncDefNode = LIdentifier();
 		membFuncDefNode->type = LexNode::Type::MemberFunctionDefinition;
@@ -315,12 +326,12 @@ namespace Tolo
 		const Token& funcNameToken = CurrentToken(Token::Type::Name);
 		ConsumeNextToken(Token::Type::StartPar);
 
-		membFuncDefNode->children.push_back(std::make_shared<LexNode>(LexNode::Type::Identifier, structTypeToken));
-		membFuncDefNode->children.push_back(std::make_shared<LexNode>(LexNode::Type::Identifier, funcNameToken));
+		membFuncDefNode->children.push_back(p_arena->New<LexNode>(LexNode::Type::Identifier, structTypeToken));
+		membFuncDefNode->children.push_back(p_arena->New<LexNode>(LexNode::Type::Identifier, funcNameToken));
 
 		if (CurrentToken().type == Token::Type::EndPar)
 		{
-			tokenIndex++;
+			p_tokenStream->Advance();
 		}
 		else
 		{
@@ -329,11 +340,11 @@ namespace Tolo
 				membFuncDefNode->children.push_back(LIdentifier());
 				const Token& argNameToken = CurrentToken(Token::Type::Name);
 
-				membFuncDefNode->children.push_back(std::make_shared<LexNode>(LexNode::Type::Identifier, argNameToken));
+				membFuncDefNode->children.push_back(p_arena->New<LexNode>(LexNode::Type::Identifier, argNameToken));
 
 				if (TryCompareNextToken(Token::Type::EndPar))
 				{
-					tokenIndex += 2;
+					p_tokenStream->Advance(2);
 					break;
 				}
 
@@ -345,12 +356,12 @@ namespace Tolo
 		if (CurrentToken().type == Token::Type::Colon)
 		{
 			const Token& specToken = NextToken(Token::Type::Name);
-			tokenIndex++;
+			p_tokenStream->Advance();
 
 			Affirm(
 				specToken.text == "virtual",
-				"unexpected token '%s' at line %i",
-				specToken.text.c_str(), specToken.line
+				"unexpected token '%.*s' at line %i",
+				static_cast<int>(specToken.text.size()), specToken.text.data(), specToken.line
 			);
 
 			membFuncDefNode->type = LexNode::Type::MemberFunctionDefinitionVirtual;
@@ -361,14 +372,14 @@ namespace Tolo
 		return membFuncDefNode;
 	}
 
-	Lexer::SharedNode Lexer::LEnumDefinition()
+	Lexer::NodePtr Lexer::LEnumDefinition()
 	{
 		ConsumeCurrentToken(Token::Type::Name);
 		const Token& enumNamespaceToken = CurrentToken(Token::Type::Name);
 
 		ConsumeNextToken(Token::Type::StartCurly);
 
-		auto enumDefNode = std::make_shared<LexNode>(LexNode::Type::EnumDefinition, enumNamespaceToken);
+		auto enumDefNode = p_arena->New<LexNode>(LexNode::Type::EnumDefinition, enumNamespaceToken);
 
 		bool first = true;
 
@@ -384,15 +395,15 @@ namespace Tolo
 				ConsumeCurrentToken(Token::Type::Comma);
 
 			const Token& nameToken = CurrentToken(Token::Type::Name);
-			enumDefNode->children.push_back(std::make_shared<LexNode>(LexNode::Type::Identifier, nameToken));
-			tokenIndex++;
+			enumDefNode->children.push_back(p_arena->New<LexNode>(LexNode::Type::Identifier, nameToken));
+			p_tokenStream->Advance();
 			first = false;
 		}
 
 		return enumDefNode;
 	}
 
-	Lexer::SharedNode Lexer::LStatement() 
+	Lexer::NodePtr Lexer::LStatement() 
 	{
 		const Token& token = CurrentToken();
 
@@ -419,18 +430,18 @@ namespace Tolo
 		return statNode;
 	}
 
-	Lexer::SharedNode Lexer::LScope()
+	Lexer::NodePtr Lexer::LScope()
 	{
 		const Token& scopeToken = CurrentToken();
-		tokenIndex++;
+		p_tokenStream->Advance();
 
-		auto scopeNode = std::make_shared<LexNode>(LexNode::Type::Scope, scopeToken);
+		auto scopeNode = p_arena->New<LexNode>(LexNode::Type::Scope, scopeToken);
 
 		while (true)
 		{
 			if (CurrentToken().type == Token::Type::EndCurly)
 			{
-				tokenIndex++;
+				p_tokenStream->Advance();
 				break;
 			}
 
@@ -440,28 +451,28 @@ namespace Tolo
 		return scopeNode;
 	}
 
-	Lexer::SharedNode Lexer::LIfStatement() 
+	Lexer::NodePtr Lexer::LIfStatement() 
 	{
 		const Token& ifToken = CurrentToken();
 
 		ConsumeNextToken(Token::Type::StartPar);
 
-		auto ifNode = std::make_shared<LexNode>(LexNode::Type::IfSingle, ifToken);
+		auto ifNode = p_arena->New<LexNode>(LexNode::Type::IfSingle, ifToken);
 		ifNode->children.push_back(LExpression(0));
 
 		ConsumeCurrentToken(Token::Type::EndPar);
 
 		ifNode->children.push_back(LStatement());
 
-		if (tokenIndex < p_tokens->size())
+		if (HasTokensLeft())
 		{
 			const Token& elseToken = CurrentToken();
 
 			if (elseToken.type == Token::Type::Name && elseToken.text == "else")
 			{
-				if (TryCompareNextToken(Token::Type::Name) && p_tokens->at(tokenIndex + 1).text == "if")
+				if (TryCompareNextToken(Token::Type::Name) && p_tokenStream->Peek(1)->text == "if")
 				{
-					tokenIndex++;
+					p_tokenStream->Advance();
 					auto elseIfNode = LIfStatement();
 					
 					if (elseIfNode->type == LexNode::Type::IfChain)
@@ -481,24 +492,24 @@ namespace Tolo
 		return ifNode;
 	}
 
-	Lexer::SharedNode Lexer::LElseStatement()
+	Lexer::NodePtr Lexer::LElseStatement()
 	{
 		const Token& elseToken = CurrentToken();
-		tokenIndex++;
+		p_tokenStream->Advance();
 
-		auto elseNode = std::make_shared<LexNode>(LexNode::Type::Else, elseToken);
+		auto elseNode = p_arena->New<LexNode>(LexNode::Type::Else, elseToken);
 		elseNode->children.push_back(LStatement());
 
 		return elseNode;
 	}
 
-	Lexer::SharedNode Lexer::LWhileStatement() 
+	Lexer::NodePtr Lexer::LWhileStatement() 
 	{
 		const Token& whileToken = CurrentToken();
 
 		ConsumeNextToken(Token::Type::StartPar);
 
-		auto whileNode = std::make_shared<LexNode>(LexNode::Type::While, whileToken);
+		auto whileNode = p_arena->New<LexNode>(LexNode::Type::While, whileToken);
 		whileNode->children.push_back(LExpression(0));
 
 		ConsumeCurrentToken(Token::Type::EndPar);
@@ -511,16 +522,16 @@ namespace Tolo
 		return whileNode;
 	}
 
-	Lexer::SharedNode Lexer::LBreakStatement() 
+	Lexer::NodePtr Lexer::LBreakStatement() 
 	{
 		Affirm(isInsideWhile, "cannot use 'break' outside while-loop at line %i", CurrentToken().line);
 
-		auto breakNode = std::make_shared<LexNode>(LexNode::Type::Break, CurrentToken());
+		auto breakNode = p_arena->New<LexNode>(LexNode::Type::Break, CurrentToken());
 		
 		if (TryCompareNextToken(Token::Type::ConstInt))
 		{
 			const Token& numToken = NextToken(Token::Type::ConstInt);
-			breakNode->children.push_back(std::make_shared<LexNode>(LexNode::Type::LiteralConstant, numToken));
+			breakNode->children.push_back(p_arena->New<LexNode>(LexNode::Type::LiteralConstant, numToken));
 		}
 
 		ConsumeNextToken(Token::Type::Semicolon);
@@ -528,16 +539,16 @@ namespace Tolo
 		return breakNode;
 	}
 
-	Lexer::SharedNode Lexer::LContinueStatement() 
+	Lexer::NodePtr Lexer::LContinueStatement() 
 	{
 		Affirm(isInsideWhile, "cannot use 'continue' outside while-loop at line %i", CurrentToken().line);
 
-		auto continueNode = std::make_shared<LexNode>(LexNode::Type::Continue, CurrentToken());
+		auto continueNode = p_arena->New<LexNode>(LexNode::Type::Continue, CurrentToken());
 	
 		if (TryCompareNextToken(Token::Type::ConstInt))
 		{
 			const Token& numToken = NextToken(Token::Type::ConstInt);
-			continueNode->children.push_back(std::make_shared<LexNode>(LexNode::Type::LiteralConstant, numToken));
+			continueNode->children.push_back(p_arena->New<LexNode>(LexNode::Type::LiteralConstant, numToken));
 		}
 
 		ConsumeNextToken(Token::Type::Semicolon);
@@ -545,10 +556,10 @@ namespace Tolo
 		return continueNode;
 	}
 
-	Lexer::SharedNode Lexer::LReturnStatement() 
+	Lexer::NodePtr Lexer::LReturnStatement() 
 	{
-		auto returnNode = std::make_shared<LexNode>(LexNode::Type::Return, CurrentToken());
-		tokenIndex++;
+		auto returnNode = p_arena->New<LexNode>(LexNode::Type::Return, CurrentToken());
+		p_tokenStream->Advance();
 
 		returnNode->children.push_back(LExpression(0));
 		ConsumeCurrentToken(Token::Type::Semicolon);
@@ -556,20 +567,20 @@ namespace Tolo
 		return returnNode;
 	}
 
-	Lexer::SharedNode Lexer::LExpression(int precedence)
+	Lexer::NodePtr Lexer::LExpression(int precedence)
 	{
-		SharedNode lhsNode = LPrefix();
+		NodePtr lhsNode = LPrefix();
 
-		while (tokenIndex < p_tokens->size() && precedence < BinaryOpPrecedence(CurrentToken().type))
+		while (HasTokensLeft() && precedence < BinaryOpPrecedence(CurrentToken().type))
 		{
-			SharedNode newLhs = LInfix(lhsNode);
+			NodePtr newLhs = LInfix(lhsNode);
 			lhsNode = newLhs;
 		}
 
 		return lhsNode;
 	}
 
-	Lexer::SharedNode Lexer::LPrefix()
+	Lexer::NodePtr Lexer::LPrefix()
 	{
 		const Token& token = CurrentToken();
 
@@ -607,21 +618,21 @@ namespace Tolo
 		}
 	}
 
-	Lexer::SharedNode Lexer::LInfix(const SharedNode& lhsNode)
+	Lexer::NodePtr Lexer::LInfix(NodePtr lhsNode)
 	{
 		const Token& lhsToken = CurrentToken();
 		int precedence = BinaryOpPrecedence(lhsToken.type);
 
-		auto binOpNode = std::make_shared<LexNode>(LexNode::Type::BinaryOperation, lhsToken);
+		auto binOpNode = p_arena->New<LexNode>(LexNode::Type::BinaryOperation, lhsToken);
 		binOpNode->children.push_back(lhsNode);
 
-		tokenIndex++;
+		p_tokenStream->Advance();
 		binOpNode->children.push_back(LExpression(precedence));
 
 		return binOpNode;
 	}
 
-	Lexer::SharedNode Lexer::LNameWithDoubleColon()
+	Lexer::NodePtr Lexer::LNameWithDoubleColon()
 	{
 		auto idNode = LIdentifier();
 
@@ -635,11 +646,11 @@ namespace Tolo
 		else if (token.type == Token::Type::StartPar)
 		{
 			idNode->type = LexNode::Type::FunctionCall;
-			tokenIndex++;
+			p_tokenStream->Advance();
 
 			if (CurrentToken().type == Token::Type::EndPar)
 			{
-				tokenIndex++;
+				p_tokenStream->Advance();
 			}
 			else
 			{
@@ -649,7 +660,7 @@ namespace Tolo
 
 					if (CurrentToken().type == Token::Type::EndPar)
 					{
-						tokenIndex++;
+						p_tokenStream->Advance();
 						break;
 					}
 
@@ -661,37 +672,38 @@ namespace Tolo
 		return idNode;
 	}
 
-	Lexer::SharedNode Lexer::LVariableDefinition()
+	Lexer::NodePtr Lexer::LVariableDefinition()
 	{
-		auto varDefNode = std::make_shared<LexNode>(LexNode::Type::VariableDefinition, CurrentToken());
+		auto varDefNode = p_arena->New<LexNode>(LexNode::Type::VariableDefinition, CurrentToken());
 		
 		const Token& varNameToken = NextToken(Token::Type::Name);
-		tokenIndex++;
+		p_tokenStream->Advance();
 
-		varDefNode->children.push_back(std::make_shared<LexNode>(LexNode::Type::Identifier, varNameToken));
+		varDefNode->children.push_back(p_arena->New<LexNode>(LexNode::Type::Identifier, varNameToken));
 
 		return varDefNode;
 	}
 
-	Lexer::SharedNode Lexer::LIdentifier() 
+	Lexer::NodePtr Lexer::LIdentifier() 
 	{
-		auto idNode = std::make_shared<LexNode>(LexNode::Type::Identifier, CurrentToken());
+		auto idNode = p_arena->New<LexNode>(LexNode::Type::Identifier, CurrentToken());
 
 		if (TryCompareNextToken(Token::Type::DoubleColon))
 		{
 			idNode->token.text += NextToken(Token::Type::DoubleColon).text;
 			idNode->token.text += NextToken(Token::Type::Name).text;
+			idNode->token.symbol = INVALID_SYMBOL;
 		}
 
-		tokenIndex++;
+		p_tokenStream->Advance();
 
 		return idNode;
 	}
 
-	Lexer::SharedNode Lexer::LMemberAccess()
+	Lexer::NodePtr Lexer::LMemberAccess()
 	{
-		auto membAccessNode = std::make_shared<LexNode>(LexNode::Type::MemberVariableAccess, CurrentToken());
-		tokenIndex++;
+		auto membAccessNode = p_arena->New<LexNode>(LexNode::Type::MemberVariableAccess, CurrentToken());
+		p_tokenStream->Advance();
 
 		while (true)
 		{
@@ -708,37 +720,37 @@ namespace Tolo
 				break;
 			}
 
-			membAccessNode->children.push_back(std::make_shared<LexNode>(LexNode::Type::Identifier, nameToken));
-			tokenIndex++;
+			membAccessNode->children.push_back(p_arena->New<LexNode>(LexNode::Type::Identifier, nameToken));
+			p_tokenStream->Advance();
 		}
 
 		return membAccessNode;
 	}
 
-	Lexer::SharedNode Lexer::LLiteral() 
+	Lexer::NodePtr Lexer::LLiteral() 
 	{
-		auto litNode = std::make_shared<LexNode>(LexNode::Type::LiteralConstant, CurrentToken());
-		tokenIndex++;
+		auto litNode = p_arena->New<LexNode>(LexNode::Type::LiteralConstant, CurrentToken());
+		p_tokenStream->Advance();
 		return litNode;
 	}
 
-	Lexer::SharedNode Lexer::LUnaryOp() 
+	Lexer::NodePtr Lexer::LUnaryOp() 
 	{
 		const Token& opToken = CurrentToken();
-		tokenIndex++;
+		p_tokenStream->Advance();
 
-		auto opNode = std::make_shared<LexNode>(LexNode::Type::UnaryOperation, opToken);
+		auto opNode = p_arena->New<LexNode>(LexNode::Type::UnaryOperation, opToken);
 		
 		opNode->children.push_back(LExpression(UnaryOpPrecedence(opToken.type)));
 
 		return opNode;
 	}
 
-	Lexer::SharedNode Lexer::LParenthesis() 
+	Lexer::NodePtr Lexer::LParenthesis() 
 	{
 		const Token& parToken = CurrentToken();
-		auto parNode = std::make_shared<LexNode>(LexNode::Type::Parenthesis, parToken);
-		tokenIndex++;
+		auto parNode = p_arena->New<LexNode>(LexNode::Type::Parenthesis, parToken);
+		p_tokenStream->Advance();
 
 		parNode->children.push_back(LExpression(0));
 
@@ -747,17 +759,17 @@ namespace Tolo
 		return parNode;
 	}
 
-	Lexer::SharedNode Lexer::LFunctionCall() 
+	Lexer::NodePtr Lexer::LFunctionCall() 
 	{
 		const Token& nameToken = CurrentToken();
 
 		ConsumeNextToken(Token::Type::StartPar);
 
-		auto funcCallNode = std::make_shared<LexNode>(LexNode::Type::FunctionCall, nameToken);
+		auto funcCallNode = p_arena->New<LexNode>(LexNode::Type::FunctionCall, nameToken);
 
 		if (CurrentToken().type == Token::Type::EndPar)
 		{
-			tokenIndex++;
+			p_tokenStream->Advance();
 		}
 		else
 		{
@@ -767,7 +779,7 @@ namespace Tolo
 
 				if (CurrentToken().type == Token::Type::EndPar)
 				{
-					tokenIndex++;
+					p_tokenStream->Advance();
 					break;
 				}
 
@@ -1,18 +1,21 @@
 #pragma once
 #include "lex_node.h"
-#include <memory>
+#include "arena.h"
+#include "tokenizer.h"
 
 namespace Tolo
 {
 	struct Lexer
 	{
-		const std::vector<Token>* p_tokens;
-		size_t tokenIndex;
+		Arena* p_arena; // owns all lex nodes
+		TokenStream* p_tokenStream;
 		bool isInsideWhile;
 
-		using SharedNode = std::shared_ptr<LexNode>;
+		using NodePtr = LexNode*;
 
-		Lexer();
+		Lexer(Arena& _arena);
+
+		bool HasTokensLeft();
 
 		void AffirmTokensLeft();
 
@@ -35,59 +38,59 @@ namespace Tolo
 		int UnaryOpPrecedence(Token::Type tokenType);
 
 		// root lexer
-		void Lex(const std::vector<Token>& tokens, std::vector<SharedNode>& lexNodes);
+		void Lex(TokenStream& tokenStream, std::vector<NodePtr>& lexNodes);
 
 		// global structures
-		SharedNode LGlobalStructure();
+		NodePtr LGlobalStructure();
 
-		SharedNode LStructDefinition();
+		NodePtr LStructDefinition();
 
-		SharedNode LFunctionDefinition();
+		NodePtr LFunctionDefinition();
 
-		SharedNode LOperatorDefinition();
+		NodePtr LOperatorDefinition();
 
-		SharedNode LMemberFunctionDefinition();
+		NodePtr LMemberFunctionDefinition();
 
-		SharedNode LEnumDefinition();
+		NodePtr LEnumDefinition();
 
 		// statements
-		SharedNode LStatement();
+		NodePtr LStatement();
 
-		SharedNode LScope();
+		NodePtr LScope();
 
-		SharedNode LIfStatement();
+		NodePtr LIfStatement();
 
-		SharedNode LElseStatement();
+		NodePtr LElseStatement();
 
-		SharedNode LWhileStatement();
+		NodePtr LWhileStatement();
 
-		SharedNode LBreakStatement();
+		NodePtr LBreakStatement();
 
-		SharedNode LContinueStatement();
+		NodePtr LContinueStatement();
 
-		SharedNode LReturnStatement();
+		NodePtr LReturnStatement();
 
 		// expressions
-		SharedNode LExpression(int precedence);
+		NodePtr LExpression(int precedence);
 
-		SharedNode LPrefix();
+		NodePtr LPrefix();
 
-		SharedNode LInfix(const SharedNode& lhsNode);
+		NodePtr LInfix(NodePtr lhsNode);
 
-		SharedNode LNameWithDoubleColon();
+		NodePtr LNameWithDoubleColon();
 
-		SharedNode LVariableDefinition();
+		NodePtr LVariableDefinition();
 
-		SharedNode LIdentifier();
+		NodePtr LIdentifier();
 
-		SharedNode LMemberAccess();
+		NodePtr LMemberAccess();
 
-		SharedNode LLiteral();
+		NodePtr LLiteral();
 
-		SharedNode LUnaryOp();
+		NodePtr LUnaryOp();
 
-		SharedNode LParenthesis();
+		NodePtr LParenthesis();
 
-		SharedNode LFunctionCall();
+		NodePtr LFunctionCall();
 	};
 }
\ No newline at end of file
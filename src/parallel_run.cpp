@@ -0,0 +1,48 @@
+#include "parallel_run.h"
+#include <thread>
+#include <vector>
+#include <exception>
+
+namespace Tolo
+{
+	void RunInParallel(size_t threadCount, const std::function<void(size_t threadIndex)>& work)
+	{
+		// each thread only writes its own error
+		std::vector<std::exception_ptr> errors(threadCount);
+
+		auto runWork = [&](size_t threadIndex)
+		{
+			try
+			{
+				work(threadIndex);
+			}
+			catch (...)
+			{
+				errors[threadIndex] = std::current_exception();
+			}
+		};
+
+		std::vector<std::thread> threads;
+
+		for (size_t i = 1; i < threadCount; i++)
+			threads.emplace_back(runWork, i);
+
+		runWork(0);
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		for (const std::exception_ptr& error : errors)
+		{
+			if (error)
+				std::rethrow_exception(error);
+		}
+	}
+
+	size_t GetDefaultThreadCount()
+	{
+		unsigned int count = std::thread::hardware_concurrency();
+
+		return count > 0 ? static_cast<size_t>(count) : 1;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+namespace Tolo
+{
+	// runs the work once per thread index, index 0 on the calling thread and every other on a new
+	// thread that is joined before returning, no threads are kept between calls, if any work threw
+	// the error of the lowest thread index is rethrown once all are done
+	void RunInParallel(size_t threadCount, const std::function<void(size_t threadIndex)>& work);
+
+	// number of threads to use when none is requested, at least 1
+	size_t GetDefaultThreadCount();
+}
\ No newline at end of file
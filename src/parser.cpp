@@ -1,35 +1,39 @@
 #include "parser.h"
 #include <utility>
 #include <set>
+#include <algorithm>
 
 #define ANY_VALUE_TYPE "0any"
 
 namespace Tolo
 {
 	VariableInfo::VariableInfo() :
+		typeId(INVALID_SYMBOL),
 		offset(0)
 	{}
 
-	VariableInfo::VariableInfo(const std::string& _typeName, Int _offset) :
-		typeName(_typeName),
+	VariableInfo::VariableInfo(SymbolId _typeId, Int _offset) :
+		typeId(_typeId),
 		offset(_offset)
 	{}
 
 	VariableInfo::VariableInfo(const VariableInfo& rhs) :
-		typeName(rhs.typeName),
+		typeId(rhs.typeId),
 		offset(rhs.offset)
 	{}
 
 	VariableInfo& VariableInfo::operator=(const VariableInfo& rhs)
 	{
-		typeName = rhs.typeName;
+		typeId = rhs.typeId;
 		offset = rhs.offset;
 		return *this;
 	}
 
 	FunctionInfo::FunctionInfo() :
+		returnTypeId(INVALID_SYMBOL),
 		localsSize(0),
-		parametersSize(0)
+		parametersSize(0),
+		invokerStructTypeId(INVALID_SYMBOL)
 	{}
 
 	NativeFunctionInfo::NativeFunctionInfo() :
@@ -39,6 +43,40 @@ namespace Tolo
 	StructInfo::StructInfo()
 	{}
 
+	FunctionKey::FunctionKey() :
+		returnTypeId(INVALID_SYMBOL),
+		nameId(INVALID_SYMBOL)
+	{}
+
+	bool FunctionKey::operator==(const FunctionKey& rhs) const
+	{
+		return returnTypeId == rhs.returnTypeId && nameId == rhs.nameId && parameterTypeIds == rhs.parameterTypeIds;
+	}
+
+	size_t FunctionKeyHasher::operator()(const FunctionKey& key) const
+	{
+		size_t hash = static_cast<size_t>(key.returnTypeId);
+		hash = hash * 31 + static_cast<size_t>(key.nameId);
+
+		for (SymbolId id : key.parameterTypeIds)
+			hash = hash * 31 + static_cast<size_t>(id);
+
+		return hash;
+	}
+
+	FunctionEntry::FunctionEntry() :
+		returnTypeId(INVALID_SYMBOL),
+		p_userFunction(nullptr),
+		p_nativeFunction(nullptr)
+	{}
+
+	PendingFunctionBody::PendingFunctionBody(const std::string& _funcHash, LexNode* _p_lexNode, EDefineFunction* _p_defFuncExp, bool _addVoidReturn) :
+		funcHash(_funcHash),
+		p_lexNode(_p_lexNode),
+		p_defFuncExp(_p_defFuncExp),
+		addVoidReturn(_addVoidReturn)
+	{}
+
 	VirtualFunctionInfo::VirtualFunctionInfo() :
 		vTableOffset(0)
 	{}
@@ -71,16 +109,25 @@ namespace Tolo
 	}
 
 
-	Parser::Parser() :
-		p_currentFunction(nullptr)
+	Parser::Parser(Arena& _arena, SymbolTable& _symbols) :
+		p_arena(&_arena),
+		p_symbols(&_symbols),
+		p_currentFunction(nullptr),
+		voidTypeId(_symbols.Intern("void")),
+		charTypeId(_symbols.Intern("char")),
+		intTypeId(_symbols.Intern("int")),
+		floatTypeId(_symbols.Intern("float")),
+		ptrTypeId(_symbols.Intern("ptr")),
+		anyValueTypeId(_symbols.Intern(ANY_VALUE_TYPE)),
+		virtualMemberId(_symbols.Intern("virtual"))
 	{
-		typeNameToSize["void"] = 0;
-		typeNameToSize["char"] = sizeof(Char);
-		typeNameToSize["int"] = sizeof(Int);
-		typeNameToSize["float"] = sizeof(Float);
-		typeNameToSize["ptr"] = sizeof(Ptr);
+		typeIdToSize[voidTypeId] = 0;
+		typeIdToSize[charTypeId] = sizeof(Char);
+		typeIdToSize[intTypeId] = sizeof(Int);
+		typeIdToSize[floatTypeId] = sizeof(Float);
+		typeIdToSize[ptrTypeId] = sizeof(Ptr);
 
-		typeNameOperators["char"] =
+		typeIdOperators[charTypeId] =
 		{
 			OpCode::Char_Add,
 			OpCode::Char_Sub,
@@ -103,7 +150,7 @@ namespace Tolo
 			OpCode::Bit_8_Invert
 		};
 
-		typeNameOperators["int"] =
+		typeIdOperators[intTypeId] =
 		{
 			OpCode::Int_Add,
 			OpCode::Int_Sub,
@@ -126,7 +173,7 @@ namespace Tolo
 			OpCode::Bit_32_Invert
 		};
 
-		typeNameOperators["float"] =
+		typeIdOperators[floatTypeId] =
 		{
 			OpCode::Float_Add,
 			OpCode::Float_Sub,
@@ -149,7 +196,7 @@ namespace Tolo
 			OpCode::Bit_32_Invert
 		};
 
-		typeNameOperators["ptr"] =
+		typeIdOperators[ptrTypeId] =
 		{
 			OpCode::Ptr_Add,
 			OpCode::Ptr_Sub,
@@ -172,7 +219,15 @@ namespace Tolo
 			OpCode::INVALID
 		};
 
-		currentExpectedReturnType = "void";
+		currentExpectedReturnType = voidTypeId;
+	}
+
+	Parser::Parser(const Parser& declarations, Arena& _arena, SymbolTable& _symbols) :
+		Parser(declarations)
+	{
+		p_arena = &_arena;
+		p_symbols = &_symbols;
+		functionBodies.clear();
 	}
 
 	bool Parser::IsFunctionDefined(const std::string& hash)
@@ -180,6 +235,109 @@ namespace Tolo
 		return hashToUserFunctions.count(hash) != 0 || hashToNativeFunctions.count(hash) != 0;
 	}
 
+	SymbolId Parser::GetSymbol(const LexToken& token)
+	{
+		return token.symbol != INVALID_SYMBOL ? token.symbol : p_symbols->Intern(token.text);
+	}
+
+	const std::string& Parser::GetTypeName(SymbolId typeId) const
+	{
+		// expressions that yield no value leave their type unset
+		static const std::string noTypeName;
+
+		return typeId != INVALID_SYMBOL ? p_symbols->GetName(typeId) : noTypeName;
+	}
+
+	std::vector<std::string> Parser::GetTypeNames(const std::vector<SymbolId>& typeIds) const
+	{
+		std::vector<std::string> typeNames;
+
+		for (SymbolId typeId : typeIds)
+			typeNames.push_back(GetTypeName(typeId));
+
+		return typeNames;
+	}
+
+	SymbolId Parser::DeclareStructPtrType(SymbolId structId)
+	{
+		SymbolId structPtrId = p_symbols->Intern(GetTypeName(structId) + "::ptr");
+		ptrTypeIdToStructTypeId[structPtrId] = structId;
+		structTypeIdToPtrTypeId[structId] = structPtrId;
+		typeIdToSize[structPtrId] = sizeof(Ptr);
+
+		return structPtrId;
+	}
+
+	void Parser::AddNativeStruct(const std::string& structName, const std::vector<std::pair<std::string, std::string>>& members)
+	{
+		// the program checked the members when the struct was added
+		SymbolId structId = p_symbols->Intern(structName);
+		DeclareStructPtrType(structId);
+
+		StructInfo& structInfo = typeIdToStructInfo[structId];
+		Int propertyOffset = 0;
+
+		for (const auto& member : members)
+		{
+			SymbolId membTypeId = p_symbols->Intern(member.first);
+			SymbolId membId = p_symbols->Intern(member.second);
+
+			structInfo.memberIdToVarInfo[membId] = VariableInfo(membTypeId, propertyOffset);
+			structInfo.memberIds.push_back(membId);
+			propertyOffset += typeIdToSize.at(membTypeId);
+		}
+
+		typeIdToSize[structId] = propertyOffset;
+	}
+
+	void Parser::AddFunctionKey(const std::string& hash)
+	{
+		// split the hash "ret name(param, param)" back into its symbols
+		std::string_view hashView = hash;
+		size_t nameStart = hashView.find(' ') + 1;
+		size_t paramsStart = hashView.find('(', nameStart) + 1;
+		size_t paramsEnd = hashView.size() - 1;
+
+		FunctionKey key;
+		key.returnTypeId = p_symbols->Intern(hashView.substr(0, nameStart - 1));
+		key.nameId = p_symbols->Intern(hashView.substr(nameStart, paramsStart - 1 - nameStart));
+
+		for (size_t i = paramsStart; i < paramsEnd;)
+		{
+			size_t paramEnd = std::min(hashView.find(", ", i), paramsEnd);
+			key.parameterTypeIds.push_back(p_symbols->Intern(hashView.substr(i, paramEnd - i)));
+			i = paramEnd + 2;
+		}
+
+		FunctionEntry& entry = keyToFunction[key];
+		entry.hash = hash;
+		entry.returnTypeId = key.returnTypeId;
+		entry.p_userFunction = hashToUserFunctions.count(hash) != 0 ? &hashToUserFunctions.at(hash) : nullptr;
+		entry.p_nativeFunction = hashToNativeFunctions.count(hash) != 0 ? &hashToNativeFunctions.at(hash) : nullptr;
+	}
+
+	const FunctionEntry* Parser::FindFunction(
+		SymbolId returnTypeId, 
+		SymbolId nameId, 
+		const std::vector<SymbolId>& parameterTypeIds
+	)
+	{
+		FunctionKey key;
+		key.returnTypeId = returnTypeId;
+		key.nameId = nameId;
+		key.parameterTypeIds = parameterTypeIds;
+
+		auto it = keyToFunction.find(key);
+
+		if (it == keyToFunction.end())
+			return nullptr;
+
+		if (p_currentFunction != nullptr)
+			currentCallees.insert(it->second.hash);
+
+		return &it->second;
+	}
+
 	bool Parser::IsVariableDefined(const std::string& name)
 	{
 		for (auto scope = scopeStack.rbegin(); scope != scopeStack.rend(); scope++)
@@ -212,19 +370,19 @@ namespace Tolo
 		scopeStack.back().localVariables.insert(name);
 	}
 
-	void Parser::AffirmCurrentType(const std::string& typeName, int line, bool canBeAnyValueType)
+	void Parser::AffirmCurrentType(SymbolId typeId, int line, bool canBeAnyValueType)
 	{
-		if (canBeAnyValueType && typeName != "void" && currentExpectedReturnType == ANY_VALUE_TYPE)
+		if (canBeAnyValueType && typeId != voidTypeId && currentExpectedReturnType == anyValueTypeId)
 			return;
 
 		Affirm(
-			currentExpectedReturnType == typeName,
+			currentExpectedReturnType == typeId,
 			"expected expression of type '%s' but got '%s' at line %i",
-			currentExpectedReturnType.c_str(), typeName.c_str(), line
+			GetTypeName(currentExpectedReturnType).c_str(), GetTypeName(typeId).c_str(), line
 		);
 	}
 
-	bool Parser::HasBody(const SharedNode& lexNode, size_t& outContentStartIndex, size_t& outContentCount)
+	bool Parser::HasBody(NodePtr lexNode, size_t& outContentStartIndex, size_t& outContentCount)
 	{
 		switch (lexNode->type)
 		{
@@ -251,7 +409,7 @@ namespace Tolo
 		return true;
 	}
 
-	void Parser::FlattenNode(const SharedNode& lexNode, std::vector<SharedNode>& outNodes)
+	void Parser::FlattenNode(NodePtr lexNode, std::vector<NodePtr>& outNodes)
 	{
 		size_t contentStart = 0;
 		size_t contentCount = 0;
@@ -266,16 +424,27 @@ namespace Tolo
 			FlattenNode(lexNode->children[contentStart + i], outNodes);
 	}
 	
-	void Parser::Parse(const std::vector<SharedNode>& lexNodes, std::vector<SharedExp>& expressions)
+	void Parser::Parse(const std::vector<NodePtr>& lexNodes, std::vector<ExpPtr>& expressions)
+	{
+		ParseDeclarations(lexNodes, expressions);
+
+		for (const PendingFunctionBody& body : functionBodies)
+			PFunctionBody(body);
+	}
+
+	void Parser::ParseDeclarations(const std::vector<NodePtr>& lexNodes, std::vector<ExpPtr>& expressions)
 	{
-		for (const SharedNode& node : lexNodes)
+		for (const auto& e : hashToNativeFunctions)
+			AddFunctionKey(e.first);
+
+		for (NodePtr node : lexNodes)
 			expressions.push_back(PGlobalStructure(node));
 
 		for (const auto& vTablePair : structNameToVTable)
 		{
 			const std::string& vTableName = vTablePair.first;
 			const VirtualTable& vTable = vTablePair.second;
-			auto defVTableExp = std::make_shared<EDefineVTable>(vTableName);
+			auto defVTableExp = p_arena->New<EDefineVTable>(vTableName);
 
 			// sort the virtual functions
 			std::map<Int, std::string> vTableOffsetToGlobalHash;
@@ -294,7 +463,7 @@ namespace Tolo
 	}
 
 	// global structures
-	Parser::SharedExp Parser::PGlobalStructure(const SharedNode& lexNode) 
+	Parser::ExpPtr Parser::PGlobalStructure(NodePtr lexNode) 
 	{
 		switch (lexNode->type)
 		{
@@ -313,21 +482,20 @@ namespace Tolo
 		return PEnumDefinition(lexNode);
 	}
 
-	Parser::SharedExp Parser::PStructDefinition(const SharedNode& lexNode) 
+	Parser::ExpPtr Parser::PStructDefinition(NodePtr lexNode) 
 	{
 		const std::string& structName = lexNode->token.text;
+		SymbolId structId = GetSymbol(lexNode->token);
 
 		Affirm(
-			typeNameToSize.contains(structName) == 0,
+			typeIdToSize.contains(structId) == 0,
 			"type name '%s' at line %i is already defined",
 			structName.c_str(), lexNode->token.line
 		);
 
-		std::string structPtrName = structName + "::ptr";
-		ptrTypeNameToStructTypeName[structPtrName] = structName;
-		typeNameToSize[structPtrName] = sizeof(Ptr);
+		DeclareStructPtrType(structId);
 
-		StructInfo& structInfo = typeNameToStructInfo[structName];
+		StructInfo& structInfo = typeIdToStructInfo[structId];
 		Int propertyOffset = 0;
 		size_t startChildIndex = 0;
 
@@ -335,15 +503,16 @@ namespace Tolo
 		if (lexNode->type == LexNode::Type::StructDefinitionInheritance)
 		{
 			const std::string& parentStructName = lexNode->children[0]->token.text;
+			SymbolId parentStructId = GetSymbol(lexNode->children[0]->token);
 
 			Affirm(
-				parentStructName != structName &&
-				typeNameToStructInfo.count(parentStructName) != 0,
+				parentStructId != structId &&
+				typeIdToStructInfo.count(parentStructId) != 0,
 				"struct type name '%s' at line %i is not defined",
 				parentStructName.c_str(), lexNode->token.line
 			);
 
-			structNameToParentStructName[structName] = parentStructName;
+			structIdToParentStructId[structId] = parentStructId;
 
 			// handle virtual parent struct
 			if (structNameToVTable.count(parentStructName) != 0)
@@ -352,8 +521,8 @@ namespace Tolo
 					structNameToVTable.at(parentStructName);
 			}
 
-			structInfo = typeNameToStructInfo.at(parentStructName);
-			propertyOffset = typeNameToSize.at(parentStructName);
+			structInfo = typeIdToStructInfo.at(parentStructId);
+			propertyOffset = typeIdToSize.at(parentStructId);
 			startChildIndex = 1;
 		}
 		
@@ -361,30 +530,32 @@ namespace Tolo
 		{
 			const std::string& membTypeName = lexNode->children[i]->token.text;
 			const std::string& membName = lexNode->children[i + 1]->token.text;
+			SymbolId membTypeId = GetSymbol(lexNode->children[i]->token);
+			SymbolId membId = GetSymbol(lexNode->children[i + 1]->token);
 
 			Affirm(
-				membTypeName != structName,
+				membTypeId != structId,
 				"struct cannot contain itself, line %i",
 				lexNode->children[i]->token.line
 			);
 
 			Affirm(
-				typeNameToSize.count(membTypeName) != 0,
+				typeIdToSize.count(membTypeId) != 0,
 				"type name '%s' at line %i is not defined",
 				membTypeName.c_str(), lexNode->children[i]->token.line
 			);
 
 			Affirm(
-				structInfo.memberNameToVarInfo.count(membName) == 0,
+				structInfo.memberIdToVarInfo.count(membId) == 0,
 				"member '%s' at line %i is already defined in struct '%s'",
 				membName.c_str(), lexNode->children[i + 1]->token.line, structName.c_str()
 			);
 
 			// handle virtual declaration
-			if (membName == "virtual")
+			if (membId == virtualMemberId)
 			{
 				Affirm(
-					membTypeName == "ptr",
+					membTypeId == ptrTypeId,
 					"virtual specifier at line %i must be of type 'ptr'",
 					lexNode->children[i]->token.line
 				);
@@ -398,22 +569,23 @@ namespace Tolo
 				structNameToVTable[structName] = {};
 			}
 
-			structInfo.memberNameToVarInfo[membName] = VariableInfo(membTypeName, propertyOffset);
-			structInfo.memberNames.push_back(membName);
-			propertyOffset += typeNameToSize[membTypeName];
+			structInfo.memberIdToVarInfo[membId] = VariableInfo(membTypeId, propertyOffset);
+			structInfo.memberIds.push_back(membId);
+			propertyOffset += typeIdToSize[membTypeId];
 		}
 
-		typeNameToSize[structName] = propertyOffset;
+		typeIdToSize[structId] = propertyOffset;
 
-		return std::make_shared<EEmpty>();
+		return p_arena->New<EEmpty>();
 	}
 
-	Parser::SharedExp Parser::PFunctionDefinition(const SharedNode& lexNode) 
+	Parser::ExpPtr Parser::PFunctionDefinition(NodePtr lexNode) 
 	{
 		const std::string& returnTypeName = lexNode->token.text;
+		SymbolId returnTypeId = GetSymbol(lexNode->token);
 
 		Affirm(
-			typeNameToSize.count(returnTypeName) != 0,
+			typeIdToSize.count(returnTypeId) != 0,
 			"undefined type '%s' at line %i",
 			returnTypeName.c_str(), lexNode->token.line
 		);
@@ -421,11 +593,11 @@ namespace Tolo
 		const std::string& funcName = lexNode->children[0]->token.text;
 		
 		FunctionInfo funcInfo;
-		funcInfo.returnTypeName = returnTypeName;
+		funcInfo.returnTypeId = returnTypeId;
 		Int nextVarOffset = 0;
 
 		// flatten content nodes into a single array to find all variable definitions
-		std::vector<SharedNode> bodyContent;
+		std::vector<NodePtr> bodyContent;
 		FlattenNode(lexNode->children.back(), bodyContent);
 
 		// find all local variable definitions
@@ -437,13 +609,14 @@ namespace Tolo
 				continue;
 			}
 
-			const SharedNode& varDefNode = statNode->children[0];
+			NodePtr varDefNode = statNode->children[0];
 
 			const std::string& varTypeName = varDefNode->token.text;
 			const std::string& varName = varDefNode->children[0]->token.text;
+			SymbolId varTypeId = GetSymbol(varDefNode->token);
 
 			Affirm(
-				typeNameToSize.count(varTypeName) != 0,
+				typeIdToSize.count(varTypeId) != 0,
 				"undefined type '%s' at line %i",
 				varTypeName.c_str(), statNode->token.line
 			);
@@ -454,10 +627,10 @@ namespace Tolo
 				varName.c_str(), varDefNode->token.line
 			);
 
-			Int varSize = typeNameToSize[varTypeName];
+			Int varSize = typeIdToSize[varTypeId];
 			nextVarOffset -= varSize;
 			funcInfo.localsSize += varSize;
-			funcInfo.varNameToVarInfo[varName] = { varTypeName, nextVarOffset };
+			funcInfo.varNameToVarInfo[varName] = { varTypeId, nextVarOffset };
 		}
 
 		// find all parameters
@@ -468,25 +641,26 @@ namespace Tolo
 		{
 			const std::string& paramTypeName = lexNode->children[i]->token.text;
 			const std::string& paramName = lexNode->children[i + 1]->token.text;
+			SymbolId paramTypeId = GetSymbol(lexNode->children[i]->token);
 
 			DeclareVariableInCurrentScope(paramName, lexNode->children[i + 1]->token.line);
 
 			Affirm(
-				typeNameToSize.count(paramTypeName) != 0,
+				typeIdToSize.count(paramTypeId) != 0,
 				"undefined type '%s' at line %i",
 				paramTypeName.c_str(), lexNode->children[i]->token.line
 			);
 
 			paramTypeNames.push_back(paramTypeName);
 
-			Int varSize = typeNameToSize[paramTypeName];
+			Int varSize = typeIdToSize[paramTypeId];
 			nextVarOffset -= varSize;
 			funcInfo.parametersSize += varSize;
-			funcInfo.varNameToVarInfo[paramName] = { paramTypeName, nextVarOffset };
+			funcInfo.varNameToVarInfo[paramName] = { paramTypeId, nextVarOffset };
 			funcInfo.parameterNames.push_back(paramName);
 		}
 
-		std::string funcHash = GetFunctionHash(funcInfo.returnTypeName, funcName, paramTypeNames);
+		std::string funcHash = GetFunctionHash(returnTypeName, funcName, paramTypeNames);
 
 		Affirm(
 			!IsFunctionDefined(funcHash),
@@ -495,42 +669,41 @@ namespace Tolo
 		);
 
 		hashToUserFunctions[funcHash] = funcInfo;
-
-		p_currentFunction = &funcInfo;
-
-		// parse body content
-		auto defFuncExp = std::make_shared<EDefineFunction>(funcHash);
-		
-		defFuncExp->body.push_back(PStatement(lexNode->children.back()));
+		AddFunctionKey(funcHash);
 		PopScope();
 
-		p_currentFunction = nullptr;
-
 		// check for final return expression
-		if (funcInfo.returnTypeName == "void" &&
+		bool addVoidReturn = false;
+
+		if (funcInfo.returnTypeId == voidTypeId &&
 			(bodyContent.size() == 0 || bodyContent.back()->type != LexNode::Type::Return))
 		{
 			// add a return statement if function has void return type and no return statement exists at end
 			// of function
-			defFuncExp->body.push_back(std::make_shared<EReturn>(0));
+			addVoidReturn = true;
 		}
 		else
 		{
 			Affirm(
-				defFuncExp->body.size() > 0 && bodyContent.back()->type == LexNode::Type::Return,
+				bodyContent.size() > 0 && bodyContent.back()->type == LexNode::Type::Return,
 				"missing 'return' in function '%s' at line %i",
 				funcName.c_str(), lexNode->token.line
 			);
 		}
 
+		auto defFuncExp = p_arena->New<EDefineFunction>(funcHash);
+		functionBodies.emplace_back(funcHash, lexNode, defFuncExp, addVoidReturn);
+
 		return defFuncExp;
 	}
 
-	Parser::SharedExp Parser::POperatorDefinition(const SharedNode& lexNode) 
+	Parser::ExpPtr Parser::POperatorDefinition(NodePtr lexNode) 
 	{
 		const std::string& returnTypeName = lexNode->token.text;
+		SymbolId returnTypeId = GetSymbol(lexNode->token);
+
 		Affirm(
-			typeNameToSize.count(returnTypeName) != 0,
+			typeIdToSize.count(returnTypeId) != 0,
 			"undefined type '%s' at line %i",
 			returnTypeName.c_str(), lexNode->token.line
 		);
@@ -563,11 +736,11 @@ namespace Tolo
 		);
 
 		FunctionInfo funcInfo;
-		funcInfo.returnTypeName = returnTypeName;
+		funcInfo.returnTypeId = returnTypeId;
 		Int nextVarOffset = 0;
 
 		// flatten content nodes into a single array to find all variable definitions
-		std::vector<SharedNode> bodyContent;
+		std::vector<NodePtr> bodyContent;
 		FlattenNode(lexNode->children.back(), bodyContent);
 
 		// find all local variable definitions
@@ -579,13 +752,14 @@ namespace Tolo
 				continue;
 			}
 
-			const SharedNode& varDefNode = statNode->children[0];
+			NodePtr varDefNode = statNode->children[0];
 
 			const std::string& varTypeName = varDefNode->token.text;
 			const std::string& varName = varDefNode->children[0]->token.text;
+			SymbolId varTypeId = GetSymbol(varDefNode->token);
 
 			Affirm(
-				typeNameToSize.count(varTypeName) != 0,
+				typeIdToSize.count(varTypeId) != 0,
 				"undefined type '%s' at line %i",
 				varTypeName.c_str(), statNode->token.line
 			);
@@ -596,10 +770,10 @@ namespace Tolo
 				varName.c_str(), varDefNode->token.line
 			);
 
-			Int varSize = typeNameToSize[varTypeName];
+			Int varSize = typeIdToSize[varTypeId];
 			nextVarOffset -= varSize;
 			funcInfo.localsSize += varSize;
-			funcInfo.varNameToVarInfo[varName] = { varTypeName, nextVarOffset };
+			funcInfo.varNameToVarInfo[varName] = { varTypeId, nextVarOffset };
 		}
 
 		// find all parameters
@@ -610,21 +784,22 @@ namespace Tolo
 		{
 			const std::string& paramTypeName = lexNode->children[i]->token.text;
 			const std::string& paramName = lexNode->children[i + 1]->token.text;
+			SymbolId paramTypeId = GetSymbol(lexNode->children[i]->token);
 
 			DeclareVariableInCurrentScope(paramName, lexNode->children[i + 1]->token.line);
 
 			Affirm(
-				typeNameToSize.count(paramTypeName) != 0,
+				typeIdToSize.count(paramTypeId) != 0,
 				"undefined type '%s' at line %i",
 				paramTypeName.c_str(), lexNode->children[i]->token.line
 			);
 
 			paramTypeNames.push_back(paramTypeName);
 
-			Int varSize = typeNameToSize[paramTypeName];
+			Int varSize = typeIdToSize[paramTypeId];
 			nextVarOffset -= varSize;
 			funcInfo.parametersSize += varSize;
-			funcInfo.varNameToVarInfo[paramName] = { paramTypeName, nextVarOffset };
+			funcInfo.varNameToVarInfo[paramName] = { paramTypeId, nextVarOffset };
 			funcInfo.parameterNames.push_back(paramName);
 		}
 
@@ -641,52 +816,49 @@ namespace Tolo
 		);
 
 		hashToUserFunctions[funcHash] = funcInfo;
-
-		auto defFuncExp = std::make_shared<EDefineFunction>(funcHash);
-
-		p_currentFunction = &funcInfo;
-
-		// parse body content
-		defFuncExp->body.push_back(PStatement(lexNode->children.back()));
+		AddFunctionKey(funcHash);
 		PopScope();
 
-		p_currentFunction = nullptr;
-
 		// check for final return expression
 		Affirm(
-			defFuncExp->body.size() > 0 && bodyContent.back()->type == LexNode::Type::Return,
+			bodyContent.size() > 0 && bodyContent.back()->type == LexNode::Type::Return,
 			"operator function at line %i does not return a value",
 			lexNode->token.line
 		);
 
+		auto defFuncExp = p_arena->New<EDefineFunction>(funcHash);
+		functionBodies.emplace_back(funcHash, lexNode, defFuncExp, false);
+
 		return defFuncExp;
 	}
 
-	Parser::SharedExp Parser::PMemberFunctionDefinition(const SharedNode& lexNode)
+	Parser::ExpPtr Parser::PMemberFunctionDefinition(NodePtr lexNode)
 	{
 		const std::string& returnTypeName = lexNode->token.text;
 		const std::string& structTypeName = lexNode->children[0]->token.text;
 		const std::string& funcName = lexNode->children[1]->token.text;
+		SymbolId returnTypeId = GetSymbol(lexNode->token);
+		SymbolId structTypeId = GetSymbol(lexNode->children[0]->token);
 
 		Affirm(
-			typeNameToSize.count(returnTypeName) != 0,
+			typeIdToSize.count(returnTypeId) != 0,
 			"undefined type '%s' at line %i",
 			returnTypeName.c_str(), lexNode->token.line
 		);
 
 		Affirm(
-			typeNameToStructInfo.count(structTypeName) != 0,
+			typeIdToStructInfo.count(structTypeId) != 0,
 			"undefined struct type '%s' at line %i",
 			structTypeName.c_str(), lexNode->token.line
 		);
 
 		FunctionInfo funcInfo;
-		funcInfo.returnTypeName = returnTypeName;
-		funcInfo.invokerStructTypeName = structTypeName;
+		funcInfo.returnTypeId = returnTypeId;
+		funcInfo.invokerStructTypeId = structTypeId;
 		Int nextVarOffset = 0;
 
 		// flatten content nodes into a single array to find all variable definitions
-		std::vector<SharedNode> bodyContent;
+		std::vector<NodePtr> bodyContent;
 		FlattenNode(lexNode->children.back(), bodyContent);
 
 		// find all local variable definitions
@@ -698,13 +870,14 @@ namespace Tolo
 				continue;
 			}
 
-			const SharedNode& varDefNode = statNode->children[0];
+			NodePtr varDefNode = statNode->children[0];
 
 			const std::string& varTypeName = varDefNode->token.text;
 			const std::string& varName = varDefNode->children[0]->token.text;
+			SymbolId varTypeId = GetSymbol(varDefNode->token);
 
 			Affirm(
-				typeNameToSize.count(varTypeName) != 0,
+				typeIdToSize.count(varTypeId) != 0,
 				"undefined type '%s' at line %i",
 				varTypeName.c_str(), statNode->token.line
 			);
@@ -715,10 +888,10 @@ namespace Tolo
 				varName.c_str(), varDefNode->token.line
 			);
 
-			Int varSize = typeNameToSize[varTypeName];
+			Int varSize = typeIdToSize[varTypeId];
 			nextVarOffset -= varSize;
 			funcInfo.localsSize += varSize;
-			funcInfo.varNameToVarInfo[varName] = { varTypeName, nextVarOffset };
+			funcInfo.varNameToVarInfo[varName] = { varTypeId, nextVarOffset };
 		}
 
 		PushScope();
@@ -728,13 +901,13 @@ namespace Tolo
 		{
 			DeclareVariableInCurrentScope("this", lexNode->token.line);
 
-			std::string structPtrTypeName = structTypeName + "::ptr";
-			paramTypeNames.push_back(structPtrTypeName);
+			SymbolId structPtrTypeId = structTypeIdToPtrTypeId.at(structTypeId);
+			paramTypeNames.push_back(GetTypeName(structPtrTypeId));
 
 			Int varSize = sizeof(Ptr);
 			nextVarOffset -= varSize;
 			funcInfo.parametersSize += varSize;
-			funcInfo.varNameToVarInfo["this"] = VariableInfo(structPtrTypeName, nextVarOffset);
+			funcInfo.varNameToVarInfo["this"] = VariableInfo(structPtrTypeId, nextVarOffset);
 		}
 
 		// find all parameters
@@ -742,25 +915,26 @@ namespace Tolo
 		{
 			const std::string& paramTypeName = lexNode->children[i]->token.text;
 			const std::string& paramName = lexNode->children[i + 1]->token.text;
+			SymbolId paramTypeId = GetSymbol(lexNode->children[i]->token);
 
 			DeclareVariableInCurrentScope(paramName, lexNode->children[i + 1]->token.line);
 
 			Affirm(
-				typeNameToSize.count(paramTypeName) != 0,
+				typeIdToSize.count(paramTypeId) != 0,
 				"undefined type '%s' at line %i",
 				paramTypeName.c_str(), lexNode->children[i]->token.line
 			);
 
 			paramTypeNames.push_back(paramTypeName);
 
-			Int varSize = typeNameToSize[paramTypeName];
+			Int varSize = typeIdToSize[paramTypeId];
 			nextVarOffset -= varSize;
 			funcInfo.parametersSize += varSize;
-			funcInfo.varNameToVarInfo[paramName] = { paramTypeName, nextVarOffset };
+			funcInfo.varNameToVarInfo[paramName] = { paramTypeId, nextVarOffset };
 			funcInfo.parameterNames.push_back(paramName);
 		}
 
-		std::string funcHash = GetFunctionHash(funcInfo.returnTypeName, structTypeName + "::" + funcName, paramTypeNames);
+		std::string funcHash = GetFunctionHash(returnTypeName, structTypeName + "::" + funcName, paramTypeNames);
 
 		Affirm(
 			!IsFunctionDefined(funcHash),
@@ -769,7 +943,7 @@ namespace Tolo
 		);
 
 		// handle virtual member function
-		std::shared_ptr<EDefineFunction> virtualRedirectorFuncExp;
+		EDefineFunction* virtualRedirectorFuncExp = nullptr;
 
 		if (lexNode->type == LexNode::Type::MemberFunctionDefinitionVirtual)
 		{
@@ -800,29 +974,30 @@ namespace Tolo
 			else
 			{
 				// create a function that redirects to the function in the v-table
-				virtualRedirectorFuncExp = std::make_shared<EDefineFunction>(funcHash);
+				virtualRedirectorFuncExp = p_arena->New<EDefineFunction>(funcHash);
 				hashToUserFunctions[funcHash] = funcInfo;
+				AddFunctionKey(funcHash);
 
-				auto loadVirtFuncPtrExp = std::make_shared<ELoadMulti>();
+				auto loadVirtFuncPtrExp = p_arena->New<ELoadMulti>();
 				VariableInfo& thisPtrInfo = funcInfo.varNameToVarInfo.at("this");
-				const StructInfo& structInfo = typeNameToStructInfo.at(structTypeName);
-				const VariableInfo& vTablePtrInfo = structInfo.memberNameToVarInfo.at("virtual");
+				const StructInfo& structInfo = typeIdToStructInfo.at(structTypeId);
+				const VariableInfo& vTablePtrInfo = structInfo.memberIdToVarInfo.at(virtualMemberId);
 				Int vTableOffset = static_cast<Int>(vTable.size());
 
 				// load the "this"-ptr variable
-				loadVirtFuncPtrExp->loaders.push_back(std::make_shared<ELoadVariable>(thisPtrInfo.offset, static_cast<Int>(sizeof(Ptr))));
+				loadVirtFuncPtrExp->loaders.push_back(p_arena->New<ELoadVariable>(thisPtrInfo.offset, static_cast<Int>(sizeof(Ptr))));
 				// load v-table pointer member offset
-				loadVirtFuncPtrExp->loaders.push_back(std::make_shared<ELoadConstInt>(vTablePtrInfo.offset));
-				loadVirtFuncPtrExp->loaders.push_back(std::make_shared<EPtrAdd>());
+				loadVirtFuncPtrExp->loaders.push_back(p_arena->New<ELoadConstInt>(vTablePtrInfo.offset));
+				loadVirtFuncPtrExp->loaders.push_back(p_arena->New<EPtrAdd>());
 				// load pointer stored in v-table pointer member
-				loadVirtFuncPtrExp->loaders.push_back(std::make_shared<ELoadPtrFromStackTopPtr>());
+				loadVirtFuncPtrExp->loaders.push_back(p_arena->New<ELoadPtrFromStackTopPtr>());
 				// add the offset of the function in the v-table to the v-table pointer
-				loadVirtFuncPtrExp->loaders.push_back(std::make_shared<ELoadConstInt>(vTableOffset));
-				loadVirtFuncPtrExp->loaders.push_back(std::make_shared<EPtrAdd>());
+				loadVirtFuncPtrExp->loaders.push_back(p_arena->New<ELoadConstInt>(vTableOffset));
+				loadVirtFuncPtrExp->loaders.push_back(p_arena->New<EPtrAdd>());
 				// load the function ip at the v-table pointer
-				loadVirtFuncPtrExp->loaders.push_back(std::make_shared<ELoadPtrFromStackTopPtr>());
+				loadVirtFuncPtrExp->loaders.push_back(p_arena->New<ELoadPtrFromStackTopPtr>());
 
-				auto gotoFuncExp = std::make_shared<EGoto>();
+				auto gotoFuncExp = p_arena->New<EGoto>();
 				gotoFuncExp->instrPtrLoad = loadVirtFuncPtrExp;
 
 				virtualRedirectorFuncExp->body.push_back(gotoFuncExp);
@@ -834,37 +1009,35 @@ namespace Tolo
 			}
 		}
 
-		auto defFuncExp = std::make_shared<EDefineFunction>(funcHash);
 		hashToUserFunctions[funcHash] = funcInfo;
-
-		p_currentFunction = &funcInfo;
-
-		// parse body content
-		defFuncExp->body.push_back(PStatement(lexNode->children.back()));
+		AddFunctionKey(funcHash);
 		PopScope();
 
-		p_currentFunction = nullptr;
-
 		// check for final return expression
-		if (funcInfo.returnTypeName == "void" &&
+		bool addVoidReturn = false;
+
+		if (funcInfo.returnTypeId == voidTypeId &&
 			(bodyContent.size() == 0 || bodyContent.back()->type != LexNode::Type::Return))
 		{
 			// add a return statement if function has void return type and no return statement exists at end
 			// of function
-			defFuncExp->body.push_back(std::make_shared<EReturn>(0));
+			addVoidReturn = true;
 		}
 		else
 		{
 			Affirm(
-				defFuncExp->body.size() > 0 && bodyContent.back()->type == LexNode::Type::Return,
+				bodyContent.size() > 0 && bodyContent.back()->type == LexNode::Type::Return,
 				"missing 'return' in function '%s' at line %i",
 				funcHash.c_str(), lexNode->token.line
 			);
 		}
 
+		auto defFuncExp = p_arena->New<EDefineFunction>(funcHash);
+		functionBodies.emplace_back(funcHash, lexNode, defFuncExp, addVoidReturn);
+
 		if (virtualRedirectorFuncExp != nullptr)
 		{
-			auto multiDefExp = std::make_shared<ELoadMulti>();
+			auto multiDefExp = p_arena->New<ELoadMulti>();
 			multiDefExp->loaders.push_back(defFuncExp);
 			multiDefExp->loaders.push_back(virtualRedirectorFuncExp);
 			return multiDefExp;
@@ -873,7 +1046,34 @@ namespace Tolo
 		return defFuncExp;
 	}
 
-	Parser::SharedExp Parser::PEnumDefinition(const SharedNode& lexNode)
+	void Parser::PFunctionBody(const PendingFunctionBody& body)
+	{
+		NodePtr lexNode = body.p_lexNode;
+		FunctionInfo& funcInfo = hashToUserFunctions.at(body.funcHash);
+		currentCallees.clear();
+
+		// parameters were checked with the signature
+		PushScope();
+
+		if (funcInfo.invokerStructTypeId != INVALID_SYMBOL)
+			DeclareVariableInCurrentScope("this", lexNode->token.line);
+
+		for (const std::string& paramName : funcInfo.parameterNames)
+			DeclareVariableInCurrentScope(paramName, lexNode->token.line);
+
+		p_currentFunction = &funcInfo;
+
+		// parse body content
+		body.p_defFuncExp->body.push_back(PStatement(lexNode->children.back()));
+		PopScope();
+
+		p_currentFunction = nullptr;
+
+		if (body.addVoidReturn)
+			body.p_defFuncExp->body.push_back(p_arena->New<EReturn>(0));
+	}
+
+	Parser::ExpPtr Parser::PEnumDefinition(NodePtr lexNode)
 	{
 		const std::string& enumNamespace = lexNode->token.text;
 
@@ -887,7 +1087,7 @@ namespace Tolo
 
 		Int enumValue = 0;
 
-		for (const SharedNode& enumNameNode : lexNode->children)
+		for (NodePtr enumNameNode : lexNode->children)
 		{
 			const std::string& enumName = enumNameNode->token.text;
 			std::string enumId = enumNamespace + "::" + enumName;
@@ -901,65 +1101,69 @@ namespace Tolo
 			nameToEnumValue[enumId] = enumValue++;
 		}
 
-		return std::make_shared<EEmpty>();
+		return p_arena->New<EEmpty>();
 	}
 
 	// statements
-	Parser::SharedExp Parser::PStatement(const SharedNode& lexNode) 
+	Parser::ExpPtr Parser::PStatement(NodePtr lexNode) 
 	{
+		ExpPtr statementExp = nullptr;
+
 		switch (lexNode->type)
 		{
 		case LexNode::Type::Break:
-			return PBreak(lexNode);
+			statementExp = PBreak(lexNode); break;
 		case LexNode::Type::Continue:
-			return PContinue(lexNode);
+			statementExp = PContinue(lexNode); break;
 		case LexNode::Type::Scope:
-			return PScope(lexNode);
+			statementExp = PScope(lexNode); break;
 		case LexNode::Type::Return:
-			return PReturn(lexNode);
+			statementExp = PReturn(lexNode); break;
 		case LexNode::Type::IfSingle:
-			return PIfSingle(lexNode);
+			statementExp = PIfSingle(lexNode); break;
 		case LexNode::Type::IfChain:
-			return PIfChain(lexNode);
+			statementExp = PIfChain(lexNode); break;
 		case LexNode::Type::ElseIfSingle:
-			return PElseIfSingle(lexNode);
+			statementExp = PElseIfSingle(lexNode); break;
 		case LexNode::Type::ElseIfChain:
-			return PElseIfChain(lexNode);
+			statementExp = PElseIfChain(lexNode); break;
 		case LexNode::Type::Else:
-			return PElse(lexNode);
+			statementExp = PElse(lexNode); break;
 		case LexNode::Type::While:
-			return PWhile(lexNode);
+			statementExp = PWhile(lexNode); break;
+		default:
+			statementExp = PExpression(lexNode); break;
 		}
 
-		return PExpression(lexNode);
+		return p_arena->New<EStatement>(lexNode->token.line, statementExp);
 	}
 
-	Parser::SharedExp Parser::PBreak(const SharedNode& lexNode)
+	Parser::ExpPtr Parser::PBreak(NodePtr lexNode)
 	{
 		Int depth = 1;
 		
 		if(lexNode->children.size() == 1)
 			depth = std::stoi(lexNode->children[0]->token.text);
 		
-		return std::make_shared<EBreak>(depth, lexNode->token.line);
+		return p_arena->New<EBreak>(depth, lexNode->token.line);
 	}
 
-	Parser::SharedExp Parser::PContinue(const SharedNode& lexNode)
+	Parser::ExpPtr Parser::PContinue(NodePtr lexNode)
 	{
 		Int depth = 1;
 
 		if (lexNode->children.size() == 1)
 			depth = std::stoi(lexNode->children[0]->token.text);
 
-		return std::make_shared<EContinue>(depth, lexNode->token.line);
+		return p_arena->New<EContinue>(depth, lexNode->token.line);
 	}
 
-	Parser::SharedExp Parser::PScope(const SharedNode& lexNode)
+	Parser::ExpPtr Parser::PScope(NodePtr lexNode)
 	{
-		auto scopeExp = std::make_shared<EScope>();
+		auto scopeExp = p_arena->New<EScope>();
 		
 		PushScope();
-		for (const SharedNode& statNode : lexNode->children)
+		for (NodePtr statNode : lexNode->children)
 			scopeExp->statements.push_back(PStatement(statNode));
 
 		PopScope();
@@ -967,35 +1171,35 @@ namespace Tolo
 		return scopeExp;
 	}
 
-	Parser::SharedExp Parser::PReturn(const SharedNode& lexNode) 
+	Parser::ExpPtr Parser::PReturn(NodePtr lexNode) 
 	{
-		auto retExp = std::make_shared<EReturn>(typeNameToSize[p_currentFunction->returnTypeName]);
+		auto retExp = p_arena->New<EReturn>(typeIdToSize[p_currentFunction->returnTypeId]);
 
 		if (lexNode->children.size() == 0)
 		{
 			Affirm(
-				p_currentFunction->returnTypeName == "void",
+				p_currentFunction->returnTypeId == voidTypeId,
 				"missing value expression after 'return' keyword at line %i",
 				lexNode->token.line
 			);
 		}
 		else
 		{
-			currentExpectedReturnType = p_currentFunction->returnTypeName;
+			currentExpectedReturnType = p_currentFunction->returnTypeId;
 			retExp->retValLoad = PReadableValue(lexNode->children[0]);
-			currentExpectedReturnType = "void";
+			currentExpectedReturnType = voidTypeId;
 		}
 
 		return retExp;
 	}
 
-	Parser::SharedExp Parser::PIfSingle(const SharedNode& lexNode) 
+	Parser::ExpPtr Parser::PIfSingle(NodePtr lexNode) 
 	{
-		auto ifExp = std::make_shared<EIfSingle>();
+		auto ifExp = p_arena->New<EIfSingle>();
 
-		currentExpectedReturnType = "char";
+		currentExpectedReturnType = charTypeId;
 		ifExp->conditionLoad = PReadableValue(lexNode->children[0]);
-		currentExpectedReturnType = "void";
+		currentExpectedReturnType = voidTypeId;
 
 		PushScope();
 		ifExp->body.push_back(PStatement(lexNode->children[1]));
@@ -1004,13 +1208,13 @@ namespace Tolo
 		return ifExp;
 	}
 
-	Parser::SharedExp Parser::PIfChain(const SharedNode& lexNode) 
+	Parser::ExpPtr Parser::PIfChain(NodePtr lexNode) 
 	{
-		auto ifChainExp = std::make_shared<EIfChain>();
+		auto ifChainExp = p_arena->New<EIfChain>();
 
-		currentExpectedReturnType = "char";
+		currentExpectedReturnType = charTypeId;
 		ifChainExp->conditionLoad = PReadableValue(lexNode->children[0]);
-		currentExpectedReturnType = "void";
+		currentExpectedReturnType = voidTypeId;
 
 		PushScope();
 		ifChainExp->body.push_back(PStatement(lexNode->children[1]));
@@ -1020,13 +1224,13 @@ namespace Tolo
 		return ifChainExp;
 	}
 
-	Parser::SharedExp Parser::PElseIfSingle(const SharedNode& lexNode) 
+	Parser::ExpPtr Parser::PElseIfSingle(NodePtr lexNode) 
 	{
-		auto elifExp = std::make_shared<EElseIfSingle>();
+		auto elifExp = p_arena->New<EElseIfSingle>();
 
-		currentExpectedReturnType = "char";
+		currentExpectedReturnType = charTypeId;
 		elifExp->conditionLoad = PReadableValue(lexNode->children[0]);
-		currentExpectedReturnType = "void";
+		currentExpectedReturnType = voidTypeId;
 
 		PushScope();
 		elifExp->body.push_back(PStatement(lexNode->children[1]));
@@ -1035,13 +1239,13 @@ namespace Tolo
 		return elifExp;
 	}
 
-	Parser::SharedExp Parser::PElseIfChain(const SharedNode& lexNode) 
+	Parser::ExpPtr Parser::PElseIfChain(NodePtr lexNode) 
 	{
-		auto elifExp = std::make_shared<EElseIfChain>();
+		auto elifExp = p_arena->New<EElseIfChain>();
 
-		currentExpectedReturnType = "char";
+		currentExpectedReturnType = charTypeId;
 		elifExp->conditionLoad = PReadableValue(lexNode->children[0]);
-		currentExpectedReturnType = "void";
+		currentExpectedReturnType = voidTypeId;
 
 		PushScope();
 		elifExp->body.push_back(PStatement(lexNode->children[1]));
@@ -1051,9 +1255,9 @@ namespace Tolo
 		return elifExp;
 	}
 
-	Parser::SharedExp Parser::PElse(const SharedNode& lexNode) 
+	Parser::ExpPtr Parser::PElse(NodePtr lexNode) 
 	{
-		auto elseExp = std::make_shared<EElse>();
+		auto elseExp = p_arena->New<EElse>();
 
 		PushScope();
 		elseExp->body.push_back(PStatement(lexNode->children[0]));
@@ -1062,13 +1266,13 @@ namespace Tolo
 		return elseExp;
 	}
 
-	Parser::SharedExp Parser::PWhile(const SharedNode& lexNode) 
+	Parser::ExpPtr Parser::PWhile(NodePtr lexNode) 
 	{
-		auto whileExp = std::make_shared<EWhile>();
+		auto whileExp = p_arena->New<EWhile>();
 
-		currentExpectedReturnType = "char";
+		currentExpectedReturnType = charTypeId;
 		whileExp->conditionLoad = PReadableValue(lexNode->children[0]);
-		currentExpectedReturnType = "void";
+		currentExpectedReturnType = voidTypeId;
 
 		PushScope();
 		whileExp->body.push_back(PStatement(lexNode->children[1]));
@@ -1078,9 +1282,9 @@ namespace Tolo
 	}
 
 	// expressions
-	Parser::SharedExp Parser::PExpression(const SharedNode& lexNode)
+	Parser::ExpPtr Parser::PExpression(NodePtr lexNode)
 	{
-		std::string unused;
+		SymbolId unused = INVALID_SYMBOL;
 
 		if (lexNode->type == LexNode::Type::BinaryOperation)
 			return PBinaryOp(lexNode, unused);
@@ -1088,7 +1292,7 @@ namespace Tolo
 		return PReadableValue(lexNode);
 	}
 
-	Parser::SharedExp Parser::PBinaryOp(const SharedNode& lexNode, std::string& outReadDataType)
+	Parser::ExpPtr Parser::PBinaryOp(NodePtr lexNode, SymbolId& outReadDataType)
 	{
 		switch (lexNode->token.type)
 		{
@@ -1109,25 +1313,25 @@ namespace Tolo
 		return PBinaryCompareOp(lexNode, outReadDataType);
 	}
 
-	Parser::SharedExp Parser::PAssign(const SharedNode& lexNode) 
+	Parser::ExpPtr Parser::PAssign(NodePtr lexNode) 
 	{
-		auto writeBytesExp = std::make_shared<EWriteBytesTo>();
+		auto writeBytesExp = p_arena->New<EWriteBytesTo>();
 
-		std::string expectedWriteType;
+		SymbolId expectedWriteType = INVALID_SYMBOL;
 		writeBytesExp->writePtrLoad = PWritablePtr(lexNode->children[0], expectedWriteType);
 
 		currentExpectedReturnType = expectedWriteType;
-		std::string readType;
+		SymbolId readType = INVALID_SYMBOL;
 		writeBytesExp->dataLoad = PReadableValue(lexNode->children[1], readType);
-		currentExpectedReturnType = "void";
+		currentExpectedReturnType = voidTypeId;
 
-		Int byteSize = typeNameToSize.at(readType);
-		writeBytesExp->bytesSizeLoad = std::make_shared<ELoadConstInt>(byteSize);
+		Int byteSize = typeIdToSize.at(readType);
+		writeBytesExp->bytesSizeLoad = p_arena->New<ELoadConstInt>(byteSize);
 
 		return writeBytesExp;
 	}
 
-	Parser::SharedExp Parser::PWritablePtr(const SharedNode& lexNode, std::string& outWriteDataType)
+	Parser::ExpPtr Parser::PWritablePtr(NodePtr lexNode, SymbolId& outWriteDataType)
 	{
 		switch (lexNode->type)
 		{
@@ -1145,7 +1349,7 @@ namespace Tolo
 
 		if (lexNode->type == LexNode::Type::UnaryOperation && lexNode->token.type == Token::Type::Asterisk)
 		{
-			outWriteDataType = ANY_VALUE_TYPE;
+			outWriteDataType = anyValueTypeId;
 			return PDereferencePtr(lexNode);
 		}
 
@@ -1158,7 +1362,7 @@ namespace Tolo
 		return nullptr;
 	}
 
-	Parser::SharedExp Parser::PVariablePtr(const SharedNode& lexNode, std::string& outWriteDataType)
+	Parser::ExpPtr Parser::PVariablePtr(NodePtr lexNode, SymbolId& outWriteDataType)
 	{
 		const std::string& varName = lexNode->token.text;
 
@@ -1169,12 +1373,12 @@ namespace Tolo
 		);
 
 		const VariableInfo& varInfo = p_currentFunction->varNameToVarInfo.at(varName);
-		outWriteDataType = varInfo.typeName;
+		outWriteDataType = varInfo.typeId;
 
-		return std::make_shared<ELoadVariablePtr>(varInfo.offset);
+		return p_arena->New<ELoadVariablePtr>(varInfo.offset);
 	}
 
-	Parser::SharedExp Parser::PMemberAccessPtr(const SharedNode& lexNode, std::string& outWriteDataType)
+	Parser::ExpPtr Parser::PMemberAccessPtr(NodePtr lexNode, SymbolId& outWriteDataType)
 	{
 		const std::string& varName = lexNode->token.text;
 
@@ -1186,66 +1390,72 @@ namespace Tolo
 
 		const VariableInfo& varInfo = p_currentFunction->varNameToVarInfo.at(varName);
 
-		auto loadMembPtrExp = std::make_shared<ELoadMulti>();
-		std::string parentStructType = varInfo.typeName;
+		auto loadMembPtrExp = p_arena->New<ELoadMulti>();
+		SymbolId parentStructType = varInfo.typeId;
 
 		// load variable pointer
-		if (ptrTypeNameToStructTypeName.count(varInfo.typeName) != 0)
+		auto ptrIt = ptrTypeIdToStructTypeId.find(varInfo.typeId);
+
+		if (ptrIt != ptrTypeIdToStructTypeId.end())
 		{
 			// variable is struct pointer
-			parentStructType = ptrTypeNameToStructTypeName.at(varInfo.typeName);
-			loadMembPtrExp->loaders.push_back(std::make_shared<ELoadVariable>(varInfo.offset, static_cast<Int>(sizeof(Ptr))));
+			parentStructType = ptrIt->second;
+			loadMembPtrExp->loaders.push_back(p_arena->New<ELoadVariable>(varInfo.offset, static_cast<Int>(sizeof(Ptr))));
 		}
 		else
 		{
 			Affirm(
-				typeNameToStructInfo.count(varInfo.typeName) != 0,
+				typeIdToStructInfo.count(varInfo.typeId) != 0,
 				"type '%s' at line %i is not a struct",
-				varInfo.typeName.c_str(), lexNode->token.line
+				GetTypeName(varInfo.typeId).c_str(), lexNode->token.line
 			);
 
 			// variable is struct value
-			loadMembPtrExp->loaders.push_back(std::make_shared<ELoadVariablePtr>(varInfo.offset));
+			loadMembPtrExp->loaders.push_back(p_arena->New<ELoadVariablePtr>(varInfo.offset));
 		}
 
 		// traverse dot chain to reach final pointer
-		for (const SharedNode& membNode : lexNode->children)
+		for (NodePtr membNode : lexNode->children)
 		{
+			auto structIt = typeIdToStructInfo.find(parentStructType);
+
 			Affirm(
-				typeNameToStructInfo.count(parentStructType),
+				structIt != typeIdToStructInfo.end(),
 				"type '%s' at line %i is not a struct",
-				parentStructType.c_str(), membNode->token.line
+				GetTypeName(parentStructType).c_str(), membNode->token.line
 			);
 
-			const StructInfo& parentStructInfo = typeNameToStructInfo.at(parentStructType);
+			const StructInfo& parentStructInfo = structIt->second;
+			auto membIt = parentStructInfo.memberIdToVarInfo.find(GetSymbol(membNode->token));
 
 			Affirm(
-				parentStructInfo.memberNameToVarInfo.count(membNode->token.text) != 0,
+				membIt != parentStructInfo.memberIdToVarInfo.end(),
 				"'%s' at line %i is not a member of struct '%s'",
-				membNode->token.text.c_str(), membNode->token.line, parentStructType.c_str()
+				membNode->token.text.c_str(), membNode->token.line, GetTypeName(parentStructType).c_str()
 			);
 
-			const VariableInfo& membInfo = parentStructInfo.memberNameToVarInfo.at(membNode->token.text);
+			const VariableInfo& membInfo = membIt->second;
+			ptrIt = ptrTypeIdToStructTypeId.find(membInfo.typeId);
 
-			if (ptrTypeNameToStructTypeName.count(membInfo.typeName) != 0)
+			if (ptrIt != ptrTypeIdToStructTypeId.end())
 			{
 				// member is struct pointer
-				parentStructType = ptrTypeNameToStructTypeName.at(membInfo.typeName);
+				parentStructType = ptrIt->second;
 
 				// push member variable address
-				loadMembPtrExp->loaders.push_back(std::make_shared<ELoadConstInt>(membInfo.offset));
-				loadMembPtrExp->loaders.push_back(std::make_shared<EPtrAdd>());
+				loadMembPtrExp->loaders.push_back(p_arena->New<ELoadConstInt>(membInfo.offset));
+				loadMembPtrExp->loaders.push_back(p_arena->New<EPtrAdd>());
 				// push pointer stored in member variable
-				loadMembPtrExp->loaders.push_back(std::make_shared<ELoadPtrFromStackTopPtr>());
+				loadMembPtrExp->loaders.push_back(p_arena->New<ELoadPtrFromStackTopPtr>());
 			}
 			else
 			{
 				// member is struct value
-				parentStructType = membInfo.typeName;
+				parentStructType = membInfo.typeId;
 
 				// push member variable address
-				loadMembPtrExp->loaders.push_back(std::make_shared<ELoadConstInt>(membInfo.offset));
-				loadMembPtrExp->loaders.push_back(std::make_shared<EPtrAdd>());
+				loadMembPtrExp->loaders.push_back(p_arena->New<ELoadConstInt>(membInfo.offset));
+				loadMembPtrExp->loaders.push_back(p_arena->New<EPtrAdd>());
 			}
 		}
 
@@ -1254,14 +1464,14 @@ namespace Tolo
 		return loadMembPtrExp;
 	}
 
-	Parser::SharedExp Parser::PDereferencePtr(const SharedNode& lexNode) 
+	Parser::ExpPtr Parser::PDereferencePtr(NodePtr lexNode) 
 	{
-		currentExpectedReturnType = "ptr";
+		currentExpectedReturnType = ptrTypeId;
 		return PReadableValue(lexNode->children[0]);
-		currentExpectedReturnType = "void";
+		currentExpectedReturnType = voidTypeId;
 	}
 
-	Parser::SharedExp Parser::PReadableValue(const SharedNode& lexNode, std::string& outReadDataType)
+	Parser::ExpPtr Parser::PReadableValue(NodePtr lexNode, SymbolId& outReadDataType)
 	{
 		switch (lexNode->type)
 		{
@@ -1292,66 +1502,66 @@ namespace Tolo
 		return nullptr;
 	}
 
-	Parser::SharedExp Parser::PReadableValue(const SharedNode& lexNode)
+	Parser::ExpPtr Parser::PReadableValue(NodePtr lexNode)
 	{
-		std::string unused;
+		SymbolId unused = INVALID_SYMBOL;
 		return PReadableValue(lexNode, unused);
 	}
 
-	Parser::SharedExp Parser::PLiteralConstantValue(const SharedNode& lexNode, std::string& outReadDataType)
+	Parser::ExpPtr Parser::PLiteralConstantValue(NodePtr lexNode, SymbolId& outReadDataType)
 	{
 		if (lexNode->token.type == Token::Type::ConstChar)
 		{
-			AffirmCurrentType("char", lexNode->token.line);
-			outReadDataType = "char";
+			AffirmCurrentType(charTypeId, lexNode->token.line);
+			outReadDataType = charTypeId;
 
 			Char value = lexNode->token.text[0];
-			return std::make_shared<ELoadConstChar>(value);
+			return p_arena->New<ELoadConstChar>(value);
 		}
 		if (lexNode->token.type == Token::Type::ConstInt)
 		{
-			AffirmCurrentType("int", lexNode->token.line);
-			outReadDataType = "int";
+			AffirmCurrentType(intTypeId, lexNode->token.line);
+			outReadDataType = intTypeId;
 
 			Int value = std::stoi(lexNode->token.text);
-			return std::make_shared<ELoadConstInt>(value);
+			return p_arena->New<ELoadConstInt>(value);
 		}
 		if (lexNode->token.type == Token::Type::ConstFloat)
 		{
-			AffirmCurrentType("float", lexNode->token.line);
-			outReadDataType = "float";
+			AffirmCurrentType(floatTypeId, lexNode->token.line);
+			outReadDataType = floatTypeId;
 
 			Float value = std::stof(lexNode->token.text);
-			return std::make_shared<ELoadConstFloat>(value);
+			return p_arena->New<ELoadConstFloat>(value);
 		}
 		if (lexNode->token.type == Token::Type::ConstString)
 		{
-			AffirmCurrentType("ptr", lexNode->token.line);
-			outReadDataType = "ptr";
+			AffirmCurrentType(ptrTypeId, lexNode->token.line);
+			outReadDataType = ptrTypeId;
 
 			const std::string& value = lexNode->token.text;
-			return std::make_shared<ELoadConstString>(value);
+			return p_arena->New<ELoadConstString>(value);
 		}
 
 		return nullptr;
 	}
 
-	Parser::SharedExp Parser::PVariableValue(const SharedNode& lexNode, std::string& outReadDataType) 
+	Parser::ExpPtr Parser::PVariableValue(NodePtr lexNode, SymbolId& outReadDataType) 
 	{
 		const std::string& varName = lexNode->token.text;
 
 		if (varName == "nullptr")
 		{
-			AffirmCurrentType("ptr", lexNode->token.line);
-			outReadDataType = "ptr";
-			return std::make_shared<ELoadConstPtr>(nullptr);
+			AffirmCurrentType(ptrTypeId, lexNode->token.line);
+			outReadDataType = ptrTypeId;
+			return p_arena->New<ELoadConstPtr>(nullptr);
 		}
 
 		if (nameToEnumValue.count(varName) != 0)
 		{
-			AffirmCurrentType("int", lexNode->token.line);
-			outReadDataType = "int";
-			return std::make_shared<ELoadConstInt>(nameToEnumValue.at(varName));
+			AffirmCurrentType(intTypeId, lexNode->token.line);
+			outReadDataType = intTypeId;
+			return p_arena->New<ELoadConstInt>(nameToEnumValue.at(varName));
 		}
 
 		Affirm(
@@ -1362,70 +1572,72 @@ namespace Tolo
 
 		const VariableInfo& info = p_currentFunction->varNameToVarInfo.at(varName);
 
-		AffirmCurrentType(info.typeName, lexNode->token.line);
-		outReadDataType = info.typeName;
+		AffirmCurrentType(info.typeId, lexNode->token.line);
+		outReadDataType = info.typeId;
 
-		return std::make_shared<ELoadVariable>(info.offset, typeNameToSize[info.typeName]);
+		return p_arena->New<ELoadVariable>(info.offset, typeIdToSize[info.typeId]);
 	}
 
-	Parser::SharedExp Parser::PMemberAccessValue(const SharedNode& lexNode, std::string& outReadDataType)
+	Parser::ExpPtr Parser::PMemberAccessValue(NodePtr lexNode, SymbolId& outReadDataType)
 	{
 		auto membPtrLoadExp = PMemberAccessPtr(lexNode, outReadDataType);
 		AffirmCurrentType(outReadDataType, lexNode->token.line);
 
-		auto membValLoadExp = std::make_shared<ELoadBytesFromPtr>(typeNameToSize.at(outReadDataType));
+		auto membValLoadExp = p_arena->New<ELoadBytesFromPtr>(typeIdToSize.at(outReadDataType));
 		membValLoadExp->ptrLoad = membPtrLoadExp;
 
 		return membValLoadExp;
 	}
 
-	Parser::SharedExp Parser::PBinaryMathOp(const SharedNode& lexNode, std::string& outReadDataType)
+	Parser::ExpPtr Parser::PBinaryMathOp(NodePtr lexNode, SymbolId& outReadDataType)
 	{
-		std::string lhsTypeName;
-		auto lhsExp = PReadableValue(lexNode->children[0], lhsTypeName);
+		SymbolId lhsTypeId = INVALID_SYMBOL;
+		auto lhsExp = PReadableValue(lexNode->children[0], lhsTypeId);
 
-		AffirmCurrentType(lhsTypeName, lexNode->token.line);
-		outReadDataType = lhsTypeName;
+		AffirmCurrentType(lhsTypeId, lexNode->token.line);
+		outReadDataType = lhsTypeId;
 
-		std::string oldRetType = currentExpectedReturnType;
-		currentExpectedReturnType = ANY_VALUE_TYPE;
+		SymbolId oldRetType = currentExpectedReturnType;
+		currentExpectedReturnType = anyValueTypeId;
 
-		std::string rhsTypeName;
-		auto rhsExp = PReadableValue(lexNode->children[1], rhsTypeName);
+		SymbolId rhsTypeId = INVALID_SYMBOL;
+		auto rhsExp = PReadableValue(lexNode->children[1], rhsTypeId);
 
 		currentExpectedReturnType = oldRetType;
 
 		const std::string& opName = lexNode->token.text;
-		std::string funcHash = GetFunctionHash(lhsTypeName, "operator::" + opName, { lhsTypeName, rhsTypeName });
+		const FunctionEntry* p_function = FindFunction(lhsTypeId, p_symbols->Intern("operator::" + opName), { lhsTypeId, rhsTypeId });
 
-		if (hashToUserFunctions.count(funcHash) != 0)
+		if (p_function != nullptr && p_function->p_userFunction != nullptr)
 		{
-			const FunctionInfo& funcInfo = hashToUserFunctions.at(funcHash);
+			const FunctionInfo& funcInfo = *p_function->p_userFunction;
+			const std::string& funcHash = p_function->hash;
 			
-			AffirmCurrentType(funcInfo.returnTypeName, lexNode->token.line);
+			AffirmCurrentType(p_function->returnTypeId, lexNode->token.line);
 
-			auto callOpExp = std::make_shared<ECallFunction>(funcInfo.parametersSize, funcInfo.localsSize);
+			auto callOpExp = p_arena->New<ECallFunction>(funcInfo.parametersSize, funcInfo.localsSize);
 			callOpExp->argumentLoads.push_back(lhsExp);
 			callOpExp->argumentLoads.push_back(rhsExp);
-			callOpExp->functionIpLoad = std::make_shared<ELoadConstPtrToLabel>(funcHash);
+			callOpExp->functionIpLoad = p_arena->New<ELoadConstPtrToLabel>(funcHash);
 
 			return callOpExp;
 		}
-		if (hashToNativeFunctions.count(funcHash) != 0)
+		if (p_function != nullptr && p_function->p_nativeFunction != nullptr)
 		{
-			const NativeFunctionInfo& funcInfo = hashToNativeFunctions.at(funcHash);
+			const NativeFunctionInfo& funcInfo = *p_function->p_nativeFunction;
+			const std::string& funcHash = p_function->hash;
 
-			AffirmCurrentType(funcInfo.returnTypeName, lexNode->token.line);
+			AffirmCurrentType(p_function->returnTypeId, lexNode->token.line);
 
-			auto callNativeOpExp = std::make_shared<ECallNativeFunction>();
+			auto callNativeOpExp = p_arena->New<ECallNativeFunction>();
 			callNativeOpExp->argumentLoads.push_back(lhsExp);
 			callNativeOpExp->argumentLoads.push_back(rhsExp);
-			callNativeOpExp->functionPtrLoad = std::make_shared<ELoadConstPtr>(funcInfo.p_functionPtr);
+			callNativeOpExp->functionPtrLoad = p_arena->New<ELoadNativeFunctionPtr>(funcHash, funcInfo.p_functionPtr);
 
 			return callNativeOpExp;
 		}
 
-		static std::map<Token::Type, size_t> opTypeToOpIndex
+		static const std::map<Token::Type, size_t> opTypeToOpIndex
 		{
 			{Token::Type::Plus, 0},
 			{Token::Type::Minus, 1},
@@ -1438,43 +1650,45 @@ namespace Tolo
 			{Token::Type::DoubleRightArrow, 8}
 		};
 
-		AffirmCurrentType(lhsTypeName, lexNode->token.line);
+		AffirmCurrentType(lhsTypeId, lexNode->token.line);
+
+		auto operatorsIt = typeIdOperators.find(lhsTypeId);
 
 		Affirm(
-			typeNameOperators.count(lhsTypeName) != 0,
+			operatorsIt != typeIdOperators.end(),
 			"cannot perform binary math operation '%s' on operand of type '%s' at line %i",
-			lexNode->token.text.c_str(), lhsTypeName.c_str(), lexNode->token.line
+			lexNode->token.text.c_str(), GetTypeName(lhsTypeId).c_str(), lexNode->token.line
 		);
 
-		OpCode opCode = typeNameOperators[lhsTypeName][opTypeToOpIndex[lexNode->token.type]];
+		OpCode opCode = operatorsIt->second[opTypeToOpIndex.at(lexNode->token.type)];
 
 		Affirm(
 			opCode != OpCode::INVALID,
 			"cannot perform binary math operation '%s' on operand of type '%s' at line %i",
-			lexNode->token.text.c_str(), lhsTypeName.c_str(), lexNode->token.line
+			lexNode->token.text.c_str(), GetTypeName(lhsTypeId).c_str(), lexNode->token.line
 		);
 
-		if (lhsTypeName == "ptr" ||
+		if (lhsTypeId == ptrTypeId ||
 			lexNode->token.type == Token::Type::DoubleLeftArrow ||
 			lexNode->token.type == Token::Type::DoubleRightArrow)
 		{
 			Affirm(
-				rhsTypeName == "int",
+				rhsTypeId == intTypeId,
 				"expected int expression at line %i",
 				lexNode->token.line
 			);
 		}
 
-		auto binMathOpExp = std::make_shared<EBinaryOp>(opCode);
+		auto binMathOpExp = p_arena->New<EBinaryOp>(opCode);
 		binMathOpExp->lhsLoad = lhsExp;
 		binMathOpExp->rhsLoad = rhsExp;
 
 		return binMathOpExp;
 	}
 
-	Parser::SharedExp Parser::PBinaryCompareOp(const SharedNode& lexNode, std::string& outReadDataType) 
+	Parser::ExpPtr Parser::PBinaryCompareOp(NodePtr lexNode, SymbolId& outReadDataType) 
 	{
-		static std::map<Token::Type, size_t> opTypeToOpIndex
+		static const std::map<Token::Type, size_t> opTypeToOpIndex
 		{
 			{Token::Type::LeftArrow, 9},
 			{Token::Type::RightArrow, 10},
@@ -1486,83 +1700,87 @@ namespace Tolo
 			{Token::Type::DoubleVerticalBar, 16}
 		};
 
-		AffirmCurrentType("char", lexNode->token.line);
-		outReadDataType = "char";
+		AffirmCurrentType(charTypeId, lexNode->token.line);
+		outReadDataType = charTypeId;
 
 		// determine operand data type
-		std::string oldRetType = currentExpectedReturnType;
-		currentExpectedReturnType = ANY_VALUE_TYPE;
+		SymbolId oldRetType = currentExpectedReturnType;
+		currentExpectedReturnType = anyValueTypeId;
 
-		std::string lhsTypeName;
-		auto lhsExp = PReadableValue(lexNode->children[0], lhsTypeName);
+		SymbolId lhsTypeId = INVALID_SYMBOL;
+		auto lhsExp = PReadableValue(lexNode->children[0], lhsTypeId);
 
-		std::string rhsTypeName;
-		auto rhsExp = PReadableValue(lexNode->children[1], rhsTypeName);
+		SymbolId rhsTypeId = INVALID_SYMBOL;
+		auto rhsExp = PReadableValue(lexNode->children[1], rhsTypeId);
 
 		currentExpectedReturnType = oldRetType;
 
 		const std::string& opName = lexNode->token.text;
-		std::string funcHash = GetFunctionHash("char", "operator::" + opName, { lhsTypeName, rhsTypeName });
+		const FunctionEntry* p_function = FindFunction(charTypeId, p_symbols->Intern("operator::" + opName), { lhsTypeId, rhsTypeId });
 
-		if (hashToUserFunctions.count(funcHash) != 0)
+		if (p_function != nullptr && p_function->p_userFunction != nullptr)
 		{
-			const FunctionInfo& funcInfo = hashToUserFunctions.at(funcHash);
+			const FunctionInfo& funcInfo = *p_function->p_userFunction;
+			const std::string& funcHash = p_function->hash;
 
-			currentExpectedReturnType = "char";
-			AffirmCurrentType(funcInfo.returnTypeName, lexNode->token.line);
+			currentExpectedReturnType = charTypeId;
+			AffirmCurrentType(p_function->returnTypeId, lexNode->token.line);
 			currentExpectedReturnType = oldRetType;
 
-			auto callOpExp = std::make_shared<ECallFunction>(funcInfo.parametersSize, funcInfo.localsSize);
+			auto callOpExp = p_arena->New<ECallFunction>(funcInfo.parametersSize, funcInfo.localsSize);
 			callOpExp->argumentLoads.push_back(lhsExp);
 			callOpExp->argumentLoads.push_back(rhsExp);
-			callOpExp->functionIpLoad = std::make_shared<ELoadConstPtrToLabel>(funcHash);
+			callOpExp->functionIpLoad = p_arena->New<ELoadConstPtrToLabel>(funcHash);
 
 			return callOpExp;
 		}
-		if (hashToNativeFunctions.count(funcHash) != 0)
+		if (p_function != nullptr && p_function->p_nativeFunction != nullptr)
 		{
-			const NativeFunctionInfo& funcInfo = hashToNativeFunctions.at(funcHash);
+			const NativeFunctionInfo& funcInfo = *p_function->p_nativeFunction;
+			const std::string& funcHash = p_function->hash;
 
-			currentExpectedReturnType = "char";
-			AffirmCurrentType(funcInfo.returnTypeName, lexNode->token.line);
+			currentExpectedReturnType = charTypeId;
+			AffirmCurrentType(p_function->returnTypeId, lexNode->token.line);
 			currentExpectedReturnType = oldRetType;
 
-			auto callNativeOpExp = std::make_shared<ECallNativeFunction>();
+			auto callNativeOpExp = p_arena->New<ECallNativeFunction>();
 			callNativeOpExp->argumentLoads.push_back(lhsExp);
 			callNativeOpExp->argumentLoads.push_back(rhsExp);
-			callNativeOpExp->functionPtrLoad = std::make_shared<ELoadConstPtr>(funcInfo.p_functionPtr);
+			callNativeOpExp->functionPtrLoad = p_arena->New<ELoadNativeFunctionPtr>(funcHash, funcInfo.p_functionPtr);
 
 			return callNativeOpExp;
 		}
 
 		Affirm(
-			lhsTypeName == rhsTypeName,
+			lhsTypeId == rhsTypeId,
 			"cannot perform binary compare operation '%s' on operands of types '%s' and '%s' at line %i",
-			opName.c_str(), lhsTypeName.c_str(), rhsTypeName.c_str(), lexNode->token.line
+			opName.c_str(), GetTypeName(lhsTypeId).c_str(), GetTypeName(rhsTypeId).c_str(), lexNode->token.line
 		);
 
+		auto operatorsIt = typeIdOperators.find(lhsTypeId);
+
 		Affirm(
-			typeNameOperators.count(lhsTypeName) != 0,
+			operatorsIt != typeIdOperators.end(),
 			"cannot perform binary compare operation '%s' on operand of type '%s' at line %i",
-			opName.c_str(), lhsTypeName.c_str(), lexNode->token.line
+			opName.c_str(), GetTypeName(lhsTypeId).c_str(), lexNode->token.line
 		);
 
-		OpCode opCode = typeNameOperators.at(lhsTypeName)[opTypeToOpIndex[lexNode->token.type]];
+		OpCode opCode = operatorsIt->second[opTypeToOpIndex.at(lexNode->token.type)];
 
 		Affirm(
 			opCode != OpCode::INVALID,
 			"cannot perform binary compare operation '%s' on operand of type '%s' at line %i",
-			lexNode->token.text.c_str(), lhsTypeName.c_str(), lexNode->token.line
+			lexNode->token.text.c_str(), GetTypeName(lhsTypeId).c_str(), lexNode->token.line
 		);
 
-		auto binCompOpExp = std::make_shared<EBinaryOp>(opCode);
+		auto binCompOpExp = p_arena->New<EBinaryOp>(opCode);
 		binCompOpExp->lhsLoad = lhsExp;
 		binCompOpExp->rhsLoad = rhsExp;
 
 		return binCompOpExp;
 	}
 
-	Parser::SharedExp Parser::PUnaryOp(const SharedNode& lexNode, std::string& outReadDataType)
+	Parser::ExpPtr Parser::PUnaryOp(NodePtr lexNode, SymbolId& outReadDataType)
 	{
 		switch (lexNode->token.type)
 		{
@@ -1581,19 +1799,19 @@ namespace Tolo
 		return nullptr;
 	}
 
-	Parser::SharedExp Parser::PReferenceValue(const SharedNode& lexNode, std::string& outReadDataType)
+	Parser::ExpPtr Parser::PReferenceValue(NodePtr lexNode, SymbolId& outReadDataType)
 	{
-		AffirmCurrentType("ptr", lexNode->token.line);
-		outReadDataType = "ptr";
+		AffirmCurrentType(ptrTypeId, lexNode->token.line);
+		outReadDataType = ptrTypeId;
 
 		if (lexNode->children[0]->type == LexNode::Type::Identifier)
 		{
-			std::string dataType;
+			SymbolId dataType = INVALID_SYMBOL;
 			return PVariablePtr(lexNode->children[0], dataType);
 		}
 		if (lexNode->children[0]->type == LexNode::Type::MemberVariableAccess)
 		{
-			std::string dataType;
+			SymbolId dataType = INVALID_SYMBOL;
 			return PMemberAccessPtr(lexNode->children[0], dataType);
 		}
 
@@ -1606,123 +1824,125 @@ namespace Tolo
 		return nullptr;
 	}
 
-	Parser::SharedExp Parser::PDereferenceValue(const SharedNode& lexNode, std::string& outReadDataType)
+	Parser::ExpPtr Parser::PDereferenceValue(NodePtr lexNode, SymbolId& outReadDataType)
 	{
 		Affirm(
-			currentExpectedReturnType != ANY_VALUE_TYPE,
+			currentExpectedReturnType != anyValueTypeId,
 			"cannot dereference pointer when the expected value type is unknown at line %i",
 			lexNode->token.line
 		);
 
 		outReadDataType = currentExpectedReturnType;
-		auto loadBytes = std::make_shared<ELoadBytesFromPtr>(typeNameToSize.at(currentExpectedReturnType));
+		auto loadBytes = p_arena->New<ELoadBytesFromPtr>(typeIdToSize.at(currentExpectedReturnType));
 
-		std::string oldType = currentExpectedReturnType;
-		currentExpectedReturnType = "ptr";
+		SymbolId oldType = currentExpectedReturnType;
+		currentExpectedReturnType = ptrTypeId;
 		loadBytes->ptrLoad = PReadableValue(lexNode->children[0]);
 		currentExpectedReturnType = oldType;
 
 		return loadBytes;
 	}
 
-	Parser::SharedExp Parser::PNegate(const SharedNode& lexNode, std::string& outReadDataType)
+	Parser::ExpPtr Parser::PNegate(NodePtr lexNode, SymbolId& outReadDataType)
 	{
 		const size_t opIndex = 17;
 		const std::string opName = "negate";
 
-		std::string oldRetType = currentExpectedReturnType;
-		currentExpectedReturnType = ANY_VALUE_TYPE;
+		SymbolId oldRetType = currentExpectedReturnType;
+		currentExpectedReturnType = anyValueTypeId;
 
-		std::string paramTypeName;
-		auto valExp = PReadableValue(lexNode->children[0], paramTypeName);
+		SymbolId paramTypeId = INVALID_SYMBOL;
+		auto valExp = PReadableValue(lexNode->children[0], paramTypeId);
 
 		currentExpectedReturnType = oldRetType;
 		outReadDataType = currentExpectedReturnType;
 
-		std::string funcHash = GetFunctionHash(currentExpectedReturnType, "operator::" + opName, { paramTypeName });
+		const FunctionEntry* p_function = FindFunction(currentExpectedReturnType, p_symbols->Intern("operator::" + opName), { paramTypeId });
 
-		if (hashToUserFunctions.count(funcHash) != 0)
+		if (p_function != nullptr && p_function->p_userFunction != nullptr)
 		{
-			const FunctionInfo& funcInfo = hashToUserFunctions.at(funcHash);
+			const FunctionInfo& funcInfo = *p_function->p_userFunction;
+			const std::string& funcHash = p_function->hash;
 
-			auto callOpExp = std::make_shared<ECallFunction>(funcInfo.parametersSize, funcInfo.localsSize);
+			auto callOpExp = p_arena->New<ECallFunction>(funcInfo.parametersSize, funcInfo.localsSize);
 			callOpExp->argumentLoads.push_back(valExp);
-			callOpExp->functionIpLoad = std::make_shared<ELoadConstPtrToLabel>(funcHash);
+			callOpExp->functionIpLoad = p_arena->New<ELoadConstPtrToLabel>(funcHash);
 
 			return callOpExp;
 		}
-		if (hashToNativeFunctions.count(funcHash) != 0)
+		if (p_function != nullptr && p_function->p_nativeFunction != nullptr)
 		{
-			const NativeFunctionInfo& funcInfo = hashToNativeFunctions.at(funcHash);
+			const NativeFunctionInfo& funcInfo = *p_function->p_nativeFunction;
+			const std::string& funcHash = p_function->hash;
 
-			auto callNativeOpExp = std::make_shared<ECallNativeFunction>();
+			auto callNativeOpExp = p_arena->New<ECallNativeFunction>();
 			callNativeOpExp->argumentLoads.push_back(valExp);
-			callNativeOpExp->functionPtrLoad = std::make_shared<ELoadConstPtr>(funcInfo.p_functionPtr);
+			callNativeOpExp->functionPtrLoad = p_arena->New<ELoadNativeFunctionPtr>(funcHash, funcInfo.p_functionPtr);
 
 			return callNativeOpExp;
 		}
 
 		Affirm(
-			typeNameOperators.count(currentExpectedReturnType) != 0,
+			typeIdOperators.count(currentExpectedReturnType) != 0,
 			"cannot perform unary 'negate' on operand of type '%s' at line %i",
-			lexNode->token.text.c_str(), currentExpectedReturnType.c_str(), lexNode->token.line
+			lexNode->token.text.c_str(), GetTypeName(currentExpectedReturnType).c_str(), lexNode->token.line
 		);
 
-		OpCode opCode = typeNameOperators[currentExpectedReturnType][opIndex];
+		OpCode opCode = typeIdOperators[currentExpectedReturnType][opIndex];
 
 		Affirm(
 			opCode != OpCode::INVALID,
 			"cannot perform unary 'negate' on operand of type '%s' at line %i",
-			lexNode->token.text.c_str(), currentExpectedReturnType.c_str(), lexNode->token.line
+			lexNode->token.text.c_str(), GetTypeName(currentExpectedReturnType).c_str(), lexNode->token.line
 		);
 
-		auto unaryOpExp = std::make_shared<EUnaryOp>(opCode);
+		auto unaryOpExp = p_arena->New<EUnaryOp>(opCode);
 		unaryOpExp->valLoad = valExp;
 
 		return unaryOpExp;
 	}
 
-	Parser::SharedExp Parser::PNot(const SharedNode& lexNode, std::string& outReadDataType)
+	Parser::ExpPtr Parser::PNot(NodePtr lexNode, SymbolId& outReadDataType)
 	{
-		AffirmCurrentType("char", lexNode->token.line);
-		outReadDataType = "char";
+		AffirmCurrentType(charTypeId, lexNode->token.line);
+		outReadDataType = charTypeId;
 
-		auto unaryNotExp = std::make_shared<EUnaryOp>(OpCode::Not);
+		auto unaryNotExp = p_arena->New<EUnaryOp>(OpCode::Not);
 		unaryNotExp->valLoad = PReadableValue(lexNode->children[0]);
 
 		return unaryNotExp;
 	}
 
-	Parser::SharedExp Parser::PBitInvert(const SharedNode& lexNode, std::string& outReadDataType)
+	Parser::ExpPtr Parser::PBitInvert(NodePtr lexNode, SymbolId& outReadDataType)
 	{
 		const size_t opIndex = 18;
 
-		const std::string& retType = currentExpectedReturnType;
+		SymbolId retType = currentExpectedReturnType;
 		outReadDataType = retType;
 
 		Affirm(
-			typeNameOperators.count(retType) != 0 &&
-			typeNameOperators.at(retType)[opIndex] != OpCode::INVALID,
+			typeIdOperators.count(retType) != 0 &&
+			typeIdOperators.at(retType)[opIndex] != OpCode::INVALID,
 			"cannot perform unary 'bitwise invert' on operand of type '%s' at line %i",
-			retType.c_str(), lexNode->token.line
+			GetTypeName(retType).c_str(), lexNode->token.line
 		);
 
-		OpCode opCode = typeNameOperators.at(retType)[opIndex];
-		auto bitInvExp = std::make_shared<EUnaryOp>(opCode);
+		OpCode opCode = typeIdOperators.at(retType)[opIndex];
+		auto bitInvExp = p_arena->New<EUnaryOp>(opCode);
 
 		bitInvExp->valLoad = PReadableValue(lexNode->children[0]);
 
 		return bitInvExp;
 	}
 
-	Parser::SharedExp Parser::PFunctionCall(const SharedNode& lexNode, std::string& outReadDataType)
+	Parser::ExpPtr Parser::PFunctionCall(NodePtr lexNode, SymbolId& outReadDataType)
 	{
 		const std::string& funcName = lexNode->token.text;
 
 		if (funcName == "sizeof")
 		{
-			AffirmCurrentType("int", lexNode->token.line);
-			outReadDataType = "int";
+			AffirmCurrentType(intTypeId, lexNode->token.line);
+			outReadDataType = intTypeId;
 
 			Affirm(
 				lexNode->children.size() == 1 &&
@@ -1732,62 +1952,67 @@ namespace Tolo
 			);
 
 			const std::string& typeName = lexNode->children[0]->token.text;
+			auto sizeIt = typeIdToSize.find(GetSymbol(lexNode->children[0]->token));
 
 			Affirm(
-				typeNameToSize.count(typeName) != 0,
+				sizeIt != typeIdToSize.end(),
 				"'%s' at line %i is not a type name",
 				typeName.c_str(), lexNode->children[0]->token.line
 			);
 
-			return std::make_shared<ELoadConstInt>(typeNameToSize.at(typeName));
+			return p_arena->New<ELoadConstInt>(sizeIt->second);
 		}
 
-		if (typeNameToStructInfo.count(funcName) != 0)
+		SymbolId funcId = GetSymbol(lexNode->token);
+
+		if (typeIdToStructInfo.count(funcId) != 0)
 			return PStructInitialization(lexNode, outReadDataType);
 
-		if (ptrTypeNameToStructTypeName.count(funcName) != 0)
+		if (ptrTypeIdToStructTypeId.count(funcId) != 0)
 			return PStructPtrInitialization(lexNode, outReadDataType);
 
 		return PUserOrNativeFunctionCall(lexNode, outReadDataType);
 	}
 
-	Parser::SharedExp Parser::PUserOrNativeFunctionCall(const SharedNode& lexNode, std::string& outReadDataType)
+	Parser::ExpPtr Parser::PUserOrNativeFunctionCall(NodePtr lexNode, SymbolId& outReadDataType)
 	{
-		std::vector<std::string> argTypeNames;
-		std::vector<SharedExp> argumentLoads;
+		std::vector<SymbolId> argTypeIds;
+		std::vector<ExpPtr> argumentLoads;
 
-		std::string oldRetType = currentExpectedReturnType;
-		currentExpectedReturnType = ANY_VALUE_TYPE;
+		SymbolId oldRetType = currentExpectedReturnType;
+		currentExpectedReturnType = anyValueTypeId;
 
 		for (size_t i = 0; i < lexNode->children.size(); i++)
 		{
-			std::string argTypeName;
-			argumentLoads.push_back(PReadableValue(lexNode->children[i], argTypeName));
+			SymbolId argTypeId = INVALID_SYMBOL;
+			argumentLoads.push_back(PReadableValue(lexNode->children[i], argTypeId));
 
-			argTypeNames.push_back(argTypeName);
+			argTypeIds.push_back(argTypeId);
 		}
 
 		currentExpectedReturnType = oldRetType;
 		outReadDataType = currentExpectedReturnType;
 
 		const std::string& funcName = lexNode->token.text;
-		std::string funcHash = GetFunctionHash(currentExpectedReturnType, funcName, argTypeNames);
+		const FunctionEntry* p_function = FindFunction(currentExpectedReturnType, GetSymbol(lexNode->token), argTypeIds);
 
-		if (hashToUserFunctions.count(funcHash) != 0)
+		if (p_function != nullptr && p_function->p_userFunction != nullptr)
 		{
-			const FunctionInfo& funcInfo = hashToUserFunctions.at(funcHash);
-			auto callUserFuncExp = std::make_shared<ECallFunction>(funcInfo.parametersSize, funcInfo.localsSize);
+			const FunctionInfo& funcInfo = *p_function->p_userFunction;
+			const std::string& funcHash = p_function->hash;
+			auto callUserFuncExp = p_arena->New<ECallFunction>(funcInfo.parametersSize, funcInfo.localsSize);
 			callUserFuncExp->argumentLoads = argumentLoads;
-			callUserFuncExp->functionIpLoad = std::make_shared<ELoadConstPtrToLabel>(funcHash);
+			callUserFuncExp->functionIpLoad = p_arena->New<ELoadConstPtrToLabel>(funcHash);
 
 			return callUserFuncExp;
 		}
-		if (hashToNativeFunctions.count(funcHash) != 0)
+		if (p_function != nullptr && p_function->p_nativeFunction != nullptr)
 		{
-			const NativeFunctionInfo& funcInfo = hashToNativeFunctions.at(funcHash);
-			auto callNativeFuncExp = std::make_shared<ECallNativeFunction>();
+			const NativeFunctionInfo& funcInfo = *p_function->p_nativeFunction;
+			const std::string& funcHash = p_function->hash;
+			auto callNativeFuncExp = p_arena->New<ECallNativeFunction>();
 			callNativeFuncExp->argumentLoads = argumentLoads;
-			callNativeFuncExp->functionPtrLoad = std::make_shared<ELoadConstPtr>(funcInfo.p_functionPtr);
+			callNativeFuncExp->functionPtrLoad = p_arena->New<ELoadNativeFunctionPtr>(funcHash, funcInfo.p_functionPtr);
 
 			return callNativeFuncExp;
 		}
@@ -1795,23 +2020,24 @@ namespace Tolo
 		Affirm(
 			false,
 			"function signature '%s' at line %i does not match any existing functions",
-			funcHash.c_str(), lexNode->token.line
+			GetFunctionHash(GetTypeName(currentExpectedReturnType), funcName, GetTypeNames(argTypeIds)).c_str(), lexNode->token.line
 		);
 
 		return nullptr;
 	}
 
-	Parser::SharedExp Parser::PStructInitialization(const SharedNode& lexNode, std::string& outReadDataType)
+	Parser::ExpPtr Parser::PStructInitialization(NodePtr lexNode, SymbolId& outReadDataType)
 	{
 		const std::string& structName = lexNode->token.text;
-		AffirmCurrentType(structName, lexNode->token.line);
-		outReadDataType = structName;
+		SymbolId structId = GetSymbol(lexNode->token);
+		AffirmCurrentType(structId, lexNode->token.line);
+		outReadDataType = structId;
 
-		const StructInfo& structInfo = typeNameToStructInfo[structName];
+		const StructInfo& structInfo = typeIdToStructInfo[structId];
 
 		bool hasVTable = structNameToVTable.count(structName) != 0;
 
-		size_t requiredArgCount = structInfo.memberNameToVarInfo.size();
+		size_t requiredArgCount = structInfo.memberIdToVarInfo.size();
 		if (hasVTable)
 			requiredArgCount--;
 
@@ -1821,20 +2047,20 @@ namespace Tolo
 			structName.c_str(), lexNode->token.line
 		);
 
-		auto loadMultiExp = std::make_shared<ELoadMulti>();
+		auto loadMultiExp = p_arena->New<ELoadMulti>();
 
 		size_t argIndex = 0;
-		std::string oldRetType = currentExpectedReturnType;
+		SymbolId oldRetType = currentExpectedReturnType;
 
-		for (const std::string& membName : structInfo.memberNames)
+		for (SymbolId membId : structInfo.memberIds)
 		{
-			if (hasVTable && membName == "virtual")
+			if (hasVTable && membId == virtualMemberId)
 			{
-				loadMultiExp->loaders.push_back(std::make_shared<ELoadVTablePtr>(structName));
+				loadMultiExp->loaders.push_back(p_arena->New<ELoadVTablePtr>(structName));
 			}
 			else
 			{
-				currentExpectedReturnType = structInfo.memberNameToVarInfo.at(membName).typeName;
+				currentExpectedReturnType = structInfo.memberIdToVarInfo.at(membId).typeId;
 				loadMultiExp->loaders.push_back(PReadableValue(lexNode->children[argIndex]));
 				argIndex++;
 			}
@@ -1845,11 +2071,12 @@ namespace Tolo
 		return loadMultiExp;
 	}
 
-	Parser::SharedExp Parser::PStructPtrInitialization(const SharedNode& lexNode, std::string& outReadDataType)
+	Parser::ExpPtr Parser::PStructPtrInitialization(NodePtr lexNode, SymbolId& outReadDataType)
 	{
 		const std::string& funcName = lexNode->token.text;
-		AffirmCurrentType(funcName, lexNode->token.line);
-		outReadDataType = funcName;
+		SymbolId structPtrId = GetSymbol(lexNode->token);
+		AffirmCurrentType(structPtrId, lexNode->token.line);
+		outReadDataType = structPtrId;
 
 		Affirm(
 			lexNode->children.size() == 1,
@@ -1857,17 +2084,17 @@ namespace Tolo
 			funcName.c_str(), lexNode->token.line
 		);
 
-		auto loadMultiExp = std::make_shared<ELoadMulti>();
+		auto loadMultiExp = p_arena->New<ELoadMulti>();
 
-		std::string oldRetType = currentExpectedReturnType;
-		currentExpectedReturnType = ANY_VALUE_TYPE;
+		SymbolId oldRetType = currentExpectedReturnType;
+		currentExpectedReturnType = anyValueTypeId;
 
-		std::string ptrType;
+		SymbolId ptrType = INVALID_SYMBOL;
 		loadMultiExp->loaders.push_back(PReadableValue(lexNode->children[0], ptrType));
 
 		Affirm(
-			ptrType == "ptr" ||
-			ptrTypeNameToStructTypeName.count(ptrType) != 0,
+			ptrType == ptrTypeId ||
+			ptrTypeIdToStructTypeId.count(ptrType) != 0,
 			"expected pointer type in struct pointer initializer at line %i",
 			lexNode->children[0]->token.line
 		);
@@ -1877,34 +2104,34 @@ namespace Tolo
 		return loadMultiExp;
 	}
 
-	Parser::SharedExp Parser::PMemberFunctionCall(const SharedNode& lexNode, std::string& outReadDataType)
+	Parser::ExpPtr Parser::PMemberFunctionCall(NodePtr lexNode, SymbolId& outReadDataType)
 	{
 		const std::string& varName = lexNode->token.text;
 		VariableInfo varInfo;
 		bool callerIsBasePointer = false;
 
 		// handle member function call using "base" variable
-		if (p_currentFunction->invokerStructTypeName.size() > 0 && varName == "base")
+		if (p_currentFunction->invokerStructTypeId != INVALID_SYMBOL && varName == "base")
 		{
 			Affirm(
-				structNameToParentStructName.count(p_currentFunction->invokerStructTypeName) != 0,
+				structIdToParentStructId.count(p_currentFunction->invokerStructTypeId) != 0,
 				"cannot use 'base'-pointer, struct of type '%s' at line %i does not derive from a base struct",
-				p_currentFunction->invokerStructTypeName.c_str(), lexNode->token.line
+				GetTypeName(p_currentFunction->invokerStructTypeId).c_str(), lexNode->token.line
 			);
 
-			const std::string& baseStructTypeName = 
-				structNameToParentStructName.at(p_currentFunction->invokerStructTypeName);
+			SymbolId baseStructTypeId = 
+				structIdToParentStructId.at(p_currentFunction->invokerStructTypeId);
 
 			Affirm(
 				lexNode->children.size() == 1 &&
-				structNameToVTable.count(baseStructTypeName) != 0,
+				structNameToVTable.count(GetTypeName(baseStructTypeId)) != 0,
 				"'base'-pointer at line %i can only be used to call the base struct's version of a virtual member function",
 				lexNode->token.line
 			);
 
 			callerIsBasePointer = true;
 			varInfo = p_currentFunction->varNameToVarInfo.at("this");
-			varInfo.typeName = baseStructTypeName + "::ptr";
+			varInfo.typeId = structTypeIdToPtrTypeId.at(baseStructTypeId);
 		}
 		// default
 		else
@@ -1918,88 +2145,100 @@ namespace Tolo
 			varInfo = p_currentFunction->varNameToVarInfo.at(varName);
 		}
 
-		auto loadCallerPtrExp = std::make_shared<ELoadMulti>();
-		std::string structType = varInfo.typeName;
+		auto loadCallerPtrExp = p_arena->New<ELoadMulti>();
+		SymbolId structType = varInfo.typeId;
 
 		// load variable pointer
-		if (ptrTypeNameToStructTypeName.count(varInfo.typeName) != 0)
+		auto ptrIt = ptrTypeIdToStructTypeId.find(varInfo.typeId);
+
+		if (ptrIt != ptrTypeIdToStructTypeId.end())
 		{
 			// variable is struct pointer
-			structType = ptrTypeNameToStructTypeName.at(varInfo.typeName);
-			loadCallerPtrExp->loaders.push_back(std::make_shared<ELoadVariable>(varInfo.offset, static_cast<Int>(sizeof(Ptr))));
+			structType = ptrIt->second;
+			loadCallerPtrExp->loaders.push_back(p_arena->New<ELoadVariable>(varInfo.offset, static_cast<Int>(sizeof(Ptr))));
 		}
 		else
 		{
 			Affirm(
-				typeNameToStructInfo.count(varInfo.typeName) != 0,
+				typeIdToStructInfo.count(varInfo.typeId) != 0,
 				"type '%s' at line %i is not a struct",
-				varInfo.typeName.c_str(), lexNode->token.line
+				GetTypeName(varInfo.typeId).c_str(), lexNode->token.line
 			);
 
 			// variable is struct value
-			loadCallerPtrExp->loaders.push_back(std::make_shared<ELoadVariablePtr>(varInfo.offset));
+			loadCallerPtrExp->loaders.push_back(p_arena->New<ELoadVariablePtr>(varInfo.offset));
 		}
 
 		// traverse dot chain to next last to reach caller's pointer
 		for (size_t i=0; i+1<lexNode->children.size(); i++)
 		{
-			const SharedNode& membNode = lexNode->children[i];
+			NodePtr membNode = lexNode->children[i];
+
+			auto structIt = typeIdToStructInfo.find(structType);
 
 			Affirm(
-				typeNameToStructInfo.count(structType),
+				structIt != typeIdToStructInfo.end(),
 				"type '%s' at line %i is not a struct",
-				structType.c_str(), membNode->token.line
+				GetTypeName(structType).c_str(), membNode->token.line
 			);
 
-			const StructInfo& parentStructInfo = typeNameToStructInfo.at(structType);
+			const StructInfo& parentStructInfo = structIt->second;
+			auto membIt = parentStructInfo.memberIdToVarInfo.find(GetSymbol(membNode->token));
 
 			Affirm(
-				parentStructInfo.memberNameToVarInfo.count(membNode->token.text) != 0,
+				membIt != parentStructInfo.memberIdToVarInfo.end(),
 				"'%s' at line %i is not a member of struct '%s'",
-				membNode->token.text.c_str(), membNode->token.line, structType.c_str()
+				membNode->token.text.c_str(), membNode->token.line, GetTypeName(structType).c_str()
 			);
 
-			const VariableInfo& membInfo = parentStructInfo.memberNameToVarInfo.at(membNode->token.text);
+			const VariableInfo& membInfo = membIt->second;
+			ptrIt = ptrTypeIdToStructTypeId.find(membInfo.typeId);
 
-			if (ptrTypeNameToStructTypeName.count(membInfo.typeName) != 0)
+			if (ptrIt != ptrTypeIdToStructTypeId.end())
 			{
 				// member is struct pointer
-				structType = ptrTypeNameToStructTypeName.at(membInfo.typeName);
+				structType = ptrIt->second;
 
 				// push member variable address
-				loadCallerPtrExp->loaders.push_back(std::make_shared<ELoadConstInt>(membInfo.offset));
-				loadCallerPtrExp->loaders.push_back(std::make_shared<EPtrAdd>());
+				loadCallerPtrExp->loaders.push_back(p_arena->New<ELoadConstInt>(membInfo.offset));
+				loadCallerPtrExp->loaders.push_back(p_arena->New<EPtrAdd>());
 				// push pointer stored in member variable
-				loadCallerPtrExp->loaders.push_back(std::make_shared<ELoadPtrFromStackTopPtr>());
+				loadCallerPtrExp->loaders.push_back(p_arena->New<ELoadPtrFromStackTopPtr>());
 			}
 			else
 			{
 				// member is struct value
-				structType = membInfo.typeName;
+				structType = membInfo.typeId;
 
 				// push member variable address
-				loadCallerPtrExp->loaders.push_back(std::make_shared<ELoadConstInt>(membInfo.offset));
-				loadCallerPtrExp->loaders.push_back(std::make_shared<EPtrAdd>());
+				loadCallerPtrExp->loaders.push_back(p_arena->New<ELoadConstInt>(membInfo.offset));
+				loadCallerPtrExp->loaders.push_back(p_arena->New<EPtrAdd>());
 			}
 		}
 
-		const SharedNode& funcNode = lexNode->children.back();
-		std::vector<std::string> argTypeNames;
-		std::vector<SharedExp> argumentLoads;
+		Affirm(
+			structTypeIdToPtrTypeId.count(structType) != 0,
+			"type '%s' at line %i is not a struct",
+			GetTypeName(structType).c_str(), lexNode->token.line
+		);
+
+		NodePtr funcNode = lexNode->children.back();
+		std::vector<SymbolId> argTypeIds;
+		std::vector<ExpPtr> argumentLoads;
 
 		// add "this"-ptr
-		argTypeNames.push_back(structType + "::ptr");
+		argTypeIds.push_back(structTypeIdToPtrTypeId.at(structType));
 		argumentLoads.push_back(loadCallerPtrExp);
 
-		std::string oldRetType = currentExpectedReturnType;
-		currentExpectedReturnType = ANY_VALUE_TYPE;
+		SymbolId oldRetType = currentExpectedReturnType;
+		currentExpectedReturnType = anyValueTypeId;
 
 		for (size_t i = 0; i < funcNode->children.size(); i++)
 		{
-			std::string argTypeName;
-			argumentLoads.push_back(PReadableValue(funcNode->children[i], argTypeName));
+			SymbolId argTypeId = INVALID_SYMBOL;
+			argumentLoads.push_back(PReadableValue(funcNode->children[i], argTypeId));
 
-			argTypeNames.push_back(argTypeName);
+			argTypeIds.push_back(argTypeId);
 		}
 
 		currentExpectedReturnType = oldRetType;
@@ -2008,48 +2247,45 @@ namespace Tolo
 		while (true)
 		{
 			std::string funcName;
-			std::string funcHash;
 
 			if (callerIsBasePointer)
-			{
-				funcName = structType + "::0virtual_" + funcNode->token.text;
-				funcHash = GetFunctionHash(currentExpectedReturnType, funcName, argTypeNames);
-			}
+				funcName = GetTypeName(structType) + "::0virtual_" + funcNode->token.text;
 			else
-			{
-				funcName = structType + "::" + funcNode->token.text;
-				funcHash = GetFunctionHash(currentExpectedReturnType, funcName, argTypeNames);
-			}
+				funcName = GetTypeName(structType) + "::" + funcNode->token.text;
+
+			const FunctionEntry* p_function = FindFunction(currentExpectedReturnType, p_symbols->Intern(funcName), argTypeIds);
 
-			if (hashToUserFunctions.count(funcHash) != 0)
+			if (p_function != nullptr && p_function->p_userFunction != nullptr)
 			{
-				const FunctionInfo& funcInfo = hashToUserFunctions.at(funcHash);
-				auto callUserFuncExp = std::make_shared<ECallFunction>(funcInfo.parametersSize, funcInfo.localsSize);
+				const FunctionInfo& funcInfo = *p_function->p_userFunction;
+				const std::string& funcHash = p_function->hash;
+				auto callUserFuncExp = p_arena->New<ECallFunction>(funcInfo.parametersSize, funcInfo.localsSize);
 				callUserFuncExp->argumentLoads = argumentLoads;
-				callUserFuncExp->functionIpLoad = std::make_shared<ELoadConstPtrToLabel>(funcHash);
+				callUserFuncExp->functionIpLoad = p_arena->New<ELoadConstPtrToLabel>(funcHash);
 
 				return callUserFuncExp;
 			}
-			if (hashToNativeFunctions.count(funcHash) != 0)
+			if (p_function != nullptr && p_function->p_nativeFunction != nullptr)
 			{
-				const NativeFunctionInfo& funcInfo = hashToNativeFunctions.at(funcHash);
-				auto callNativeFuncExp = std::make_shared<ECallNativeFunction>();
+				const NativeFunctionInfo& funcInfo = *p_function->p_nativeFunction;
+				const std::string& funcHash = p_function->hash;
+				auto callNativeFuncExp = p_arena->New<ECallNativeFunction>();
 				callNativeFuncExp->argumentLoads = argumentLoads;
-				callNativeFuncExp->functionPtrLoad = std::make_shared<ELoadConstPtr>(funcInfo.p_functionPtr);
+				callNativeFuncExp->functionPtrLoad = p_arena->New<ELoadNativeFunctionPtr>(funcHash, funcInfo.p_functionPtr);
 
 				return callNativeFuncExp;
 			}
 
 			Affirm(
-				callerIsBasePointer || structNameToParentStructName.count(structType) != 0,
+				callerIsBasePointer || structIdToParentStructId.count(structType) != 0,
 				"function signature '%s' at line %i does not match any existing functions",
-				funcHash.c_str(), lexNode->token.line
+				GetFunctionHash(GetTypeName(currentExpectedReturnType), funcName, GetTypeNames(argTypeIds)).c_str(), lexNode->token.line
 			);
 
 			// try parent type
-			structType = structNameToParentStructName.at(structType);
-			// change "this"-ptr type name
-			argTypeNames[0] = structType + "::ptr";
+			structType = structIdToParentStructId.at(structType);
+			// change "this"-ptr type
+			argTypeIds[0] = structTypeIdToPtrTypeId.at(structType);
 		}
 
 		return nullptr;
@@ -2,19 +2,23 @@
 #include "common.h"
 #include "lex_node.h"
 #include "expression.h"
+#include "arena.h"
+#include "symbol_table.h"
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace Tolo
 {
 	struct VariableInfo
 	{
-		std::string typeName;
+		SymbolId typeId;
 		Int offset;
 
 		VariableInfo();
 
-		VariableInfo(const std::string& _typeName, Int _offset);
+		VariableInfo(SymbolId _typeId, Int _offset);
 
 		VariableInfo(const VariableInfo& rhs);
 
@@ -23,13 +27,13 @@ namespace Tolo
 
 	struct FunctionInfo
 	{
-		std::string returnTypeName;
+		SymbolId returnTypeId;
 		Int localsSize;
 		Int parametersSize;
 
 		std::map<std::string, VariableInfo> varNameToVarInfo;
 		std::vector<std::string> parameterNames;
-		std::string invokerStructTypeName;
+		SymbolId invokerStructTypeId; // INVALID_SYMBOL if not a member function
 
 		FunctionInfo();
 	};
@@ -45,8 +49,8 @@ namespace Tolo
 
 	struct StructInfo
 	{
-		std::map<std::string, VariableInfo> memberNameToVarInfo;
-		std::vector<std::string> memberNames;
+		std::unordered_map<SymbolId, VariableInfo> memberIdToVarInfo;
+		std::vector<SymbolId> memberIds; // in declaration order
 
 		StructInfo();
 	};
@@ -72,6 +76,45 @@ namespace Tolo
 		const std::vector<std::string>& parameterTypeNames
 	);
 
+	// function signature as interned symbols, looked up instead of building a function hash
+	struct FunctionKey
+	{
+		SymbolId returnTypeId;
+		SymbolId nameId;
+		std::vector<SymbolId> parameterTypeIds;
+
+		FunctionKey();
+
+		bool operator==(const FunctionKey& rhs) const;
+	};
+
+	struct FunctionKeyHasher
+	{
+		size_t operator()(const FunctionKey& key) const;
+	};
+
+	// a user or native function found by its key
+	struct FunctionEntry
+	{
+		std::string hash;
+		SymbolId returnTypeId;
+		const FunctionInfo* p_userFunction;
+		const NativeFunctionInfo* p_nativeFunction;
+
+		FunctionEntry();
+	};
+
+	// a function whose body is parsed once all function signatures are known
+	struct PendingFunctionBody
+	{
+		std::string funcHash;
+		LexNode* p_lexNode;
+		EDefineFunction* p_defFuncExp;
+		bool addVoidReturn;
+
+		PendingFunctionBody(const std::string& _funcHash, LexNode* _p_lexNode, EDefineFunction* _p_defFuncExp, bool _addVoidReturn);
+	};
+
 	struct Parser
 	{
 		typedef std::vector<OpCode> DataTypeOperators;
@@ -79,27 +122,65 @@ namespace Tolo
 		typedef std::map<std::string, NativeFunctionInfo> HashToNativeFunction;
 		typedef std::map<std::string, VirtualFunctionInfo> VirtualTable;
 
-		std::map<std::string, Int> typeNameToSize;
+		std::unordered_map<SymbolId, Int> typeIdToSize;
 		HashToFunction hashToUserFunctions;
 		HashToNativeFunction hashToNativeFunctions;
+		std::unordered_map<FunctionKey, FunctionEntry, FunctionKeyHasher> keyToFunction;
+		Arena* p_arena; // owns all expressions
+		SymbolTable* p_symbols;
 		FunctionInfo* p_currentFunction;
-		std::string currentExpectedReturnType;
+		SymbolId currentExpectedReturnType;
+		SymbolId voidTypeId;
+		SymbolId charTypeId;
+		SymbolId intTypeId;
+		SymbolId floatTypeId;
+		SymbolId ptrTypeId;
+		SymbolId anyValueTypeId;
+		SymbolId virtualMemberId;
 		std::vector<ScopeInfo> scopeStack;
-		std::map<std::string, DataTypeOperators> typeNameOperators;
-		std::map<std::string, StructInfo> typeNameToStructInfo;
-		std::map<std::string, std::string> ptrTypeNameToStructTypeName;
-		std::map<std::string, std::string> structNameToParentStructName;
-		std::map<std::string, Int> nameToEnumValue;
-		std::set<std::string> enumNamespaces;
-		std::map<std::string, VirtualTable> structNameToVTable;
+		std::unordered_map<SymbolId, DataTypeOperators> typeIdOperators;
+		std::unordered_map<SymbolId, StructInfo> typeIdToStructInfo;
+		std::unordered_map<SymbolId, SymbolId> ptrTypeIdToStructTypeId;
+		std::unordered_map<SymbolId, SymbolId> structTypeIdToPtrTypeId;
+		std::unordered_map<SymbolId, SymbolId> structIdToParentStructId;
+		std::unordered_map<std::string, Int> nameToEnumValue;
+		std::unordered_set<std::string> enumNamespaces;
+		std::map<std::string, VirtualTable> structNameToVTable; // ordered to keep the v-table layout stable
+		std::vector<PendingFunctionBody> functionBodies;
+		std::set<std::string> currentCallees; // functions called by the last parsed body
+
+		using ExpPtr = Expression*;
+		using NodePtr = LexNode*;
 
-		using SharedExp = std::shared_ptr<Expression>;
-		using SharedNode = std::shared_ptr<LexNode>;
+		Parser(Arena& _arena, SymbolTable& _symbols);
 
-		Parser();
+		// copies the declarations of another parser to parse function bodies on another thread
+		Parser(const Parser& declarations, Arena& _arena, SymbolTable& _symbols);
 
 		bool IsFunctionDefined(const std::string& hash);
 
+		SymbolId GetSymbol(const LexToken& token);
+
+		const std::string& GetTypeName(SymbolId typeId) const;
+
+		std::vector<std::string> GetTypeNames(const std::vector<SymbolId>& typeIds) const;
+
+		// adds the pointer type of a struct type and returns its id
+		SymbolId DeclareStructPtrType(SymbolId structId);
+
+		// adds a struct registered by the program, members are (type name, member name) in declaration order
+		void AddNativeStruct(const std::string& structName, const std::vector<std::pair<std::string, std::string>>& members);
+
+		// makes a function of hashToUserFunctions or hashToNativeFunctions findable by FindFunction
+		void AddFunctionKey(const std::string& hash);
+
+		// found functions are added to currentCallees while parsing a body
+		const FunctionEntry* FindFunction(
+			SymbolId returnTypeId, 
+			SymbolId nameId, 
+			const std::vector<SymbolId>& parameterTypeIds
+		);
+
 		bool IsVariableDefined(const std::string& name);
 
 		void PushScope();
@@ -108,99 +189,104 @@ namespace Tolo
 
 		void DeclareVariableInCurrentScope(const std::string& name, int line);
 
-		void AffirmCurrentType(const std::string& typeName, int line, bool canBeAnyValueType = true);
+		void AffirmCurrentType(SymbolId typeId, int line, bool canBeAnyValueType = true);
+
+		bool HasBody(NodePtr lexNode, size_t& outContentStartIndex, size_t& outContentCount);
+
+		void FlattenNode(NodePtr lexNode, std::vector<NodePtr>& outNodes);
 
-		bool HasBody(const SharedNode& lexNode, size_t& outContentStartIndex, size_t& outContentCount);
+		void Parse(const std::vector<NodePtr>& lexNodes, std::vector<ExpPtr>& expressions);
 
-		void FlattenNode(const SharedNode& lexNode, std::vector<SharedNode>& outNodes);
+		// parses everything but the function bodies, which are left in functionBodies
+		void ParseDeclarations(const std::vector<NodePtr>& lexNodes, std::vector<ExpPtr>& expressions);
 
-		void Parse(const std::vector<SharedNode>& lexNodes, std::vector<SharedExp>& expressions);
+		void PFunctionBody(const PendingFunctionBody& body);
 
 		// global structures
-		SharedExp PGlobalStructure(const SharedNode& lexNode);
+		ExpPtr PGlobalStructure(NodePtr lexNode);
 
-		SharedExp PStructDefinition(const SharedNode& lexNode);
+		ExpPtr PStructDefinition(NodePtr lexNode);
 
-		SharedExp PFunctionDefinition(const SharedNode& lexNode);
+		ExpPtr PFunctionDefinition(NodePtr lexNode);
 
-		SharedExp POperatorDefinition(const SharedNode& lexNode);
+		ExpPtr POperatorDefinition(NodePtr lexNode);
 
-		SharedExp PMemberFunctionDefinition(const SharedNode& lexNode);
+		ExpPtr PMemberFunctionDefinition(NodePtr lexNode);
 
-		SharedExp PEnumDefinition(const SharedNode& lexNode);
+		ExpPtr PEnumDefinition(NodePtr lexNode);
 
 		// statements
-		SharedExp PStatement(const SharedNode& lexNode);
+		ExpPtr PStatement(NodePtr lexNode);
 
-		SharedExp PBreak(const SharedNode& lexNode);
+		ExpPtr PBreak(NodePtr lexNode);
 
-		SharedExp PContinue(const SharedNode& lexNode);
+		ExpPtr PContinue(NodePtr lexNode);
 
-		SharedExp PScope(const SharedNode& lexNode);
+		ExpPtr PScope(NodePtr lexNode);
 
-		SharedExp PReturn(const SharedNode& lexNode);
+		ExpPtr PReturn(NodePtr lexNode);
 
-		SharedExp PIfSingle(const SharedNode& lexNode);
+		ExpPtr PIfSingle(NodePtr lexNode);
 
-		SharedExp PIfChain(const SharedNode& lexNode);
+		ExpPtr PIfChain(NodePtr lexNode);
 
-		SharedExp PElseIfSingle(const SharedNode& lexNode);
+		ExpPtr PElseIfSingle(NodePtr lexNode);
 
-		SharedExp PElseIfChain(const SharedNode& lexNode);
+		ExpPtr PElseIfChain(NodePtr lexNode);
 
-		SharedExp PElse(const SharedNode& lexNode);
+		ExpPtr PElse(NodePtr lexNode);
 
-		SharedExp PWhile(const SharedNode& lexNode);
+		ExpPtr PWhile(NodePtr lexNode);
 
 		// expressions
-		SharedExp PExpression(const SharedNode& lexNode);
+		ExpPtr PExpression(NodePtr lexNode);
 
-		SharedExp PBinaryOp(const SharedNode& lexNode, std::string& outReadDataType);
+		ExpPtr PBinaryOp(NodePtr lexNode, SymbolId& outReadDataType);
 
-		SharedExp PAssign(const SharedNode& lexNode);
+		ExpPtr PAssign(NodePtr lexNode);
 
-		SharedExp PWritablePtr(const SharedNode& lexNode, std::string& outWriteDataType);
+		ExpPtr PWritablePtr(NodePtr lexNode, SymbolId& outWriteDataType);
 
-		SharedExp PVariablePtr(const SharedNode& lexNode, std::string& outWriteDataType);
+		ExpPtr PVariablePtr(NodePtr lexNode, SymbolId& outWriteDataType);
 
-		SharedExp PMemberAccessPtr(const SharedNode& lexNode, std::string& outWriteDataType);
+		ExpPtr PMemberAccessPtr(NodePtr lexNode, SymbolId& outWriteDataType);
 
-		SharedExp PDereferencePtr(const SharedNode& lexNode);
+		ExpPtr PDereferencePtr(NodePtr lexNode);
 
-		SharedExp PReadableValue(const SharedNode& lexNode, std::string& outReadDataType);
+		ExpPtr PReadableValue(NodePtr lexNode, SymbolId& outReadDataType);
 
-		SharedExp PReadableValue(const SharedNode& lexNode);
+		ExpPtr PReadableValue(NodePtr lexNode);
 
-		SharedExp PLiteralConstantValue(const SharedNode& lexNode, std::string& outReadDataType);
+		ExpPtr PLiteralConstantValue(NodePtr lexNode, SymbolId& outReadDataType);
 
-		SharedExp PVariableValue(const SharedNode& lexNode, std::string& outReadDataType);
+		ExpPtr PVariableValue(NodePtr lexNode, SymbolId& outReadDataType);
 
-		SharedExp PMemberAccessValue(const SharedNode& lexNode, std::string& outReadDataType);
+		ExpPtr PMemberAccessValue(NodePtr lexNode, SymbolId& outReadDataType);
 
-		SharedExp PBinaryMathOp(const SharedNode& lexNode, std::string& outReadDataType);
+		ExpPtr PBinaryMathOp(NodePtr lexNode, SymbolId& outReadDataType);
 
-		SharedExp PBinaryCompareOp(const SharedNode& lexNode, std::string& outReadDataType);
+		ExpPtr PBinaryCompareOp(NodePtr lexNode, SymbolId& outReadDataType);
 
-		SharedExp PUnaryOp(const SharedNode& lexNode, std::string& outReadDataType);
+		ExpPtr PUnaryOp(NodePtr lexNode, SymbolId& outReadDataType);
 
-		SharedExp PReferenceValue(const SharedNode& lexNode, std::string& outReadDataType);
+		ExpPtr PReferenceValue(NodePtr lexNode, SymbolId& outReadDataType);
 
-		SharedExp PDereferenceValue(const SharedNode& lexNode, std::string& outReadDataType);
+		ExpPtr PDereferenceValue(NodePtr lexNode, SymbolId& outReadDataType);
 
-		SharedExp PNegate(const SharedNode& lexNode, std::string& outReadDataType);
+		ExpPtr PNegate(NodePtr lexNode, SymbolId& outReadDataType);
 
-		SharedExp PNot(const SharedNode& lexNode, std::string& outReadDataType);
+		ExpPtr PNot(NodePtr lexNode, SymbolId& outReadDataType);
 
-		SharedExp PBitInvert(const SharedNode& lexNode, std::string& outReadDataType);
+		ExpPtr PBitInvert(NodePtr lexNode, SymbolId& outReadDataType);
 
-		SharedExp PFunctionCall(const SharedNode& lexNode, std::string& outReadDataType);
+		ExpPtr PFunctionCall(NodePtr lexNode, SymbolId& outReadDataType);
 
-		SharedExp PUserOrNativeFunctionCall(const SharedNode& lexNode, std::string& outReadDataType);
+		ExpPtr PUserOrNativeFunctionCall(NodePtr lexNode, SymbolId& outReadDataType);
 
-		SharedExp PStructInitialization(const SharedNode& lexNode, std::string& outReadDataType);
+		ExpPtr PStructInitialization(NodePtr lexNode, SymbolId& outReadDataType);
 
-		SharedExp PStructPtrInitialization(const SharedNode& lexNode, std::string& outReadDataType);
+		ExpPtr PStructPtrInitialization(NodePtr lexNode, SymbolId& outReadDataType);
 
-		SharedExp PMemberFunctionCall(const SharedNode& lexNode, std::string& outReadDataType);
+		ExpPtr PMemberFunctionCall(NodePtr lexNode, SymbolId& outReadDataType);
 	};
 }
\ No newline at end of file
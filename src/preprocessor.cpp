@@ -1,88 +1,193 @@
 #include "preprocessor.h"
-#include "common.h"
 #include "file_io.h"
-#include <regex>
 #include <set>
+#include <algorithm>
 
 namespace Tolo
 {
-	void RecursiveApplyIncludes(
-		const std::string& inCode, 
-		std::string& outCode,
-		std::set<std::string>& inoutIncludePaths
-	)
+	SourceLocation::SourceLocation() :
+		fileIndex(0),
+		line(0)
+	{}
+
+	SourceLocation::SourceLocation(Int _fileIndex, Int _line) :
+		fileIndex(_fileIndex),
+		line(_line)
+	{}
+
+	const SourceLocation& SourceMap::GetLocationOfLine(Int outputLine) const
 	{
-		// find include files
-		std::regex includeFileRgx("(^|\\n)#include\\s\"([\\S\\s]+?)\"");
-		std::smatch includeFileMatch;
-		auto start = inCode.cbegin();
-		bool hasInclude = false;
+		Affirm(
+			outputLine > 0 && outputLine <= static_cast<Int>(lineLocations.size()),
+			"line %i is outside of the preprocessed code",
+			outputLine
+		);
 
-		while (std::regex_search(start, inCode.cend(), includeFileMatch, includeFileRgx))
-		{
-			hasInclude = true;
-			std::string newline = includeFileMatch[1];
-			std::string includePath = includeFileMatch[2];
+		return lineLocations[outputLine - 1];
+	}
 
-			outCode += newline;
-			outCode += includeFileMatch.prefix();
+	bool SourceMap::TryGetLocationOfLine(Int outputLine, SourceLocation& outLocation) const
+	{
+		if (outputLine <= 0 || outputLine > static_cast<Int>(lineLocations.size()))
+			return false;
 
-			if (inoutIncludePaths.count(includePath) == 0)
-			{
-				inoutIncludePaths.insert(includePath);
-				std::string includeCode;
-				ReadTextFile(includePath, includeCode);
-				RecursiveApplyIncludes(includeCode, outCode, inoutIncludePaths);
-			}
+		outLocation = lineLocations[outputLine - 1];
+		return true;
+	}
 
-			start = includeFileMatch.suffix().first;
-		}
+	const SourceLocation& SourceMap::GetLocationOfOffset(size_t outputOffset) const
+	{
+		Affirm(!lineOffsets.empty(), "source map is empty");
 
-		if (!hasInclude)
-			outCode += inCode;
-		else
-			outCode += includeFileMatch.suffix();
+		// the first line starts at 0, so the line containing the offset is before the upper bound
+		size_t index = std::upper_bound(lineOffsets.begin(), lineOffsets.end(), outputOffset) - lineOffsets.begin();
+		
+		return lineLocations[index - 1];
 	}
 
-	void Preprocess(
-		const std::string& inCode, 
-		std::string& outCode,
-		std::map<std::string, bool>& inoutStandardIncludeFlags
-	)
+	struct PreprocessContext
 	{
-		std::string allCode;
+		std::string& outCode;
+		std::map<std::string, bool>& inoutStandardIncludeFlags;
+		SourceMap& outSourceMap;
 		std::set<std::string> includePaths;
-		RecursiveApplyIncludes(inCode, allCode, includePaths);
 
-		// find include flags
-		std::regex includeFlagRgx("(^|\\n)#include\\s<([\\S\\s]+?)>");
-		std::smatch includeFlagMatch;
-		auto start = allCode.cbegin();
-		bool hasInclude = false;
+		PreprocessContext(std::string& _outCode, std::map<std::string, bool>& _inoutStandardIncludeFlags, SourceMap& _outSourceMap);
+	};
+
+	PreprocessContext::PreprocessContext(std::string& _outCode, std::map<std::string, bool>& _inoutStandardIncludeFlags, SourceMap& _outSourceMap) :
+		outCode(_outCode),
+		inoutStandardIncludeFlags(_inoutStandardIncludeFlags),
+		outSourceMap(_outSourceMap)
+	{}
+
+	static const char includeDirective[] = "#include";
+	static const size_t includeDirectiveSize = sizeof(includeDirective) - 1;
+
+	// checks if the line is an include and finds the name between its "" or <>
+	static bool TryParseInclude(
+		const std::string& code, 
+		size_t lineStart, 
+		size_t lineEnd, 
+		const std::string& filePath, 
+		Int line,
+		char& outOpenChar, 
+		size_t& outNameStart, 
+		size_t& outNameEnd
+	)
+	{
+		if (lineEnd - lineStart <= includeDirectiveSize || code.compare(lineStart, includeDirectiveSize, includeDirective) != 0)
+			return false;
+
+		size_t i = lineStart + includeDirectiveSize;
+
+		if (code[i] != ' ' && code[i] != '\t')
+			return false;
+
+		for (; i < lineEnd && (code[i] == ' ' || code[i] == '\t'); i++);
+
+		if (i == lineEnd || (code[i] != '"' && code[i] != '<'))
+			return false;
+
+		outOpenChar = code[i];
+		char closeChar = outOpenChar == '"' ? '"' : '>';
+		outNameStart = i + 1;
 
-		while (std::regex_search(start, allCode.cend(), includeFlagMatch, includeFlagRgx))
+		for (outNameEnd = outNameStart; outNameEnd < lineEnd && code[outNameEnd] != closeChar; outNameEnd++);
+
+		Affirm(
+			outNameEnd < lineEnd && outNameEnd > outNameStart,
+			"invalid include at line %i of '%s'",
+			line, filePath.c_str()
+		);
+
+		return true;
+	}
+
+	static void PreprocessFile(const std::string& filePath, const std::string& code, PreprocessContext& context)
+	{
+		std::string& outCode = context.outCode;
+		SourceMap& sourceMap = context.outSourceMap;
+
+		Int fileIndex = static_cast<Int>(sourceMap.filePaths.size());
+		sourceMap.filePaths.push_back(filePath);
+
+		// the file starts on an empty output line, unless the includer pasted it after other text
+		if (outCode.size() == sourceMap.lineOffsets.back())
+			sourceMap.lineLocations.back() = SourceLocation(fileIndex, 1);
+
+		outCode.reserve(outCode.size() + code.size());
+
+		Int line = 1;
+
+		for (size_t lineStart = 0; lineStart < code.size(); line++)
 		{
-			hasInclude = true;
-			std::string newline = includeFlagMatch[1];
-			std::string includeFlag = includeFlagMatch[2];
+			size_t lineEnd = code.find('\n', lineStart);
+			if (lineEnd == std::string::npos)
+				lineEnd = code.size();
+
+			size_t copyStart = lineStart;
+			char openChar;
+			size_t nameStart;
+			size_t nameEnd;
+
+			if (TryParseInclude(code, lineStart, lineEnd, filePath, line, openChar, nameStart, nameEnd))
+			{
+				std::string name = code.substr(nameStart, nameEnd - nameStart);
+
+				if (openChar == '<')
+				{
+					Affirm(
+						context.inoutStandardIncludeFlags.count(name) != 0,
+						"include '%s' is not part of the standard",
+						name.c_str()
+					);
 
-			outCode += newline;
-			outCode += includeFlagMatch.prefix();
+					context.inoutStandardIncludeFlags.at(name) = true;
+				}
+				else if (context.includePaths.count(name) == 0)
+				{
+					context.includePaths.insert(name);
 
-			Affirm(
-				inoutStandardIncludeFlags.count(includeFlag) != 0,
-				"include '%s' is not part of the standard",
-				includeFlag.c_str()
-			);
+					std::string includeCode;
+					ReadTextFile(name, includeCode);
+					PreprocessFile(name, includeCode, context);
 
-			inoutStandardIncludeFlags.at(includeFlag) = true;
+					if (outCode.size() == sourceMap.lineOffsets.back())
+						sourceMap.lineLocations.back() = SourceLocation(fileIndex, line);
+				}
 
-			start = includeFlagMatch.suffix().first;
+				// text after the include stays on its line
+				copyStart = nameEnd + 1;
+			}
+
+			outCode.append(code, copyStart, lineEnd - copyStart);
+
+			if (lineEnd < code.size())
+			{
+				outCode += '\n';
+				sourceMap.lineOffsets.push_back(outCode.size());
+				sourceMap.lineLocations.push_back(SourceLocation(fileIndex, line + 1));
+			}
+
+			lineStart = lineEnd + 1;
 		}
+	}
+
+	void Preprocess(
+		const std::string& codePath,
+		const std::string& inCode, 
+		std::string& outCode,
+		std::map<std::string, bool>& inoutStandardIncludeFlags,
+		SourceMap& outSourceMap
+	)
+	{
+		outCode.clear();
+		outSourceMap = SourceMap();
+		outSourceMap.lineOffsets.push_back(0);
+		outSourceMap.lineLocations.push_back(SourceLocation(0, 1));
 
-		if (!hasInclude)
-			outCode += allCode;
-		else
-			outCode += includeFlagMatch.suffix();
+		PreprocessContext context(outCode, inoutStandardIncludeFlags, outSourceMap);
+		PreprocessFile(codePath, inCode, context);
 	}
 }
\ No newline at end of file
@@ -1,12 +1,43 @@
 #pragma once
+#include "common.h"
 #include <string>
+#include <vector>
 #include <map>
 
 namespace Tolo
 {
+	struct SourceLocation
+	{
+		Int fileIndex;
+		Int line;
+
+		SourceLocation();
+
+		SourceLocation(Int _fileIndex, Int _line);
+	};
+
+	// maps the lines of preprocessed code back to the files they came from,
+	// output line n starts at lineOffsets[n - 1] and came from lineLocations[n - 1]
+	struct SourceMap
+	{
+		std::vector<std::string> filePaths;
+		std::vector<size_t> lineOffsets;
+		std::vector<SourceLocation> lineLocations;
+
+		const SourceLocation& GetLocationOfLine(Int outputLine) const;
+
+		const SourceLocation& GetLocationOfOffset(size_t outputOffset) const;
+
+		// false for lines outside of the preprocessed code
+		bool TryGetLocationOfLine(Int outputLine, SourceLocation& outLocation) const;
+	};
+
+	// resolves '#include "path"' by pasting each file once and '#include <name>' by setting its flag
 	void Preprocess(
+		const std::string& codePath,
 		const std::string& inCode, 
 		std::string& outCode, 
-		std::map<std::string, bool>& inoutStandardIncludeFlags
+		std::map<std::string, bool>& inoutStandardIncludeFlags,
+		SourceMap& outSourceMap
 	);
 }
\ No newline at end of file
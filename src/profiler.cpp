@@ -0,0 +1,439 @@
+#include "profiler.h"
+#include <cstdio>
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+namespace Tolo
+{
+	FunctionCounters::FunctionCounters() :
+		callCount(0),
+		inclusiveInstructions(0),
+		exclusiveInstructions(0),
+		inclusiveSeconds(0.0),
+		exclusiveSeconds(0.0)
+	{}
+
+
+	VMProfiler::VMProfiler() :
+		p_stack(nullptr),
+		instructionCount(0)
+	{
+		opCodeCounts.fill(0);
+	}
+
+	void VMProfiler::Reset(Ptr _p_stack)
+	{
+		p_stack = _p_stack;
+		instructionCount = 0;
+		opCodeCounts.fill(0);
+		offsetCounts.clear();
+		entryToCounters.clear();
+		entryToActiveCalls.clear();
+		callStack.clear();
+	}
+
+	void VMProfiler::EnterFunction(Ptr p_functionIp)
+	{
+		entryToCounters[p_functionIp].callCount++;
+		entryToActiveCalls[p_functionIp]++;
+		callStack.push_back({ p_functionIp, instructionCount, 0, std::chrono::steady_clock::now(), 0.0 });
+	}
+
+	void VMProfiler::ReturnFromFunction()
+	{
+		// calls entered before the profiler was reset
+		if (callStack.empty())
+			return;
+
+		ProfiledCall call = callStack.back();
+		callStack.pop_back();
+
+		uint64_t instructions = instructionCount - call.startInstructionCount;
+		std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - call.startTime;
+
+		FunctionCounters& counters = entryToCounters[call.p_functionIp];
+		counters.exclusiveInstructions += instructions - call.childInstructionCount;
+		counters.exclusiveSeconds += seconds.count() - call.childSeconds;
+
+		if (--entryToActiveCalls[call.p_functionIp] == 0)
+		{
+			counters.inclusiveInstructions += instructions;
+			counters.inclusiveSeconds += seconds.count();
+		}
+
+		if (!callStack.empty())
+		{
+			callStack.back().childInstructionCount += instructions;
+			callStack.back().childSeconds += seconds.count();
+		}
+	}
+
+	void VMProfiler::ClearCalls()
+	{
+		callStack.clear();
+		entryToActiveCalls.clear();
+	}
+
+
+	VMSampler::VMSampler() :
+		sampleInterval(0),
+		countdown(0),
+		maxDepth(0),
+		nextSample(0),
+		sampleCount(0)
+	{}
+
+	void VMSampler::Start(Int _sampleInterval, size_t sampleCapacity, size_t _maxDepth)
+	{
+		Affirm(_sampleInterval > 0, "sample interval must be greater than 0");
+		Affirm(sampleCapacity > 0 && _maxDepth > 0, "sample capacity and depth must be greater than 0");
+
+		sampleInterval = _sampleInterval;
+		countdown = _sampleInterval;
+		maxDepth = _maxDepth;
+		sampleIps.assign(sampleCapacity * maxDepth, nullptr);
+		sampleDepths.assign(sampleCapacity, 0);
+		nextSample = 0;
+		sampleCount = 0;
+	}
+
+	void VMSampler::Sample(const VirtualMachine& vm)
+	{
+		countdown = sampleInterval;
+
+		Ptr* p_ips = &sampleIps[nextSample * maxDepth];
+		size_t depth = 0;
+		p_ips[depth++] = vm.p_instructionPtr;
+
+		// frames live behind the code, the first frame points back in front of it
+		for (Ptr p_framePtr = vm.p_framePtr; p_framePtr > vm.p_codeEnd && depth < maxDepth;)
+		{
+			Ptr p_returnIp = Get<Ptr>(p_framePtr - sizeof(Ptr) - sizeof(Ptr));
+			p_framePtr = Get<Ptr>(p_framePtr - sizeof(Ptr));
+
+			// frames called by the host return to the end of the code
+			if (p_returnIp < vm.p_codeEnd)
+				p_ips[depth++] = p_returnIp;
+		}
+
+		sampleDepths[nextSample] = depth;
+		nextSample = (nextSample + 1) % sampleDepths.size();
+		sampleCount++;
+	}
+
+	size_t VMSampler::GetHeldSampleCount() const
+	{
+		return static_cast<size_t>(std::min<uint64_t>(sampleCount, sampleDepths.size()));
+	}
+
+
+	ExecutionCounters::ExecutionCounters() :
+		instructionCount(0),
+		callCount(0),
+		nativeCallCount(0),
+		bytesLoaded(0),
+		bytesWritten(0),
+		stackHighWater(0)
+	{}
+
+
+	void FunctionEntries::Add(Ptr p_entryIp, const std::string& functionHash)
+	{
+		entries.push_back({ p_entryIp, functionHash });
+	}
+
+	void FunctionEntries::Sort()
+	{
+		std::sort(entries.begin(), entries.end());
+	}
+
+	const std::pair<Ptr, std::string>* FunctionEntries::FindEntry(Ptr p_ip) const
+	{
+		auto it = std::upper_bound(
+			entries.begin(), entries.end(), p_ip,
+			[](Ptr p_val, const std::pair<Ptr, std::string>& entry) { return p_val < entry.first; }
+		);
+
+		return it != entries.begin() ? &*std::prev(it) : nullptr;
+	}
+
+	const std::string* FunctionEntries::Find(Ptr p_ip) const
+	{
+		const std::pair<Ptr, std::string>* p_entry = FindEntry(p_ip);
+		return p_entry != nullptr ? &p_entry->second : nullptr;
+	}
+
+
+	OpCodeProfile::OpCodeProfile() :
+		count(0)
+	{}
+
+
+	AddressProfile::AddressProfile() :
+		codeOffset(0),
+		count(0)
+	{}
+
+
+	ProgramProfile::ProgramProfile() :
+		instructionCount(0)
+	{}
+
+
+	template<typename... ARGS>
+	static void AppendFormat(std::string& outText, const char* format, ARGS... args)
+	{
+		char buffer[512];
+		std::snprintf(buffer, sizeof(buffer), format, args...);
+		outText += buffer;
+	}
+
+	static double Percent(uint64_t count, uint64_t total)
+	{
+		return total > 0 ? 100.0 * static_cast<double>(count) / static_cast<double>(total) : 0.0;
+	}
+
+	void WriteProfileText(const ProgramProfile& profile, size_t maxRows, std::string& outText)
+	{
+		outText.clear();
+		AppendFormat(outText, "instructions: %llu\n\n", static_cast<unsigned long long>(profile.instructionCount));
+
+		AppendFormat(
+			outText, "%-40s %10s %14s %14s %7s %12s %12s\n",
+			"function", "calls", "incl instr", "excl instr", "excl %", "incl ms", "excl ms"
+		);
+
+		for (size_t i = 0; i < profile.functions.size() && i < maxRows; i++)
+		{
+			const FunctionProfile& function = profile.functions[i];
+			const FunctionCounters& counters = function.counters;
+
+			AppendFormat(
+				outText, "%-40s %10llu %14llu %14llu %6.2f%% %12.3f %12.3f\n",
+				function.functionHash.c_str(),
+				static_cast<unsigned long long>(counters.callCount),
+				static_cast<unsigned long long>(counters.inclusiveInstructions),
+				static_cast<unsigned long long>(counters.exclusiveInstructions),
+				Percent(counters.exclusiveInstructions, profile.instructionCount),
+				counters.inclusiveSeconds * 1000.0,
+				counters.exclusiveSeconds * 1000.0
+			);
+		}
+
+		AppendFormat(outText, "\n%-40s %14s %7s\n", "opcode", "count", "%");
+
+		for (size_t i = 0; i < profile.opCodes.size() && i < maxRows; i++)
+		{
+			const OpCodeProfile& opCode = profile.opCodes[i];
+
+			AppendFormat(
+				outText, "%-40s %14llu %6.2f%%\n",
+				opCode.opCodeName.c_str(),
+				static_cast<unsigned long long>(opCode.count),
+				Percent(opCode.count, profile.instructionCount)
+			);
+		}
+
+		AppendFormat(outText, "\n%-10s %-29s %14s %7s  %s\n", "offset", "function", "count", "%", "source");
+
+		for (size_t i = 0; i < profile.addresses.size() && i < maxRows; i++)
+		{
+			const AddressProfile& address = profile.addresses[i];
+
+			AppendFormat(
+				outText, "%-10i %-29s %14llu %6.2f%%  %s\n",
+				address.codeOffset,
+				address.functionHash.c_str(),
+				static_cast<unsigned long long>(address.count),
+				Percent(address.count, profile.instructionCount),
+				address.sourceLine.c_str()
+			);
+		}
+	}
+
+	static void AppendJsonString(std::string& outJson, const std::string& value)
+	{
+		outJson += '"';
+
+		for (char c : value)
+		{
+			if (c == '"' || c == '\\')
+				outJson += '\\';
+
+			outJson += c;
+		}
+
+		outJson += '"';
+	}
+
+	void WriteProfileJson(const ProgramProfile& profile, std::string& outJson)
+	{
+		outJson.clear();
+		AppendFormat(outJson, "{\"instructionCount\":%llu,\"functions\":[", static_cast<unsigned long long>(profile.instructionCount));
+
+		for (size_t i = 0; i < profile.functions.size(); i++)
+		{
+			const FunctionProfile& function = profile.functions[i];
+			const FunctionCounters& counters = function.counters;
+
+			outJson += i > 0 ? ",{\"function\":" : "{\"function\":";
+			AppendJsonString(outJson, function.functionHash);
+			AppendFormat(
+				outJson, ",\"calls\":%llu,\"inclusiveInstructions\":%llu,\"exclusiveInstructions\":%llu,\"inclusiveSeconds\":%.9f,\"exclusiveSeconds\":%.9f}",
+				static_cast<unsigned long long>(counters.callCount),
+				static_cast<unsigned long long>(counters.inclusiveInstructions),
+				static_cast<unsigned long long>(counters.exclusiveInstructions),
+				counters.inclusiveSeconds,
+				counters.exclusiveSeconds
+			);
+		}
+
+		outJson += "],\"opCodes\":[";
+
+		for (size_t i = 0; i < profile.opCodes.size(); i++)
+		{
+			outJson += i > 0 ? ",{\"opCode\":" : "{\"opCode\":";
+			AppendJsonString(outJson, profile.opCodes[i].opCodeName);
+			AppendFormat(outJson, ",\"count\":%llu}", static_cast<unsigned long long>(profile.opCodes[i].count));
+		}
+
+		outJson += "],\"addresses\":[";
+
+		for (size_t i = 0; i < profile.addresses.size(); i++)
+		{
+			const AddressProfile& address = profile.addresses[i];
+
+			AppendFormat(outJson, i > 0 ? ",{\"offset\":%i,\"function\":" : "{\"offset\":%i,\"function\":", address.codeOffset);
+			AppendJsonString(outJson, address.functionHash);
+			outJson += ",\"source\":";
+			AppendJsonString(outJson, address.sourceLine);
+			AppendFormat(outJson, ",\"count\":%llu}", static_cast<unsigned long long>(address.count));
+		}
+
+		outJson += "]}";
+	}
+
+	void AddCounterValues(const std::string& runName, const ExecutionCounters& counters, std::map<std::string, uint64_t>& inoutValues)
+	{
+		inoutValues[runName + ".instructions"] = counters.instructionCount;
+		inoutValues[runName + ".calls"] = counters.callCount;
+		inoutValues[runName + ".nativeCalls"] = counters.nativeCallCount;
+		inoutValues[runName + ".bytesLoaded"] = counters.bytesLoaded;
+		inoutValues[runName + ".bytesWritten"] = counters.bytesWritten;
+		inoutValues[runName + ".stackHighWater"] = static_cast<uint64_t>(counters.stackHighWater);
+	}
+
+	void WriteCounterValues(const std::map<std::string, uint64_t>& values, std::string& outText)
+	{
+		outText.clear();
+
+		for (const auto& e : values)
+			outText += e.first + " " + std::to_string(e.second) + "\n";
+	}
+
+	void ReadCounterValues(const std::string& text, std::map<std::string, uint64_t>& outValues)
+	{
+		outValues.clear();
+
+		std::istringstream stream(text);
+		std::string line;
+
+		while (std::getline(stream, line))
+		{
+			if (line.empty() || line[0] == '#')
+				continue;
+
+			std::istringstream lineStream(line);
+			std::string name;
+			unsigned long long value = 0;
+
+			Affirm(static_cast<bool>(lineStream >> name >> value), "invalid counter line '%s'", line.c_str());
+			outValues[name] = static_cast<uint64_t>(value);
+		}
+	}
+
+	bool CompareCounterValues(
+		const std::map<std::string, uint64_t>& baseline,
+		const std::map<std::string, uint64_t>& current,
+		double thresholdPercent,
+		std::string& outReport
+	)
+	{
+		outReport.clear();
+		bool isPassing = true;
+
+		for (const auto& e : baseline)
+		{
+			auto currentIt = current.find(e.first);
+
+			if (currentIt == current.end())
+			{
+				AppendFormat(outReport, "MISSING   %s\n", e.first.c_str());
+				isPassing = false;
+				continue;
+			}
+
+			if (currentIt->second == e.second)
+				continue;
+
+			double change = e.second > 0 ?
+				100.0 * (static_cast<double>(currentIt->second) - static_cast<double>(e.second)) / static_cast<double>(e.second) :
+				100.0;
+
+			bool isRegression = change > thresholdPercent;
+			isPassing = isPassing && !isRegression;
+
+			AppendFormat(
+				outReport, "%-9s %-40s %14llu -> %14llu %+8.2f%%\n",
+				isRegression ? "REGRESSED" : (change < 0.0 ? "improved" : "changed"),
+				e.first.c_str(),
+				static_cast<unsigned long long>(e.second),
+				static_cast<unsigned long long>(currentIt->second),
+				change
+			);
+		}
+
+		for (const auto& e : current)
+		{
+			if (baseline.count(e.first) == 0)
+				AppendFormat(outReport, "new       %s %llu\n", e.first.c_str(), static_cast<unsigned long long>(e.second));
+		}
+
+		return isPassing;
+	}
+
+	void WriteCollapsedStacks(const VMSampler& sampler, const FunctionEntries& functionEntries, std::string& outText)
+	{
+		std::map<std::string, uint64_t> stackToCount;
+		std::string stack;
+
+		for (size_t i = 0; i < sampler.GetHeldSampleCount(); i++)
+		{
+			const Ptr* p_ips = &sampler.sampleIps[i * sampler.maxDepth];
+			stack.clear();
+
+			// outermost frame first
+			for (size_t depth = sampler.sampleDepths[i]; depth > 0; depth--)
+			{
+				const std::string* p_functionHash = functionEntries.Find(p_ips[depth - 1]);
+
+				if (p_functionHash == nullptr)
+					continue;
+
+				if (!stack.empty())
+					stack += ';';
+
+				stack += *p_functionHash;
+			}
+
+			if (!stack.empty())
+				stackToCount[stack]++;
+		}
+
+		outText.clear();
+
+		for (const auto& e : stackToCount)
+			outText += e.first + " " + std::to_string(e.second) + "\n";
+	}
+}
\ No newline at end of file
@@ -0,0 +1,203 @@
+#pragma once
+#include "common.h"
+#include "virtual_machine.h"
+#include <string>
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <map>
+#include <chrono>
+#include <cstdint>
+
+namespace Tolo
+{
+	// instructions and time spent in a function, inclusive counts everything until it returns,
+	// exclusive leaves out the script functions it called
+	struct FunctionCounters
+	{
+		uint64_t callCount;
+		uint64_t inclusiveInstructions;
+		uint64_t exclusiveInstructions;
+		double inclusiveSeconds;
+		double exclusiveSeconds;
+
+		FunctionCounters();
+	};
+
+	// a script function call the profiler waits to return
+	struct ProfiledCall
+	{
+		Ptr p_functionIp;
+		uint64_t startInstructionCount;
+		uint64_t childInstructionCount;
+		std::chrono::steady_clock::time_point startTime;
+		double childSeconds;
+	};
+
+	// counts filled by the VM while it runs, if PROFILE_VM is defined
+	struct VMProfiler
+	{
+		Ptr p_stack;
+		uint64_t instructionCount;
+		std::array<uint64_t, 256> opCodeCounts;
+		std::vector<uint64_t> offsetCounts; // executions of the instruction at each code offset, sized when a run starts
+		std::unordered_map<Ptr, FunctionCounters> entryToCounters;
+		std::unordered_map<Ptr, Int> entryToActiveCalls; // recursive calls only count once inclusive
+		std::vector<ProfiledCall> callStack;
+
+		VMProfiler();
+
+		void Reset(Ptr _p_stack);
+
+		void CountInstruction(Ptr p_instructionPtr)
+		{
+			instructionCount++;
+			opCodeCounts[static_cast<unsigned char>(*p_instructionPtr)]++;
+			offsetCounts[static_cast<size_t>(p_instructionPtr - p_stack)]++;
+		}
+
+		void EnterFunction(Ptr p_functionIp);
+
+		void ReturnFromFunction();
+
+		// drops the calls of a run that ended with an error
+		void ClearCalls();
+	};
+
+	// polls the VM every sampleInterval instructions and keeps the script call stack of the
+	// last sampleCapacity samples, innermost ip first
+	struct VMSampler
+	{
+		Int sampleInterval;
+		Int countdown;
+		size_t maxDepth;
+		std::vector<Ptr> sampleIps; // maxDepth ips per sample
+		std::vector<size_t> sampleDepths;
+		size_t nextSample;
+		uint64_t sampleCount;
+
+		VMSampler();
+
+		void Start(Int _sampleInterval, size_t sampleCapacity, size_t _maxDepth);
+
+		void Tick(const VirtualMachine& vm)
+		{
+			if (--countdown == 0)
+				Sample(vm);
+		}
+
+		// stores the current ip and the return ip of every frame
+		void Sample(const VirtualMachine& vm);
+
+		// number of samples held, older ones are overwritten
+		size_t GetHeldSampleCount() const;
+	};
+
+	// exact counts of what the VM executed while counting, the same for every run of the same
+	// code and input unlike timings
+	struct ExecutionCounters
+	{
+		uint64_t instructionCount;
+		uint64_t callCount;
+		uint64_t nativeCallCount;
+		uint64_t bytesLoaded; // by Load_Bytes_From
+		uint64_t bytesWritten; // by Write_Bytes_To
+		Int stackHighWater; // bytes used behind the code
+
+		ExecutionCounters();
+
+		void Count(const VirtualMachine& vm)
+		{
+			instructionCount++;
+
+			switch (static_cast<OpCode>(*vm.p_instructionPtr))
+			{
+			case OpCode::Call: callCount++; break;
+			case OpCode::Call_Native: nativeCallCount++; break;
+			case OpCode::Load_Bytes_From: bytesLoaded += static_cast<uint64_t>(Get<Int>(vm.p_stackPtr - sizeof(Int))); break;
+			case OpCode::Write_Bytes_To: bytesWritten += static_cast<uint64_t>(Get<Int>(vm.p_stackPtr - sizeof(Int))); break;
+			default: break;
+			}
+
+			Int stackSize = static_cast<Int>(vm.p_stackPtr - vm.p_codeEnd);
+
+			if (stackSize > stackHighWater)
+				stackHighWater = stackSize;
+		}
+	};
+
+	// function entry points sorted by ip, code belongs to the closest entry before it
+	struct FunctionEntries
+	{
+		std::vector<std::pair<Ptr, std::string>> entries;
+
+		void Add(Ptr p_entryIp, const std::string& functionHash);
+
+		void Sort();
+
+		// nullptr for code in front of all functions
+		const std::pair<Ptr, std::string>* FindEntry(Ptr p_ip) const;
+
+		const std::string* Find(Ptr p_ip) const;
+	};
+
+	struct OpCodeProfile
+	{
+		std::string opCodeName;
+		uint64_t count;
+
+		OpCodeProfile();
+	};
+
+	struct FunctionProfile
+	{
+		std::string functionHash;
+		FunctionCounters counters;
+	};
+
+	struct AddressProfile
+	{
+		Int codeOffset;
+		std::string functionHash;
+		std::string sourceLine; // 'path:line', empty for code built from no line
+		uint64_t count;
+
+		AddressProfile();
+	};
+
+	// counts of a profiler resolved to opcode and function names, sorted by count
+	struct ProgramProfile
+	{
+		uint64_t instructionCount;
+		std::vector<OpCodeProfile> opCodes;
+		std::vector<FunctionProfile> functions;
+		std::vector<AddressProfile> addresses;
+
+		ProgramProfile();
+	};
+
+	// writes tables of the functions, opcodes and addresses, at most maxRows each
+	void WriteProfileText(const ProgramProfile& profile, size_t maxRows, std::string& outText);
+
+	void WriteProfileJson(const ProgramProfile& profile, std::string& outJson);
+
+	// adds 'runName.counter' values of the counters
+	void AddCounterValues(const std::string& runName, const ExecutionCounters& counters, std::map<std::string, uint64_t>& inoutValues);
+
+	// one 'name value' line per counter
+	void WriteCounterValues(const std::map<std::string, uint64_t>& values, std::string& outText);
+
+	void ReadCounterValues(const std::string& text, std::map<std::string, uint64_t>& outValues);
+
+	// writes a line per counter that changed, fails if one grew by more than thresholdPercent or 
+	// is missing from current
+	bool CompareCounterValues(
+		const std::map<std::string, uint64_t>& baseline,
+		const std::map<std::string, uint64_t>& current,
+		double thresholdPercent,
+		std::string& outReport
+	);
+
+	// one line per distinct call stack, 'outer;inner count', the input format of flamegraph tools
+	void WriteCollapsedStacks(const VMSampler& sampler, const FunctionEntries& functionEntries, std::string& outText);
+}
\ No newline at end of file
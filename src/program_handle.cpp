@@ -4,10 +4,84 @@
 #include "lexer.h"
 #include "file_io.h"
 #include "standard_toolkit.h"
+#include "parallel_run.h"
+#include "disassembler.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <mutex>
 #include <set>
 
 namespace Tolo
 {
+	ScriptFunctionInfo::ScriptFunctionInfo() :
+		p_functionIp(nullptr),
+		parametersSize(0),
+		localsSize(0),
+		returnValueSize(0)
+	{}
+
+
+	ExecutionScope::ExecutionScope(ProgramHandle* _p_program) :
+		p_program(_p_program),
+		uncaughtExceptionCount(std::uncaught_exceptions())
+	{
+		// calls of an earlier run that failed never returned
+		if (p_program->executionDepth++ == 0)
+			p_program->profiler.ClearCalls();
+
+#ifdef PROFILE_VM
+		// eight bytes per byte of code are only spent when the VM counts
+		p_program->profiler.offsetCounts.resize(static_cast<size_t>(p_program->codeEnd), 0);
+		instruments.p_profiler = &p_program->profiler;
+#endif
+		instruments.p_sampler = p_program->isSampling ? &p_program->sampler : nullptr;
+		instruments.p_counters = p_program->isCounting ? &p_program->counters : nullptr;
+		instruments.p_tracer = p_program->isTracing ? &p_program->tracer : nullptr;
+		instruments.p_heapProfiler = p_program->isHeapProfiling ? &p_program->heapProfiler : nullptr;
+		instruments.p_coverage = p_program->isCovering ? &p_program->coverage : nullptr;
+	}
+
+	ExecutionScope::~ExecutionScope()
+	{
+		if (--p_program->executionDepth != 0)
+			return;
+
+		// the trace still ends with the instruction that failed
+		if (std::uncaught_exceptions() > uncaughtExceptionCount)
+			p_program->DumpTraceOfFailedRun();
+
+		p_program->ApplyHotReload();
+	}
+
+	const VMInstruments& ExecutionScope::GetInstruments() const
+	{
+		return instruments;
+	}
+
+	void ExecutionScope::RecordStackHighWater(Ptr p_stackHighWater) const
+	{
+		p_program->stackHighWater = std::max(p_program->stackHighWater, static_cast<Int>(p_stackHighWater - p_program->p_stack));
+	}
+
+
+	FunctionSwap::FunctionSwap(const std::string& _functionHash, const CodeBuilder* _p_code, const ScriptFunctionInfo& _info) :
+		functionHash(_functionHash),
+		p_code(_p_code),
+		info(_info)
+	{}
+
+
+	LazyFunction::LazyFunction(const std::string& _functionHash, EDefineFunction* _p_defFuncExp) :
+		functionHash(_functionHash),
+		p_defFuncExp(_p_defFuncExp),
+		isBuilt(false)
+	{}
+
+
 	FunctionHandle::FunctionHandle() :
 		p_function(nullptr)
 	{}
@@ -71,7 +145,20 @@ namespace Tolo
 		codeStart(0),
 		codeEnd(0),
 		mainReturnValueSize(0),
-		mainParameterCount(mainFunctionParameterTypeNames.size())
+		mainParameterCount(mainFunctionParameterTypeNames.size()),
+		constStringsSize(0),
+		compileThreadCount(0),
+		mainCallEnd(0),
+		hotReloadCapacity(0),
+		lazyCompileCapacity(0),
+		appendedCodeLength(0),
+		executionDepth(0),
+		isSampling(false),
+		isCounting(false),
+		isTracing(false),
+		isHeapProfiling(false),
+		isCovering(false),
+		stackHighWater(0)
 	{
 		mainFunctionHash = GetFunctionHash(
 			mainFunctionReturnTypeName, 
@@ -207,12 +294,12 @@ namespace Tolo
 	)
 	{
 		Affirm(
-			typeNameToStructInfo.count(structName) == 0,
+			std::none_of(structs.begin(), structs.end(), [&](const StructHandle& structHandle) { return structHandle.typeName == structName; }),
 			"struct '%s' is already defined",
 			structName.c_str()
 		);
 
-		StructInfo& info = typeNameToStructInfo[structName];
+		std::set<std::string> memberNames;
 		
 		const std::string structPtrName = structName + "::ptr";
 		typeNameToSize[structPtrName] = static_cast<Int>(sizeof(Ptr));
@@ -233,17 +320,16 @@ namespace Tolo
 			);
 
 			Affirm(
-				info.memberNameToVarInfo.count(prop.second) == 0,
+				memberNames.insert(prop.second).second,
 				"property '%s' is already defined in struct '%s'",
 				prop.second.c_str(), structName.c_str()
 			);
 
-			info.memberNameToVarInfo[prop.second] = VariableInfo(prop.first, propertyOffset);
-			info.memberNames.push_back(prop.second);
 			propertyOffset += typeNameToSize[prop.first];
 		}
 
 		typeNameToSize[structName] = propertyOffset;
+		structs.emplace_back(structName, members);
 	}
 
 	void ProgramHandle::AddEnum(
@@ -274,48 +360,364 @@ namespace Tolo
 		}
 	}
 
-	void ProgramHandle::Compile()
+	void ProgramHandle::PreprocessCode(std::string& outCode)
 	{
+		auto start = std::chrono::steady_clock::now();
 		std::string rawCode;
 		ReadTextFile(codePath, rawCode);
+		compileStats.readSeconds = SecondsSince(start);
 
+		start = std::chrono::steady_clock::now();
 		std::map<std::string, bool> standardIncludeFlags;
 		for (auto pair : standardTookitAdders)
 			standardIncludeFlags[pair.first] = false;
 
-		std::string code;
-		Preprocess(rawCode, code, standardIncludeFlags);
+		Preprocess(codePath, rawCode, outCode, standardIncludeFlags, sourceMap);
+		compileStats.sourceBytes = outCode.size();
 
+		// toolkits added by an earlier compile stay
 		for (auto pair : standardIncludeFlags)
 		{
-			if (pair.second)
+			if (pair.second && std::find(standardIncludes.begin(), standardIncludes.end(), pair.first) == standardIncludes.end())
+			{
 				standardTookitAdders.at(pair.first)(*this);
+				standardIncludes.push_back(pair.first);
+			}
+		}
+
+		compileStats.preprocessSeconds = SecondsSince(start);
+	}
+
+	// a function body and the code to build it into
+	struct FunctionBuild
+	{
+		const PendingFunctionBody* p_body;
+		CodeBuilder* p_code;
+		std::set<std::string> calleeHashes;
+
+		FunctionBuild(const PendingFunctionBody* _p_body);
+	};
+
+	FunctionBuild::FunctionBuild(const PendingFunctionBody* _p_body) :
+		p_body(_p_body),
+		p_code(nullptr)
+	{}
+
+	// parses and builds function bodies, each into its own code, on several threads, the bodies 
+	// only read the declarations so each thread works on a copy of them, if bodies fail the error
+	// of the first one in the list is rethrown whatever thread got to it first
+	static void BuildFunctionBodies(
+		Parser& parser, 
+		const SymbolTable& symbols, 
+		size_t threadCount, 
+		std::vector<FunctionBuild>& builds,
+		CompileStats& inoutStats
+	)
+	{
+		std::atomic<size_t> nextBuild(0);
+		std::mutex errorMutex;
+		size_t failedBuild = builds.size();
+		std::exception_ptr buildError;
+
+		auto buildBodies = [&](Parser& bodyParser)
+		{
+			// builds are taken in order, so a thread that failed takes no build it could still report
+			for (size_t i = nextBuild++; i < builds.size(); i = nextBuild++)
+			{
+				{
+					std::lock_guard<std::mutex> lock(errorMutex);
+
+					if (i > failedBuild)
+						return;
+				}
+
+				try
+				{
+					FunctionBuild& build = builds[i];
+					EDefineFunction* p_defFuncExp = build.p_body->p_defFuncExp;
+					bodyParser.PFunctionBody(*build.p_body);
+					p_defFuncExp->Evaluate(*build.p_code);
+					build.calleeHashes = bodyParser.currentCallees;
+
+					// the body expressions can die with the arena of a thread, the code is appended instead
+					p_defFuncExp->body.clear();
+					p_defFuncExp->p_code = build.p_code;
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(errorMutex);
+
+					if (i < failedBuild)
+					{
+						failedBuild = i;
+						buildError = std::current_exception();
+					}
+				}
+			}
+		};
+
+		if (threadCount <= 1)
+		{
+			buildBodies(parser);
+
+			if (buildError)
+				std::rethrow_exception(buildError);
+
+			return;
+		}
+
+		std::atomic<size_t> expressionCount(0);
+		std::atomic<size_t> usedBytes(0);
+		std::atomic<size_t> reservedBytes(0);
+
+		RunInParallel(threadCount, [&](size_t)
+		{
+			Arena arena;
+			SymbolTable threadSymbols(symbols);
+			Parser threadParser(parser, arena, threadSymbols);
+			buildBodies(threadParser);
+
+			expressionCount += arena.GetAllocationCount();
+			usedBytes += arena.GetUsedBytes();
+			reservedBytes += arena.GetReservedBytes();
+		});
+
+		inoutStats.expressionCount += expressionCount;
+		inoutStats.arenaUsedBytes += usedBytes;
+		inoutStats.arenaReservedBytes += reservedBytes;
+
+		if (buildError)
+			std::rethrow_exception(buildError);
+	}
+
+	void ProgramHandle::CompileCode(const std::string& code)
+	{
+		auto start = std::chrono::steady_clock::now();
+		SymbolTable symbols;
+		TokenStream tokenStream(code, symbols);
+
+		// lex nodes only live until the code is built
+		Arena arena;
+
+		Lexer lexer(arena);
+		std::vector<LexNode*> lexNodes;
+		lexer.Lex(tokenStream, lexNodes);
+
+		compileStats.lexSeconds = SecondsSince(start);
+		compileStats.tokenCount = tokenStream.GetReadTokenCount();
+		compileStats.lexNodeCount = arena.GetAllocationCount();
+		compileStats.arenaUsedBytes += arena.GetUsedBytes();
+		compileStats.arenaReservedBytes += arena.GetReservedBytes();
+
+		BuildCode(lexNodes, symbols, nullptr);
+	}
+
+	void ProgramHandle::LexCached(IncrementalCache& cache, const std::string& code, std::vector<LexNode*>& outLexNodes)
+	{
+		auto start = std::chrono::steady_clock::now();
+		cache.Lex(code, sourceMap, outLexNodes);
+
+		// chunks lexed by an earlier compile are not counted
+		compileStats.lexSeconds = SecondsSince(start);
+		compileStats.tokenCount = cache.GetLexedTokenCount();
+		compileStats.lexNodeCount = cache.GetLexedNodeCount();
+	}
+
+	// members, size, parent and v-table of a struct, code built for one layout breaks with another
+	static std::string GetStructLayout(const Parser& parser, SymbolId structId)
+	{
+		const StructInfo& structInfo = parser.typeIdToStructInfo.at(structId);
+		std::string layout = std::to_string(parser.typeIdToSize.at(structId)) + "{";
+
+		for (SymbolId memberId : structInfo.memberIds)
+		{
+			const VariableInfo& memberInfo = structInfo.memberIdToVarInfo.at(memberId);
+			layout += parser.GetTypeName(memberInfo.typeId) + " " + parser.p_symbols->GetName(memberId) + "@" + std::to_string(memberInfo.offset) + ";";
+		}
+
+		layout += "}";
+
+		auto parentIt = parser.structIdToParentStructId.find(structId);
+
+		if (parentIt != parser.structIdToParentStructId.end())
+			layout += ":" + parser.GetTypeName(parentIt->second);
+
+		auto vTableIt = parser.structNameToVTable.find(parser.GetTypeName(structId));
+
+		if (vTableIt != parser.structNameToVTable.end())
+		{
+			for (const auto& e : vTableIt->second)
+				layout += e.first + "=" + e.second.globalHash + "@" + std::to_string(e.second.vTableOffset) + ";";
 		}
 
-		std::vector<Token> tokens;
-		Tokenize(code, tokens);
+		return layout;
+	}
+
+	static ScriptFunctionInfo MakeScriptFunctionInfo(const Parser& parser, const FunctionInfo& funcInfo, Ptr p_functionIp)
+	{
+		ScriptFunctionInfo info;
+		info.p_functionIp = p_functionIp;
+		info.parametersSize = funcInfo.parametersSize;
+		info.localsSize = funcInfo.localsSize;
+		info.returnValueSize = parser.typeIdToSize.at(funcInfo.returnTypeId);
+
+		return info;
+	}
+
+	// size of the const strings code built into its own buffer adds when it is appended
+	static Int GetConstStringsSize(const CodeBuilder& code)
+	{
+		Int size = 0;
+
+		for (const ConstStringFixup& fixup : code.constStringFixups)
+			size += static_cast<Int>(fixup.value.size()) + 1;
+
+		return size;
+	}
 
-		Lexer lexer;
-		std::vector<std::shared_ptr<LexNode>> lexNodes;
-		lexer.Lex(tokens, lexNodes);
+	// 'Load_Const_Ptr new ip, Write_IP' written over the old entry of a hot reloaded function
+	static constexpr Int ENTRY_JUMP_SIZE = static_cast<Int>(sizeof(Char) + sizeof(Ptr) + sizeof(Char));
 
-		Parser parser;
+	void ProgramHandle::InitParser(Parser& parser)
+	{
 		parser.hashToNativeFunctions = hashToNativeFunctions;
-		parser.typeNameToStructInfo = typeNameToStructInfo;
-		parser.enumNamespaces = enumNamespaces;
-		parser.nameToEnumValue = nameToEnumValue;
+		parser.enumNamespaces.insert(enumNamespaces.begin(), enumNamespaces.end());
+		parser.nameToEnumValue.insert(nameToEnumValue.begin(), nameToEnumValue.end());
+
+		// in the order they were added, as a struct can contain the structs added before it
+		for (const StructHandle& structHandle : structs)
+			parser.AddNativeStruct(structHandle.typeName, structHandle.properties);
+	}
+
+	void ProgramHandle::BuildFunctions(
+		Parser& parser, 
+		SymbolTable& symbols, 
+		IncrementalCache* p_cache, 
+		std::vector<CodeBuilder>& outFunctionCode, 
+		std::vector<const PendingFunctionBody*>& outBuiltBodies
+	)
+	{
+		// function bodies are built on their own, unless they did not change since the last compile
+		std::vector<FunctionBuild> builds;
+
+		if (p_cache != nullptr)
+			p_cache->SetDeclarations(parser);
+
+		for (const PendingFunctionBody& body : parser.functionBodies)
+		{
+			const CodeBuilder* p_code = p_cache != nullptr ? p_cache->FindFunctionCode(parser, body) : nullptr;
+
+			if (p_code != nullptr)
+			{
+				body.p_defFuncExp->p_code = p_code;
+				continue;
+			}
+
+			builds.emplace_back(&body);
+			outBuiltBodies.push_back(&body);
+		}
+
+		size_t threadCount = compileThreadCount > 0 ? compileThreadCount : GetDefaultThreadCount();
+		threadCount = std::min(threadCount, builds.size());
+
+		if (p_cache != nullptr)
+		{
+			for (FunctionBuild& build : builds)
+				build.p_code = &p_cache->AddFunctionCode(*build.p_body);
+
+			BuildFunctionBodies(parser, symbols, threadCount, builds, compileStats);
+
+			for (const FunctionBuild& build : builds)
+			{
+				// leave room to write a jump over the entry of the function
+				if (hotReloadCapacity > 0)
+				{
+					while (build.p_code->codeLength < ENTRY_JUMP_SIZE)
+						build.p_code->ConstChar(0);
+				}
+
+				p_cache->SetFunctionCallees(parser, *build.p_body, build.calleeHashes);
+			}
+		}
+		else if (threadCount > 1)
+		{
+			outFunctionCode.resize(builds.size());
+
+			for (size_t i = 0; i < builds.size(); i++)
+				builds[i].p_code = &outFunctionCode[i];
+
+			BuildFunctionBodies(parser, symbols, threadCount, builds, compileStats);
+		}
+		else
+		{
+			// parsed in place and built along with the rest of the code
+			for (const FunctionBuild& build : builds)
+				parser.PFunctionBody(*build.p_body);
+		}
+	}
+
+	void ProgramHandle::BuildCode(const std::vector<LexNode*>& lexNodes, SymbolTable& symbols, IncrementalCache* p_cache)
+	{
+		Affirm(
+			hotReloadCapacity == 0 || p_cache != nullptr,
+			"hot reloadable programs have to be compiled with an incremental cache"
+		);
 
-		// transfer struct type sizes and struct pointers
-		for (auto& e : typeNameToStructInfo)
+		Affirm(
+			hotReloadCapacity == 0 || lazyCompileCapacity == 0,
+			"hot reloadable programs can not be compiled lazily"
+		);
+
+		// expressions only live until the code is built, unless functions are built on their first call
+		lazyFunctions.clear();
+		p_lazyArena = lazyCompileCapacity > 0 ? std::make_unique<Arena>() : nullptr;
+
+		Arena localArena;
+		Arena& arena = p_lazyArena != nullptr ? *p_lazyArena : localArena;
+
+		Parser parser(arena, symbols);
+		InitParser(parser);
+
+		auto start = std::chrono::steady_clock::now();
+		std::vector<Expression*> expressions;
+		parser.ParseDeclarations(lexNodes, expressions);
+		compileStats.declarationsSeconds = SecondsSince(start);
+
+		start = std::chrono::steady_clock::now();
+		std::vector<CodeBuilder> functionCode;
+		std::vector<const PendingFunctionBody*> builtBodies;
+
+		if (lazyCompileCapacity > 0)
+		{
+			// parse all bodies to find errors now, but only build a stub for each function that
+			// asks the program to build it
+			functionCode.resize(parser.functionBodies.size());
+
+			for (size_t i = 0; i < parser.functionBodies.size(); i++)
+			{
+				const PendingFunctionBody& body = parser.functionBodies[i];
+				parser.PFunctionBody(body);
+
+				CodeBuilder& stub = functionCode[i];
+				stub.DefineLabel(body.funcHash);
+				stub.Op(OpCode::Load_Const_Ptr); stub.ConstPtr(reinterpret_cast<Ptr>(this));
+				stub.Op(OpCode::Load_Const_Int); stub.ConstInt(static_cast<Int>(i));
+				stub.Op(OpCode::Load_Const_Ptr); stub.ConstPtr(reinterpret_cast<Ptr>(&OnLazyFunctionCall));
+				stub.Op(OpCode::Call_Native);
+				stub.Op(OpCode::Write_IP);
+
+				body.p_defFuncExp->p_code = &stub;
+				lazyFunctions.emplace_back(body.funcHash, body.p_defFuncExp);
+			}
+		}
+		else
 		{
-			parser.typeNameToSize[e.first] = typeNameToSize[e.first];
-			std::string structPtrName = e.first + "::ptr";
-			parser.typeNameToSize[structPtrName] = static_cast<Int>(sizeof(Ptr));
-			parser.ptrTypeNameToStructTypeName[structPtrName] = e.first;
+			BuildFunctions(parser, symbols, p_cache, functionCode, builtBodies);
 		}
 
-		std::vector<std::shared_ptr<Expression>> expressions;
-		parser.Parse(lexNodes, expressions);
+		compileStats.functionsSeconds = SecondsSince(start);
+		compileStats.builtFunctionCount = builtBodies.size();
+		start = std::chrono::steady_clock::now();
 
 		Affirm(
 			parser.hashToUserFunctions.count(mainFunctionHash) != 0,
@@ -328,8 +730,8 @@ namespace Tolo
 
 		for (size_t i = 0; i < mainInfo.parameterNames.size(); i++)
 		{
-			const std::string& paramTypeName = mainInfo.varNameToVarInfo[mainInfo.parameterNames[i]].typeName;
-			mainParamsSize += parser.typeNameToSize[paramTypeName];
+			SymbolId paramTypeId = mainInfo.varNameToVarInfo[mainInfo.parameterNames[i]].typeId;
+			mainParamsSize += parser.typeIdToSize[paramTypeId];
 		}
 
 		CodeBuilder cb(p_stack, stackSize, constStringCapacity);
@@ -338,32 +740,1119 @@ namespace Tolo
 		cb.codeLength += mainParamsSize;
 
 		codeStart = cb.codeLength;
-		mainReturnValueSize = parser.typeNameToSize[mainInfo.returnTypeName];
+		mainReturnValueSize = parser.typeIdToSize[mainInfo.returnTypeId];
 
 		ECallFunction mainCall(mainParamsSize, mainInfo.localsSize);
 		// tell the main function to load arguments
-		mainCall.argumentLoads = { std::make_shared<ELoadConstBytes>(mainParamsSize, p_stack + constStringCapacity) };
-		mainCall.functionIpLoad = std::make_shared<ELoadConstPtrToLabel>(mainFunctionHash);
+		mainCall.argumentLoads = { arena.New<ELoadConstBytes>(mainParamsSize, p_stack + constStringCapacity) };
+		mainCall.functionIpLoad = arena.New<ELoadConstPtrToLabel>(mainFunctionHash);
 		mainCall.Evaluate(cb);
-		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel("0program_end");
+		mainCallEnd = cb.codeLength;
+		LabelId programEndLabel = cb.CreateLabel();
+		cb.Op(OpCode::Load_Const_Ptr); cb.ConstPtrToLabel(programEndLabel);
 		cb.Op(OpCode::Write_IP);
 
 		for (auto e : expressions)
 			e->Evaluate(cb);
 
-		cb.DefineLabel("0program_end");
-		cb.RemoveLabel("0program_end");
+		// the stack starts behind the space kept for hot reloads and lazy functions
+		Int appendCapacity = hotReloadCapacity + lazyCompileCapacity;
 
 		Affirm(
-			!cb.HasUnresolvedLabels(),
-			"unresolved labels after building code"
+			cb.codeLength + appendCapacity <= stackSize,
+			"stack overflowed when reserving the hot reload or lazy compile capacity"
 		);
 
+		appendedCodeLength = cb.codeLength;
+		cb.codeLength += appendCapacity;
+
+		cb.DefineLabel(programEndLabel);
+		cb.ResolveLabels();
+
 		codeEnd = cb.codeLength;
+		constStringsSize = static_cast<Int>(cb.p_nextConstStringIp - p_stack);
+		relocations = cb.relocations;
+		codeLines = cb.codeLines;
+
+		compileStats.codeSeconds = SecondsSince(start);
+		compileStats.expressionCount += arena.GetAllocationCount();
+		compileStats.arenaUsedBytes += arena.GetUsedBytes();
+		compileStats.arenaReservedBytes += arena.GetReservedBytes();
+
+		// resolve entry points of all user functions for 'GetFunction'
+		hashToScriptFunctions.clear();
+
+		for (auto& e : parser.hashToUserFunctions)
+			hashToScriptFunctions[e.first] = MakeScriptFunctionInfo(parser, e.second, cb.GetLabelIp(e.first));
+
+		profiler.Reset(p_stack);
+		stackHighWater = 0;
+
+		if (isCovering)
+			coverage.Reset(p_stack, codeEnd);
+
+		// the stubs are gone with the code builders, lazy functions build their bodies
+		for (LazyFunction& lazyFunction : lazyFunctions)
+			lazyFunction.p_defFuncExp->p_code = nullptr;
+
+		// keep what appended code links against and a hot reload checks
+		labelNameToIp.clear();
+		functionHashToOldIps.clear();
+		structNameToLayout.clear();
+		pendingSwaps.clear();
+
+		if (appendCapacity > 0)
+		{
+			for (const auto& e : cb.labelNameToLabelId)
+				labelNameToIp[e.first] = cb.GetLabelIp(e.first);
+		}
+
+		if (hotReloadCapacity > 0)
+		{
+			for (const auto& e : parser.typeIdToStructInfo)
+				structNameToLayout[parser.GetTypeName(e.first)] = GetStructLayout(parser, e.first);
+		}
 	}
 
-	const std::string& ProgramHandle::GetCodePath() const
+	void ProgramHandle::SwapFunctions(const std::vector<FunctionSwap>& swaps)
 	{
-		return codePath;
+		CodeBuilder cb(p_stack, codeEnd, constStringCapacity);
+		cb.codeLength = appendedCodeLength;
+		cb.p_nextConstStringIp = p_stack + constStringsSize;
+
+		// the const strings stored so far are shared with the new code
+		for (Int offset = 0; offset < constStringsSize;)
+		{
+			std::string constString(reinterpret_cast<const char*>(p_stack + offset));
+			cb.constStringToIp.emplace(constString, p_stack + offset);
+			offset += static_cast<Int>(constString.size()) + 1;
+		}
+
+		// the new code calls the swapped functions at their new entries and all others at their
+		// current ones
+		std::set<std::string> swappedHashes;
+
+		for (const FunctionSwap& swap : swaps)
+			swappedHashes.insert(swap.functionHash);
+
+		for (const auto& e : labelNameToIp)
+		{
+			if (swappedHashes.count(e.first) == 0)
+				cb.labelOffsets[cb.GetNamedLabel(e.first)] = static_cast<Int>(e.second - p_stack);
+		}
+
+		for (const FunctionSwap& swap : swaps)
+			cb.Append(*swap.p_code);
+
+		cb.ResolveLabels();
+
+		relocations.stackPtrOffsets.insert(
+			relocations.stackPtrOffsets.end(), 
+			cb.relocations.stackPtrOffsets.begin(), 
+			cb.relocations.stackPtrOffsets.end()
+		);
+		relocations.offsetToNativeFunctionHash.insert(
+			cb.relocations.offsetToNativeFunctionHash.begin(),
+			cb.relocations.offsetToNativeFunctionHash.end()
+		);
+		codeLines.insert(codeLines.end(), cb.codeLines.begin(), cb.codeLines.end());
+
+		// jump from all earlier entries of a swapped function to the new one
+		std::vector<std::pair<Int, Int>> jumpRanges;
+
+		for (const FunctionSwap& swap : swaps)
+		{
+			Ptr p_newIp = cb.GetLabelIp(swap.functionHash);
+			std::vector<Ptr>& oldIps = functionHashToOldIps[swap.functionHash];
+			auto labelIt = labelNameToIp.find(swap.functionHash);
+
+			if (labelIt != labelNameToIp.end())
+				oldIps.push_back(labelIt->second);
+
+			for (Ptr p_oldIp : oldIps)
+			{
+				*p_oldIp = static_cast<Char>(OpCode::Load_Const_Ptr);
+				*reinterpret_cast<Ptr*>(p_oldIp + sizeof(Char)) = p_newIp;
+				*(p_oldIp + sizeof(Char) + sizeof(Ptr)) = static_cast<Char>(OpCode::Write_IP);
+
+				Int jumpOffset = static_cast<Int>(p_oldIp - p_stack);
+				jumpRanges.push_back({ jumpOffset, jumpOffset + ENTRY_JUMP_SIZE });
+			}
+
+			labelNameToIp[swap.functionHash] = p_newIp;
+			hashToScriptFunctions[swap.functionHash] = swap.info;
+			hashToScriptFunctions[swap.functionHash].p_functionIp = p_newIp;
+
+			// the call into main embeds its locals size
+			if (swap.functionHash == mainFunctionHash)
+				*reinterpret_cast<Int*>(p_stack + mainCallEnd - sizeof(Int)) = swap.info.localsSize;
+		}
+
+		// pointers of the overwritten code are gone, the jump targets are new ones
+		std::sort(jumpRanges.begin(), jumpRanges.end());
+
+		auto isOverwritten = [&](Int offset)
+		{
+			auto it = std::upper_bound(jumpRanges.begin(), jumpRanges.end(), std::make_pair(offset, std::numeric_limits<Int>::max()));
+			return it != jumpRanges.begin() && offset < std::prev(it)->second;
+		};
+
+		std::vector<Int> stackPtrOffsets;
+
+		for (Int offset : relocations.stackPtrOffsets)
+		{
+			if (!isOverwritten(offset))
+				stackPtrOffsets.push_back(offset);
+		}
+
+		for (const auto& range : jumpRanges)
+			stackPtrOffsets.push_back(range.first + static_cast<Int>(sizeof(Char)));
+
+		relocations.stackPtrOffsets = std::move(stackPtrOffsets);
+
+		for (auto it = relocations.offsetToNativeFunctionHash.begin(); it != relocations.offsetToNativeFunctionHash.end();)
+		{
+			if (isOverwritten(it->first))
+				it = relocations.offsetToNativeFunctionHash.erase(it);
+			else
+				++it;
+		}
+
+		appendedCodeLength = cb.codeLength;
+		constStringsSize = static_cast<Int>(cb.p_nextConstStringIp - p_stack);
+	}
+
+	void ProgramHandle::ApplyHotReload()
+	{
+		if (pendingSwaps.empty())
+			return;
+
+		SwapFunctions(pendingSwaps);
+		pendingSwaps.clear();
+	}
+
+	Ptr ProgramHandle::BuildLazyFunction(Int lazyIndex)
+	{
+		LazyFunction& lazyFunction = lazyFunctions.at(static_cast<size_t>(lazyIndex));
+
+		CodeBuilder code;
+		lazyFunction.p_defFuncExp->Evaluate(code);
+
+		Affirm(
+			appendedCodeLength + code.codeLength <= codeEnd,
+			"failed to build function '%s' on its first call, it needs %i bytes but only %i bytes of the lazy compile capacity are left",
+			lazyFunction.functionHash.c_str(), code.codeLength, codeEnd - appendedCodeLength
+		);
+
+		Affirm(
+			constStringsSize + GetConstStringsSize(code) <= constStringCapacity,
+			"failed to build function '%s' on its first call, const strings overflowed",
+			lazyFunction.functionHash.c_str()
+		);
+
+		SwapFunctions({ FunctionSwap(lazyFunction.functionHash, &code, hashToScriptFunctions.at(lazyFunction.functionHash)) });
+		lazyFunction.isBuilt = true;
+
+		return labelNameToIp.at(lazyFunction.functionHash);
+	}
+
+	void ProgramHandle::OnLazyFunctionCall(VirtualMachine& vm)
+	{
+		Int lazyIndex = Pop<Int>(vm);
+		ProgramHandle* p_program = reinterpret_cast<ProgramHandle*>(Pop<Ptr>(vm));
+		Push<Ptr>(vm, p_program->BuildLazyFunction(lazyIndex));
+	}
+
+	void ProgramHandle::ApplyImage(const ProgramImage& image, const std::string& imageName)
+	{
+		const ImageHeader& header = image.header;
+
+		Affirm(
+			image.mainFunctionHash == mainFunctionHash,
+			"program image '%s' was built for main function '%s'",
+			imageName.c_str(), image.mainFunctionHash.c_str()
+		);
+
+		Affirm(
+			header.constStringCapacity == constStringCapacity &&
+			header.codeEnd <= stackSize,
+			"program image '%s' does not fit the stack layout of this program",
+			imageName.c_str()
+		);
+
+		std::vector<Ptr> nativeFunctionPtrs;
+
+		for (const std::string& hash : image.nativeFunctionHashes)
+		{
+			Affirm(
+				hashToNativeFunctions.count(hash) != 0,
+				"native function '%s' required by program image is not defined",
+				hash.c_str()
+			);
+
+			nativeFunctionPtrs.push_back(hashToNativeFunctions.at(hash).p_functionPtr);
+		}
+
+		std::memcpy(p_stack, image.p_constStrings, static_cast<size_t>(header.constStringsSize));
+		std::memcpy(p_stack + constStringCapacity, image.p_code, static_cast<size_t>(header.codeEnd - constStringCapacity));
+
+		relocations = CodeRelocations();
+
+		for (Int offset : image.stackRelocations)
+		{
+			Affirm(
+				offset >= constStringCapacity && offset + static_cast<Int>(sizeof(Ptr)) <= header.codeEnd,
+				"program image '%s' is corrupt",
+				imageName.c_str()
+			);
+
+			Set<Ptr>(p_stack + offset, p_stack + Get<std::intptr_t>(p_stack + offset));
+			relocations.stackPtrOffsets.push_back(offset);
+		}
+
+		for (const ImageNativeRelocation& reloc : image.nativeRelocations)
+		{
+			Affirm(
+				reloc.codeOffset >= constStringCapacity && 
+				reloc.codeOffset + static_cast<Int>(sizeof(Ptr)) <= header.codeEnd &&
+				reloc.nativeIndex >= 0 && 
+				reloc.nativeIndex < static_cast<Int>(nativeFunctionPtrs.size()),
+				"program image '%s' is corrupt",
+				imageName.c_str()
+			);
+
+			Set<Ptr>(p_stack + reloc.codeOffset, nativeFunctionPtrs[reloc.nativeIndex]);
+			relocations.offsetToNativeFunctionHash[reloc.codeOffset] = image.nativeFunctionHashes[reloc.nativeIndex];
+		}
+
+		hashToScriptFunctions.clear();
+
+		for (size_t i = 0; i < image.scriptFunctions.size(); i++)
+		{
+			const ImageScriptFunction& imageFunc = image.scriptFunctions[i];
+			ScriptFunctionInfo& info = hashToScriptFunctions[image.scriptFunctionHashes[i]];
+			info.p_functionIp = p_stack + imageFunc.ipOffset;
+			info.parametersSize = imageFunc.parametersSize;
+			info.localsSize = imageFunc.localsSize;
+			info.returnValueSize = imageFunc.returnValueSize;
+		}
+
+		codeLines.clear();
+
+		for (const ImageCodeLine& imageLine : image.codeLines)
+			codeLines.push_back({ imageLine.offset, imageLine.line });
+
+		standardIncludes = image.standardIncludes;
+		constStringsSize = header.constStringsSize;
+		codeStart = header.codeStart;
+		codeEnd = header.codeEnd;
+		appendedCodeLength = header.codeEnd;
+		mainReturnValueSize = header.mainReturnValueSize;
+		profiler.Reset(p_stack);
+		stackHighWater = 0;
+
+		if (isCovering)
+			coverage.Reset(p_stack, codeEnd);
+
+		// images keep no state to hot reload against and hold no lazy functions
+		lazyFunctions.clear();
+		p_lazyArena = nullptr;
+		p_hotReloadCache = nullptr;
+		labelNameToIp.clear();
+		functionHashToOldIps.clear();
+		structNameToLayout.clear();
+		pendingSwaps.clear();
+	}
+
+	std::string ProgramHandle::GetCompileCacheKey(const std::string& code) const
+	{
+		// everything besides the source that changes the result of compiling it
+		std::string key = std::to_string(HashBytes(code.data(), code.size()));
+		key += "|" + mainFunctionHash;
+		key += "|" + std::to_string(constStringCapacity) + "|" + std::to_string(sizeof(Ptr));
+
+		for (auto& e : hashToNativeFunctions)
+			key += "|" + e.first;
+
+		for (const StructHandle& structHandle : structs)
+		{
+			key += "|struct " + structHandle.typeName;
+
+			for (const auto& prop : structHandle.properties)
+				key += " " + prop.first + " " + prop.second;
+		}
+
+		for (auto& e : nameToEnumValue)
+			key += "|enum " + e.first + "=" + std::to_string(e.second);
+
+		return key;
+	}
+
+	void ProgramHandle::SetHotReloadCapacity(Int capacity)
+	{
+		Affirm(capacity >= 0, "hot reload capacity can not be negative");
+
+		hotReloadCapacity = capacity;
+	}
+
+	void ProgramHandle::SetLazyCompileCapacity(Int capacity)
+	{
+		Affirm(capacity >= 0, "lazy compile capacity can not be negative");
+
+		lazyCompileCapacity = capacity;
+	}
+
+	void ProgramHandle::Compile()
+	{
+		auto start = std::chrono::steady_clock::now();
+		compileStats = CompileStats();
+
+		std::string code;
+		PreprocessCode(code);
+
+		if (hotReloadCapacity == 0)
+		{
+			p_hotReloadCache = nullptr;
+			CompileCode(code);
+			FinishCompileStats(start);
+			return;
+		}
+
+		// the cache tells a hot reload which functions changed
+		p_hotReloadCache = std::make_unique<IncrementalCache>();
+
+		std::vector<LexNode*> lexNodes;
+		LexCached(*p_hotReloadCache, code, lexNodes);
+
+		BuildCode(lexNodes, p_hotReloadCache->GetSymbols(), p_hotReloadCache.get());
+		p_hotReloadCache->RemoveUnusedChunks();
+		FinishCompileStats(start);
+	}
+
+	void ProgramHandle::Compile(CompileCache& cache)
+	{
+		auto start = std::chrono::steady_clock::now();
+		compileStats = CompileStats();
+
+		std::string code;
+		PreprocessCode(code);
+
+		std::string key = GetCompileCacheKey(code);
+		std::shared_ptr<const std::string> imageData = cache.Find(key);
+
+		if (imageData != nullptr)
+		{
+			ProgramImage image;
+			DeserializeProgramImage(imageData->data(), imageData->size(), image);
+			ApplyImage(image, codePath);
+			compileStats.isFromImage = true;
+			FinishCompileStats(start);
+			return;
+		}
+
+		CompileCode(code);
+		BuildLazyFunctions();
+
+		auto newImageData = std::make_shared<std::string>();
+		BuildImage(*newImageData);
+		cache.Insert(key, newImageData);
+		FinishCompileStats(start);
+	}
+
+	void ProgramHandle::Compile(IncrementalCache& cache)
+	{
+		auto start = std::chrono::steady_clock::now();
+		compileStats = CompileStats();
+
+		std::string code;
+		PreprocessCode(code);
+
+		std::vector<LexNode*> lexNodes;
+		LexCached(cache, code, lexNodes);
+
+		p_hotReloadCache = nullptr;
+		BuildCode(lexNodes, cache.GetSymbols(), &cache);
+		cache.RemoveUnusedChunks();
+		FinishCompileStats(start);
+	}
+
+	void ProgramHandle::HotReload()
+	{
+		Affirm(
+			p_hotReloadCache != nullptr,
+			"failed to hot reload, the program was not compiled with a hot reload capacity"
+		);
+
+		Affirm(
+			pendingSwaps.empty(),
+			"failed to hot reload, the last hot reload still waits for the program to return"
+		);
+
+		auto compileStart = std::chrono::steady_clock::now();
+		compileStats = CompileStats();
+
+		std::string code;
+		PreprocessCode(code);
+
+		std::vector<LexNode*> lexNodes;
+		LexCached(*p_hotReloadCache, code, lexNodes);
+
+		Arena arena;
+		SymbolTable& symbols = p_hotReloadCache->GetSymbols();
+		Parser parser(arena, symbols);
+		InitParser(parser);
+
+		auto start = std::chrono::steady_clock::now();
+		std::vector<Expression*> expressions;
+		parser.ParseDeclarations(lexNodes, expressions);
+		compileStats.declarationsSeconds = SecondsSince(start);
+
+		Affirm(
+			parser.hashToUserFunctions.count(mainFunctionHash) != 0,
+			"failed to hot reload, no main function with signature '%s' found",
+			mainFunctionHash.c_str()
+		);
+
+		// code built for the old layouts stays in use
+		for (const auto& e : structNameToLayout)
+		{
+			SymbolId structId = symbols.Intern(e.first);
+
+			Affirm(
+				parser.typeIdToStructInfo.count(structId) != 0 && GetStructLayout(parser, structId) == e.second,
+				"failed to hot reload, the layout of struct '%s' changed",
+				e.first.c_str()
+			);
+		}
+
+		start = std::chrono::steady_clock::now();
+		std::vector<CodeBuilder> functionCode;
+		std::vector<const PendingFunctionBody*> builtBodies;
+		BuildFunctions(parser, symbols, p_hotReloadCache.get(), functionCode, builtBodies);
+		compileStats.functionsSeconds = SecondsSince(start);
+		compileStats.builtFunctionCount = builtBodies.size();
+		compileStats.expressionCount += arena.GetAllocationCount();
+		compileStats.arenaUsedBytes += arena.GetUsedBytes();
+		compileStats.arenaReservedBytes += arena.GetReservedBytes();
+
+		// check the space up front, so the swap itself can not fail
+		Int codeSize = 0;
+		Int constStringSize = 0;
+
+		for (const PendingFunctionBody* p_body : builtBodies)
+		{
+			const CodeBuilder& bodyCode = *p_body->p_defFuncExp->p_code;
+			codeSize += bodyCode.codeLength;
+			constStringSize += GetConstStringsSize(bodyCode);
+		}
+
+		// the running program never gets code that did not fit, build it again next time
+		if (appendedCodeLength + codeSize > codeEnd || constStringsSize + constStringSize > constStringCapacity)
+		{
+			for (const PendingFunctionBody* p_body : builtBodies)
+				p_hotReloadCache->RemoveFunctionCode(*p_body);
+		}
+
+		Affirm(
+			appendedCodeLength + codeSize <= codeEnd,
+			"failed to hot reload, the changed functions need %i bytes but only %i bytes of the hot reload capacity are left",
+			codeSize, codeEnd - appendedCodeLength
+		);
+
+		Affirm(
+			constStringsSize + constStringSize <= constStringCapacity,
+			"failed to hot reload, const strings overflowed"
+		);
+
+		for (const PendingFunctionBody* p_body : builtBodies)
+		{
+			const FunctionInfo& funcInfo = parser.hashToUserFunctions.at(p_body->funcHash);
+			pendingSwaps.emplace_back(p_body->funcHash, p_body->p_defFuncExp->p_code, MakeScriptFunctionInfo(parser, funcInfo, nullptr));
+		}
+
+		p_hotReloadCache->RemoveUnusedChunks();
+
+		if (executionDepth == 0)
+			ApplyHotReload();
+
+		FinishCompileStats(compileStart);
+	}
+
+	bool ProgramHandle::IsHotReloadPending() const
+	{
+		return !pendingSwaps.empty();
+	}
+
+	void ProgramHandle::BuildLazyFunctions()
+	{
+		for (size_t i = 0; i < lazyFunctions.size(); i++)
+		{
+			if (!lazyFunctions[i].isBuilt)
+				BuildLazyFunction(static_cast<Int>(i));
+		}
+	}
+
+	ProgramProfile ProgramHandle::GetProfile() const
+	{
+#ifndef PROFILE_VM
+		Affirm(false, "failed to get profile, PROFILE_VM is not defined");
+#endif
+
+		FunctionEntries entries;
+		GetFunctionEntries(entries);
+
+		auto getFunctionHash = [&](Ptr p_ip) -> std::string
+		{
+			const std::string* p_functionHash = entries.Find(p_ip);
+			return p_functionHash != nullptr ? *p_functionHash : "<program>";
+		};
+
+		ProgramProfile profile;
+		profile.instructionCount = profiler.instructionCount;
+
+		for (size_t i = 0; i < profiler.opCodeCounts.size(); i++)
+		{
+			if (profiler.opCodeCounts[i] == 0)
+				continue;
+
+			OpCodeProfile& opCode = profile.opCodes.emplace_back();
+			opCode.opCodeName = GetOpCodeName(static_cast<OpCode>(i));
+			opCode.count = profiler.opCodeCounts[i];
+		}
+
+		// a function entered through an old entry and its current one is counted once
+		std::map<std::string, FunctionCounters> hashToCounters;
+
+		for (const auto& e : profiler.entryToCounters)
+		{
+			FunctionCounters& counters = hashToCounters[getFunctionHash(e.first)];
+			counters.callCount += e.second.callCount;
+			counters.inclusiveInstructions += e.second.inclusiveInstructions;
+			counters.exclusiveInstructions += e.second.exclusiveInstructions;
+			counters.inclusiveSeconds += e.second.inclusiveSeconds;
+			counters.exclusiveSeconds += e.second.exclusiveSeconds;
+		}
+
+		for (const auto& e : hashToCounters)
+			profile.functions.push_back({ e.first, e.second });
+
+		for (size_t offset = 0; offset < profiler.offsetCounts.size(); offset++)
+		{
+			if (profiler.offsetCounts[offset] == 0)
+				continue;
+
+			AddressProfile& address = profile.addresses.emplace_back();
+			address.codeOffset = static_cast<Int>(offset);
+			address.functionHash = getFunctionHash(p_stack + offset);
+			address.count = profiler.offsetCounts[offset];
+
+			SourceLocation location;
+
+			if (GetSourceLocation(p_stack + offset, location))
+				address.sourceLine = sourceMap.filePaths[location.fileIndex] + ":" + std::to_string(location.line);
+		}
+
+		std::stable_sort(profile.opCodes.begin(), profile.opCodes.end(), [](const OpCodeProfile& lhs, const OpCodeProfile& rhs)
+		{
+			return lhs.count > rhs.count;
+		});
+
+		std::stable_sort(profile.functions.begin(), profile.functions.end(), [](const FunctionProfile& lhs, const FunctionProfile& rhs)
+		{
+			return lhs.counters.exclusiveInstructions > rhs.counters.exclusiveInstructions;
+		});
+
+		std::stable_sort(profile.addresses.begin(), profile.addresses.end(), [](const AddressProfile& lhs, const AddressProfile& rhs)
+		{
+			return lhs.count > rhs.count;
+		});
+
+		return profile;
+	}
+
+	void ProgramHandle::ResetProfile()
+	{
+		profiler.Reset(p_stack);
+	}
+
+	void ProgramHandle::StartSampling(Int sampleInterval, size_t sampleCapacity, size_t maxDepth)
+	{
+		sampler.Start(sampleInterval, sampleCapacity, maxDepth);
+		isSampling = true;
+	}
+
+	void ProgramHandle::StopSampling()
+	{
+		isSampling = false;
+	}
+
+	void ProgramHandle::StartCounting()
+	{
+		counters = ExecutionCounters();
+		isCounting = true;
+	}
+
+	void ProgramHandle::StopCounting()
+	{
+		isCounting = false;
+	}
+
+	const ExecutionCounters& ProgramHandle::GetExecutionCounters() const
+	{
+		return counters;
+	}
+
+	void ProgramHandle::StartTracing(size_t recordCapacity)
+	{
+		tracer.Start(p_stack, recordCapacity);
+		isTracing = true;
+	}
+
+	void ProgramHandle::StopTracing()
+	{
+		isTracing = false;
+	}
+
+	void ProgramHandle::GetTrace(std::string& outData) const
+	{
+		// native pointers differ between processes, the dump names them
+		std::map<Ptr, std::string> nativePtrToHash;
+
+		for (const auto& e : hashToNativeFunctions)
+			nativePtrToHash[e.second.p_functionPtr] = e.first;
+
+		ExecutionTrace trace;
+		CaptureExecutionTrace(tracer, nativePtrToHash, trace);
+		SerializeExecutionTrace(trace, outData);
+	}
+
+	void ProgramHandle::SetTraceDumpPath(const std::string& path)
+	{
+		traceDumpPath = path;
+	}
+
+	void ProgramHandle::DecodeTrace(const std::string& data, std::string& outText) const
+	{
+		ExecutionTrace trace;
+		DeserializeExecutionTrace(data.data(), data.size(), trace);
+
+		TraceDecodeContext context;
+		context.p_stack = p_stack;
+		context.p_codeLines = &codeLines;
+		context.p_sourceMap = &sourceMap;
+		GetFunctionEntries(context.functionEntries);
+
+		WriteTraceText(context, trace, outText);
+	}
+
+	void ProgramHandle::DumpTraceOfFailedRun() const
+	{
+		if (!isTracing || traceDumpPath.empty())
+			return;
+
+		// called while the error unwinds, a second error must not escape
+		try
+		{
+			std::string data;
+			GetTrace(data);
+			WriteBinaryFile(traceDumpPath, data);
+		}
+		catch (const Error& error)
+		{
+			error.Print();
+		}
+	}
+
+	void ProgramHandle::StartHeapProfiling()
+	{
+		heapProfiler.Reset(p_stack);
+		isHeapProfiling = true;
+	}
+
+	void ProgramHandle::StopHeapProfiling()
+	{
+		isHeapProfiling = false;
+	}
+
+	HeapProfile ProgramHandle::GetHeapProfile() const
+	{
+		FunctionEntries entries;
+		GetFunctionEntries(entries);
+
+		HeapProfile profile;
+		profile.allocationCount = heapProfiler.allocationCount;
+		profile.freeCount = heapProfiler.freeCount;
+		profile.allocatedBytes = heapProfiler.allocatedBytes;
+		profile.liveBytes = heapProfiler.liveBytes;
+		profile.peakBytes = heapProfiler.peakBytes;
+		profile.liveBlockCount = heapProfiler.liveBlocks.size();
+		profile.sizeHistogram = heapProfiler.sizeHistogram;
+
+		for (const auto& e : heapProfiler.offsetToSite)
+		{
+			AllocationSiteProfile& site = profile.sites.emplace_back();
+			site.codeOffset = e.first;
+			site.site = e.second;
+
+			const std::string* p_functionHash = entries.Find(p_stack + e.first);
+			site.functionHash = p_functionHash != nullptr ? *p_functionHash : "<program>";
+
+			SourceLocation location;
+
+			if (GetSourceLocation(p_stack + e.first, location))
+				site.sourceLine = sourceMap.filePaths[location.fileIndex] + ":" + std::to_string(location.line);
+		}
+
+		std::stable_sort(profile.sites.begin(), profile.sites.end(), [](const AllocationSiteProfile& lhs, const AllocationSiteProfile& rhs)
+		{
+			return lhs.site.allocatedBytes > rhs.site.allocatedBytes;
+		});
+
+		return profile;
+	}
+
+	void ProgramHandle::StartCoverage()
+	{
+		coverage.Reset(p_stack, codeEnd);
+		isCovering = true;
+	}
+
+	void ProgramHandle::StopCoverage()
+	{
+		isCovering = false;
+	}
+
+	void ProgramHandle::GetCoverage(CoverageReport& outReport)
+	{
+		Affirm(
+			codeEnd != 0,
+			"cannot get the coverage of '%s' before it is compiled",
+			codePath.c_str()
+		);
+
+		BuildLazyFunctions();
+
+		CoverageContext context;
+		context.p_stack = p_stack;
+		context.codeStart = codeStart;
+		context.codeEnd = appendedCodeLength;
+		context.p_codeLines = &codeLines;
+		context.p_sourceMap = &sourceMap;
+
+		for (const auto& e : hashToScriptFunctions)
+			context.functions.push_back({ e.second.p_functionIp, e.first });
+
+		// coverage started before the program was compiled has no counts
+		if (coverage.offsetCounts.size() < static_cast<size_t>(codeEnd))
+		{
+			CodeCoverage emptyCoverage;
+			emptyCoverage.Reset(p_stack, codeEnd);
+			BuildCoverageReport(context, emptyCoverage, outReport);
+			return;
+		}
+
+		BuildCoverageReport(context, coverage, outReport);
+	}
+
+	Int ProgramHandle::GetStackHighWater() const
+	{
+		return stackHighWater;
+	}
+
+	void ProgramHandle::ResetStackHighWater()
+	{
+		stackHighWater = 0;
+	}
+
+	void ProgramHandle::GetStackUse(std::vector<FunctionStackUse>& outUses)
+	{
+		Affirm(
+			codeEnd != 0,
+			"cannot analyze the stack of '%s' before it is compiled",
+			codePath.c_str()
+		);
+
+		// calls into stubs can not be followed
+		BuildLazyFunctions();
+
+		StackAnalysisContext context;
+		context.p_stack = p_stack;
+		context.codeStart = codeStart;
+		context.codeEnd = appendedCodeLength;
+		context.p_offsetToNativeFunctionHash = &relocations.offsetToNativeFunctionHash;
+		context.p_codeLines = &codeLines;
+		GetFunctionEntries(context.functionEntries);
+
+		for (const auto& e : hashToScriptFunctions)
+		{
+			StackFunction& function = context.functions.emplace_back();
+			function.functionHash = e.first;
+			function.p_entryIp = e.second.p_functionIp;
+			function.parametersSize = e.second.parametersSize;
+			function.localsSize = e.second.localsSize;
+			function.returnValueSize = e.second.returnValueSize;
+		}
+
+		// natives with types of unknown size are left out
+		for (const auto& e : hashToNativeFunctions)
+		{
+			auto returnIt = typeNameToSize.find(e.second.returnTypeName);
+			bool isKnown = e.second.returnTypeName == "void" || returnIt != typeNameToSize.end();
+			Int effect = returnIt != typeNameToSize.end() ? returnIt->second : 0;
+
+			for (const std::string& parameterTypeName : e.second.parameterTypeNames)
+			{
+				auto parameterIt = typeNameToSize.find(parameterTypeName);
+				isKnown = isKnown && parameterIt != typeNameToSize.end();
+				effect -= parameterIt != typeNameToSize.end() ? parameterIt->second : 0;
+			}
+
+			if (isKnown)
+				context.nativeHashToStackEffect[e.first] = effect;
+		}
+
+		AnalyzeStackUse(context, outUses);
+	}
+
+	Int ProgramHandle::EstimateStackSize()
+	{
+		std::vector<FunctionStackUse> uses;
+		GetStackUse(uses);
+
+		// the program starts running behind the code
+		const FunctionStackUse& programUse = uses.front();
+		return programUse.worstCaseSize >= 0 ? codeEnd + programUse.worstCaseSize : -1;
+	}
+
+	void ProgramHandle::GetCollapsedStacks(std::string& outText) const
+	{
+		FunctionEntries entries;
+		GetFunctionEntries(entries);
+		WriteCollapsedStacks(sampler, entries, outText);
+	}
+
+	void ProgramHandle::GetFunctionEntries(FunctionEntries& outEntries) const
+	{
+		// code belongs to the function with the closest entry before it, swapped functions keep 
+		// their old code
+		for (const auto& e : hashToScriptFunctions)
+			outEntries.Add(e.second.p_functionIp, e.first);
+
+		for (const auto& e : functionHashToOldIps)
+		{
+			for (Ptr p_oldIp : e.second)
+				outEntries.Add(p_oldIp, e.first);
+		}
+
+		outEntries.Sort();
+	}
+
+	void ProgramHandle::BuildImage(std::string& outData) const
+	{
+		// stubs of lazy functions point at this program
+		for (const LazyFunction& lazyFunction : lazyFunctions)
+		{
+			Affirm(
+				lazyFunction.isBuilt,
+				"cannot save image of '%s' before its lazy functions are built",
+				codePath.c_str()
+			);
+		}
+
+		ProgramImage image;
+		ImageHeader& header = image.header;
+		header.constStringCapacity = constStringCapacity;
+		header.constStringsSize = constStringsSize;
+		header.codeStart = codeStart;
+		header.codeEnd = codeEnd;
+		header.mainReturnValueSize = mainReturnValueSize;
+		header.mainParameterCount = static_cast<Int>(mainParameterCount);
+
+		// replace pointers in a copy of the code with stack offsets and native indices
+		std::string code(p_stack + constStringCapacity, p_stack + codeEnd);
+
+		for (Int offset : relocations.stackPtrOffsets)
+		{
+			std::intptr_t stackOffset = Get<Ptr>(p_stack + offset) - p_stack;
+			std::memcpy(&code[offset - constStringCapacity], &stackOffset, sizeof(std::intptr_t));
+			image.stackRelocations.push_back(offset);
+		}
+
+		std::map<std::string, Int> nativeHashToIndex;
+
+		for (auto& e : relocations.offsetToNativeFunctionHash)
+		{
+			if (nativeHashToIndex.count(e.second) == 0)
+			{
+				nativeHashToIndex[e.second] = static_cast<Int>(image.nativeFunctionHashes.size());
+				image.nativeFunctionHashes.push_back(e.second);
+			}
+
+			std::intptr_t nativeIndex = nativeHashToIndex.at(e.second);
+			std::memcpy(&code[e.first - constStringCapacity], &nativeIndex, sizeof(std::intptr_t));
+			image.nativeRelocations.push_back({ e.first, nativeHashToIndex.at(e.second) });
+		}
+
+		for (auto& e : hashToScriptFunctions)
+		{
+			const ScriptFunctionInfo& info = e.second;
+			image.scriptFunctionHashes.push_back(e.first);
+			image.scriptFunctions.push_back({
+				static_cast<Int>(info.p_functionIp - p_stack),
+				info.parametersSize,
+				info.localsSize,
+				info.returnValueSize
+			});
+		}
+
+		for (const CodeLine& codeLine : codeLines)
+			image.codeLines.push_back({ codeLine.offset, codeLine.line });
+
+		image.p_constStrings = p_stack;
+		image.p_code = code.data();
+		image.mainFunctionHash = mainFunctionHash;
+		image.standardIncludes = standardIncludes;
+
+		header.stackRelocationCount = static_cast<Int>(image.stackRelocations.size());
+		header.nativeRelocationCount = static_cast<Int>(image.nativeRelocations.size());
+		header.scriptFunctionCount = static_cast<Int>(image.scriptFunctions.size());
+		header.standardIncludeCount = static_cast<Int>(image.standardIncludes.size());
+		header.nativeFunctionCount = static_cast<Int>(image.nativeFunctionHashes.size());
+		header.codeLineCount = static_cast<Int>(image.codeLines.size());
+
+		SerializeProgramImage(image, outData);
+	}
+
+
+	void ProgramHandle::SaveToImage(const std::string& imagePath) const
+	{
+		Affirm(
+			codeEnd != 0,
+			"cannot save image of '%s' before it is compiled",
+			codePath.c_str()
+		);
+
+		std::string data;
+		BuildImage(data);
+		WriteBinaryFile(imagePath, data);
+	}
+
+	void ProgramHandle::LoadFromImage(const std::string& imagePath)
+	{
+		MappedFile file;
+		MapFile(imagePath, file);
+
+		try
+		{
+			ProgramImage image;
+			DeserializeProgramImage(file.p_data, file.size, image);
+
+			for (const std::string& include : image.standardIncludes)
+			{
+				Affirm(
+					standardTookitAdders.count(include) != 0,
+					"include '%s' is not part of the standard",
+					include.c_str()
+				);
+
+				standardTookitAdders.at(include)(*this);
+			}
+
+			ApplyImage(image, imagePath);
+		}
+		catch (...)
+		{
+			UnmapFile(file);
+			throw;
+		}
+
+		UnmapFile(file);
+	}
+
+	const ScriptFunctionInfo& ProgramHandle::GetScriptFunctionInfo(
+		const std::string& returnTypeName,
+		const std::string& functionName,
+		const std::vector<std::string>& parameterTypeNames
+	) const
+	{
+		std::string hash = GetFunctionHash(returnTypeName, functionName, parameterTypeNames);
+
+		Affirm(
+			hashToScriptFunctions.count(hash) != 0,
+			"failed to get function, no function with signature '%s' found",
+			hash.c_str()
+		);
+
+		return hashToScriptFunctions.at(hash);
+	}
+
+	const std::string& ProgramHandle::GetCodePath() const
+	{
+		return codePath;
+	}
+
+	const SourceMap& ProgramHandle::GetSourceMap() const
+	{
+		return sourceMap;
+	}
+
+	bool ProgramHandle::GetSourceLocation(Ptr p_ip, SourceLocation& outLocation) const
+	{
+		return sourceMap.TryGetLocationOfLine(FindCodeLine(codeLines, static_cast<Int>(p_ip - p_stack)), outLocation);
+	}
+
+	void ProgramHandle::Disassemble(std::string& outText) const
+	{
+		Affirm(
+			codeEnd != 0,
+			"cannot disassemble '%s' before it is compiled",
+			codePath.c_str()
+		);
+
+		DisassemblyContext context;
+		context.p_stack = p_stack;
+		context.constStringsSize = constStringsSize;
+		context.codeEnd = codeEnd;
+		context.p_offsetToNativeFunctionHash = &relocations.offsetToNativeFunctionHash;
+		context.p_codeLines = &codeLines;
+		context.p_sourceMap = &sourceMap;
+		GetFunctionEntries(context.functionEntries);
+
+		for (const auto& e : functionHashToOldIps)
+			context.replacedEntries.insert(e.second.begin(), e.second.end());
+
+		context.fileTexts.resize(sourceMap.filePaths.size());
+
+		for (size_t i = 0; i < sourceMap.filePaths.size(); i++)
+			ReadTextFile(sourceMap.filePaths[i], context.fileTexts[i]);
+
+		// the code appended later ends before the space kept for it
+		WriteDisassembly(context, codeStart, appendedCodeLength, outText);
+	}
+
+	void ProgramHandle::SetCompileThreadCount(size_t threadCount)
+	{
+		compileThreadCount = threadCount;
+	}
+
+	const CompileStats& ProgramHandle::GetCompileStats() const
+	{
+		return compileStats;
+	}
+
+	void ProgramHandle::SetCompileStatsSink(const CompileStatsSink& sink)
+	{
+		compileStatsSink = sink;
+	}
+
+	void ProgramHandle::FinishCompileStats(std::chrono::steady_clock::time_point start)
+	{
+		compileStats.totalSeconds = SecondsSince(start);
+		compileStats.functionCount = hashToScriptFunctions.size();
+		compileStats.codeSize = appendedCodeLength - codeStart;
+		compileStats.constStringsSize = constStringsSize;
+
+		if (compileStatsSink)
+			compileStatsSink(codePath, compileStats);
 	}
 }
\ No newline at end of file
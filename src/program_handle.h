@@ -1,14 +1,27 @@
 #pragma once
 #include "virtual_machine.h"
 #include "parser.h"
+#include "preprocessor.h"
+#include "program_image.h"
+#include "compile_cache.h"
+#include "incremental_cache.h"
+#include "profiler.h"
+#include "stack_analysis.h"
+#include "compile_stats.h"
+#include "execution_trace.h"
+#include "heap_profiler.h"
+#include "code_coverage.h"
 #include <string>
 #include <vector>
 #include <map>
+#include <array>
+#include <utility>
+#include <memory>
 
 namespace Tolo
 {
 	template<typename T>
-	bool WriteValue(Ptr p_data, Int& inoutOffset, size_t inoutCount, const T& value)
+	bool WriteValue(Ptr p_data, Int& inoutOffset, size_t& inoutCount, const T& value)
 	{
 		if (inoutOffset < sizeof(T))
 			return false;
@@ -21,6 +34,189 @@ namespace Tolo
 		return true;
 	}
 
+	template<typename T>
+	struct TypeName;
+
+	template<> struct TypeName<void> { static constexpr const char* value = "void"; };
+	template<> struct TypeName<Char> { static constexpr const char* value = "char"; };
+	template<> struct TypeName<Int> { static constexpr const char* value = "int"; };
+	template<> struct TypeName<Float> { static constexpr const char* value = "float"; };
+	template<> struct TypeName<Ptr> { static constexpr const char* value = "ptr"; };
+	template<> struct TypeName<const Char*> { static constexpr const char* value = "ptr"; };
+
+	template<typename T>
+	constexpr Int ValueSize = static_cast<Int>(sizeof(T));
+
+	template<>
+	constexpr Int ValueSize<void> = 0;
+
+	struct ScriptFunctionInfo
+	{
+		Ptr p_functionIp;
+		Int parametersSize;
+		Int localsSize;
+		Int returnValueSize;
+
+		ScriptFunctionInfo();
+	};
+
+	class ProgramHandle;
+
+	// marks a program as running while alive, a hot reload waiting for the program to return is
+	// swapped in when the outermost scope ends
+	class ExecutionScope
+	{
+	private:
+		ProgramHandle* p_program;
+		int uncaughtExceptionCount; // of the host when the scope started
+		VMInstruments instruments; // of the program when the scope started
+
+	public:
+		ExecutionScope(ProgramHandle* _p_program);
+
+		ExecutionScope(const ExecutionScope&) = delete;
+
+		ExecutionScope& operator=(const ExecutionScope&) = delete;
+
+		~ExecutionScope();
+
+		// the tools to run with, the profiler is only attached if PROFILE_VM is defined
+		const VMInstruments& GetInstruments() const;
+
+		// keeps the highest stack pointer a run returned
+		void RecordStackHighWater(Ptr p_stackHighWater) const;
+	};
+
+	template<typename SIGNATURE>
+	class ScriptFunction;
+
+	// callable handle to a compiled script function, valid until the program is compiled again,
+	// calls the latest version of the function after hot reloads
+	template<typename RETURN_TYPE, typename... ARGUMENTS>
+	class ScriptFunction<RETURN_TYPE(ARGUMENTS...)>
+	{
+	private:
+		ProgramHandle* p_program;
+		Ptr p_stack;
+		Int codeEnd;
+		const ScriptFunctionInfo* p_info;
+
+	public:
+		static constexpr Int returnValueSize = ValueSize<RETURN_TYPE>;
+		static constexpr Int parametersSize = (0 + ... + ValueSize<ARGUMENTS>);
+
+		static std::string ReturnTypeName()
+		{
+			return TypeName<RETURN_TYPE>::value;
+		}
+
+		static std::vector<std::string> ParameterTypeNames()
+		{
+			return { TypeName<ARGUMENTS>::value... };
+		}
+
+		ScriptFunction(ProgramHandle* _p_program, Ptr _p_stack, Int _codeEnd, const ScriptFunctionInfo* _p_info) :
+			p_program(_p_program),
+			p_stack(_p_stack),
+			codeEnd(_codeEnd),
+			p_info(_p_info)
+		{}
+
+		RETURN_TYPE operator()(const ARGUMENTS&... arguments) const
+		{
+			// arguments are written below the end of the code, first argument on top
+			Int argByteOffset = parametersSize;
+			size_t argCount = 0;
+			(WriteValue(p_stack + codeEnd, argByteOffset, argCount, arguments), ...);
+
+			{
+				ExecutionScope scope(p_program);
+				scope.RecordStackHighWater(RunFunction(p_stack, codeEnd, p_info->p_functionIp, p_info->parametersSize, p_info->localsSize, scope.GetInstruments()));
+			}
+
+			if constexpr (!std::is_same<RETURN_TYPE, void>::value)
+				return *reinterpret_cast<RETURN_TYPE*>(p_stack + codeEnd);
+		}
+
+		// re-entrant call from inside a native function, runs on top of the native's stack
+		RETURN_TYPE Call(VirtualMachine& vm, const ARGUMENTS&... arguments) const
+		{
+			Ptr p_args = vm.p_stackPtr;
+			vm.p_stackPtr += parametersSize;
+
+			Int argByteOffset = parametersSize;
+			size_t argCount = 0;
+			(WriteValue(p_args, argByteOffset, argCount, arguments), ...);
+
+			{
+				ExecutionScope scope(p_program);
+				CallFunction(vm, p_info->p_functionIp, p_info->parametersSize, p_info->localsSize);
+			}
+
+			if constexpr (!std::is_same<RETURN_TYPE, void>::value)
+				return Pop<RETURN_TYPE>(vm);
+		}
+	};
+
+	template<auto FUNCTION>
+	struct NativeFunction;
+
+	// marshalling thunk for a C++ function, the arguments are read directly from the argument
+	// window on the stack and the return value is written in place of them
+	template<typename RETURN_TYPE, typename... ARGUMENTS, RETURN_TYPE(*FUNCTION)(ARGUMENTS...)>
+	struct NativeFunction<FUNCTION>
+	{
+		static constexpr Int parametersSize = (0 + ... + ValueSize<ARGUMENTS>);
+
+		// offset of each argument from the bottom of the window, the first argument is on top
+		static constexpr std::array<Int, sizeof...(ARGUMENTS)> argumentOffsets = []()
+		{
+			std::array<Int, sizeof...(ARGUMENTS)> offsets{};
+			const Int sizes[] = { ValueSize<ARGUMENTS>..., 0 };
+			Int offset = parametersSize;
+
+			for (size_t i = 0; i < sizeof...(ARGUMENTS); i++)
+			{
+				offset -= sizes[i];
+				offsets[i] = offset;
+			}
+
+			return offsets;
+		}();
+
+		static std::string ReturnTypeName()
+		{
+			return TypeName<RETURN_TYPE>::value;
+		}
+
+		static std::vector<std::string> ParameterTypeNames()
+		{
+			return { TypeName<ARGUMENTS>::value... };
+		}
+
+		template<size_t... INDICES>
+		static void Invoke(VirtualMachine& vm, std::index_sequence<INDICES...>)
+		{
+			Ptr p_args = vm.p_stackPtr - parametersSize;
+
+			if constexpr (std::is_same<RETURN_TYPE, void>::value)
+			{
+				FUNCTION(Get<ARGUMENTS>(p_args + argumentOffsets[INDICES])...);
+				vm.p_stackPtr = p_args;
+			}
+			else
+			{
+				Set<RETURN_TYPE>(p_args, FUNCTION(Get<ARGUMENTS>(p_args + argumentOffsets[INDICES])...));
+				vm.p_stackPtr = p_args + sizeof(RETURN_TYPE);
+			}
+		}
+
+		static void Thunk(VirtualMachine& vm)
+		{
+			Invoke(vm, std::index_sequence_for<ARGUMENTS...>());
+		}
+	};
+
 	struct FunctionHandle
 	{
 		native_func_t p_function;
@@ -45,8 +241,30 @@ namespace Tolo
 		StructHandle& operator=(const StructHandle& rhs);
 	};
 
+	// a function body built by a hot reload, waiting to be swapped in
+	struct FunctionSwap
+	{
+		std::string functionHash;
+		const CodeBuilder* p_code;
+		ScriptFunctionInfo info;
+
+		FunctionSwap(const std::string& _functionHash, const CodeBuilder* _p_code, const ScriptFunctionInfo& _info);
+	};
+
+	// a parsed function whose code is built on its first call
+	struct LazyFunction
+	{
+		std::string functionHash;
+		EDefineFunction* p_defFuncExp;
+		bool isBuilt;
+
+		LazyFunction(const std::string& _functionHash, EDefineFunction* _p_defFuncExp);
+	};
+
 	class ProgramHandle
 	{
+		friend class ExecutionScope;
+
 	private:
 		std::string codePath;
 		Ptr p_stack;
@@ -61,8 +279,42 @@ namespace Tolo
 		std::map<std::string, NativeFunctionInfo> hashToNativeFunctions;
 		std::set<std::string> enumNamespaces;
 		std::map<std::string, Int> nameToEnumValue;
-		std::map<std::string, StructInfo> typeNameToStructInfo;
+		std::vector<StructHandle> structs; // in the order they were added
 		std::map<std::string, void(*)(ProgramHandle&)> standardTookitAdders;
+		std::map<std::string, ScriptFunctionInfo> hashToScriptFunctions;
+		std::vector<std::string> standardIncludes;
+		SourceMap sourceMap;
+		CodeRelocations relocations;
+		std::vector<CodeLine> codeLines;
+		Int constStringsSize;
+		size_t compileThreadCount;
+		Int mainCallEnd;
+		Int hotReloadCapacity;
+		Int lazyCompileCapacity;
+		Int appendedCodeLength; // end of the code appended by hot reloads and lazily built functions
+		std::unique_ptr<IncrementalCache> p_hotReloadCache;
+		std::map<std::string, Ptr> labelNameToIp;
+		std::map<std::string, std::vector<Ptr>> functionHashToOldIps;
+		std::map<std::string, std::string> structNameToLayout;
+		std::vector<FunctionSwap> pendingSwaps;
+		Int executionDepth;
+		std::unique_ptr<Arena> p_lazyArena; // keeps the expressions of lazy functions
+		std::vector<LazyFunction> lazyFunctions;
+		VMProfiler profiler;
+		VMSampler sampler;
+		bool isSampling;
+		ExecutionCounters counters;
+		bool isCounting;
+		VMTracer tracer;
+		bool isTracing;
+		std::string traceDumpPath;
+		HeapProfiler heapProfiler;
+		bool isHeapProfiling;
+		CodeCoverage coverage;
+		bool isCovering;
+		Int stackHighWater;
+		CompileStats compileStats;
+		CompileStatsSink compileStatsSink;
 
 		ProgramHandle() = delete;
 		ProgramHandle(const ProgramHandle&) = delete;
@@ -72,6 +324,45 @@ namespace Tolo
 
 		void AddNativeOperator(const FunctionHandle& function);
 
+		void PreprocessCode(std::string& outCode);
+
+		void CompileCode(const std::string& code);
+
+		// writes the trace to the dump path after a run failed with an error
+		void DumpTraceOfFailedRun() const;
+
+		void LexCached(IncrementalCache& cache, const std::string& code, std::vector<LexNode*>& outLexNodes);
+
+		void InitParser(Parser& parser);
+
+		// parses and builds the function bodies that are not in the cache
+		void BuildFunctions(Parser& parser, SymbolTable& symbols, IncrementalCache* p_cache, std::vector<CodeBuilder>& outFunctionCode, std::vector<const PendingFunctionBody*>& outBuiltBodies);
+
+		void BuildCode(const std::vector<LexNode*>& lexNodes, SymbolTable& symbols, IncrementalCache* p_cache);
+
+		// appends the new code of functions and points their old entries at it
+		void SwapFunctions(const std::vector<FunctionSwap>& swaps);
+
+		void ApplyHotReload();
+
+		// builds a lazy function and returns its new entry
+		Ptr BuildLazyFunction(Int lazyIndex);
+
+		// called by the stub of a lazy function, the stub jumps to the returned entry
+		static void OnLazyFunctionCall(VirtualMachine& vm);
+
+		void BuildImage(std::string& outData) const;
+
+		void ApplyImage(const ProgramImage& image, const std::string& imageName);
+
+		// fills in the totals of a compile that started at start and logs its stats
+		void FinishCompileStats(std::chrono::steady_clock::time_point start);
+
+		// entries of all script functions, including the old entries of swapped functions
+		void GetFunctionEntries(FunctionEntries& outEntries) const;
+
+		std::string GetCompileCacheKey(const std::string& code) const;
+
 	public:
 		ProgramHandle(
 			const std::string& _codePath, 
@@ -91,6 +382,18 @@ namespace Tolo
 			native_func_t functionPtr
 		);
 
+		// binds a C++ function, deriving the signature from its parameter and return types
+		template<auto FUNCTION>
+		void AddFunction(const std::string& functionName)
+		{
+			AddFunction(
+				NativeFunction<FUNCTION>::ReturnTypeName(),
+				functionName,
+				NativeFunction<FUNCTION>::ParameterTypeNames(),
+				NativeFunction<FUNCTION>::Thunk
+			);
+		}
+
 		void AddStruct(
 			const std::string& structName, 
 			const std::vector<std::pair<std::string, std::string>>& members
@@ -101,8 +404,109 @@ namespace Tolo
 			const std::vector<std::string>& enumNames
 		);
 
+		// compiling with a capacity reserves that much code space after the code for hot reloads
+		void SetHotReloadCapacity(Int capacity);
+
+		// compiling with a capacity only parses function bodies and leaves a stub in place of each 
+		// function, the stub builds the function into this much code space on its first call
+		void SetLazyCompileCapacity(Int capacity);
+
 		void Compile();
 
+		// reuses the compiled code of an earlier program with the same source, natives, structs, 
+		// enums and main function when the cache has it
+		void Compile(CompileCache& cache);
+
+		// only lexes the files and builds the functions that changed since the last compile with 
+		// this cache
+		void Compile(IncrementalCache& cache);
+
+		// writes the compiled program as a relocatable image
+		void SaveToImage(const std::string& imagePath) const;
+
+		// loads a program image saved with the same main function, const string capacity and natives,
+		// replaces 'Compile'
+		void LoadFromImage(const std::string& imagePath);
+
+		// recompiles the code and appends the functions that changed, their old entry points jump to
+		// the new code, heap data survives, fails if a struct layout changed, called while the 
+		// program runs the swap waits until it returns
+		void HotReload();
+
+		bool IsHotReloadPending() const;
+
+		// builds all lazy functions that were not called yet, needed before saving an image
+		void BuildLazyFunctions();
+
+		// what the program executed since it was compiled or the profile was reset, needs 
+		// PROFILE_VM to be defined
+		ProgramProfile GetProfile() const;
+
+		void ResetProfile();
+
+		// polls the script call stack every sampleInterval instructions, keeps the last 
+		// sampleCapacity samples up to maxDepth frames deep
+		void StartSampling(Int sampleInterval, size_t sampleCapacity = 64 * 1024, size_t maxDepth = 64);
+
+		void StopSampling();
+
+		// the samples as collapsed stacks with function signatures, to draw a flamegraph from
+		void GetCollapsedStacks(std::string& outText) const;
+
+		// clears the counters and counts everything the VM executes until counting stops, 
+		// slower than an uncounted run but without PROFILE_VM
+		void StartCounting();
+
+		void StopCounting();
+
+		const ExecutionCounters& GetExecutionCounters() const;
+
+		// records every instruction the VM executes until tracing stops, keeps the last 
+		// recordCapacity of them
+		void StartTracing(size_t recordCapacity = 64 * 1024);
+
+		void StopTracing();
+
+		// the held records as a binary dump, oldest first
+		void GetTrace(std::string& outData) const;
+
+		// a run that fails while tracing writes the trace to path, empty turns this off
+		void SetTraceDumpPath(const std::string& path);
+
+		// decodes a trace this program wrote, in this or another process, one line per record
+		void DecodeTrace(const std::string& data, std::string& outText) const;
+
+		// clears the heap profile and accounts every 'malloc' and 'free' of the script until heap
+		// profiling stops
+		void StartHeapProfiling();
+
+		void StopHeapProfiling();
+
+		// the blocks that are still live are the leaks, see WriteLeakReport
+		HeapProfile GetHeapProfile() const;
+
+		// clears the coverage and counts the executions of every instruction and the directions
+		// of every conditional jump until coverage stops
+		void StartCoverage();
+
+		void StopCoverage();
+
+		// the coverage per source line and jump, builds lazy functions first so that code that
+		// was never called is reported too
+		void GetCoverage(CoverageReport& outReport);
+
+		// most bytes of the stack in use since the program was compiled or this was reset, the
+		// code included, sampled at calls so the temporaries of the innermost frame are left out
+		Int GetStackHighWater() const;
+
+		void ResetStackHighWater();
+
+		// stack use of every function estimated from the code, builds lazy functions first
+		void GetStackUse(std::vector<FunctionStackUse>& outUses);
+
+		// the stack size running 'main' needs at most, -1 if the program can recurse
+		Int EstimateStackSize();
+
 		template<typename RETURN_TYPE, typename... ARGUMENTS>
 		std::enable_if_t<!std::is_same<RETURN_TYPE, void>::value, RETURN_TYPE>
 		Execute(const ARGUMENTS&... arguments)
@@ -123,7 +527,10 @@ namespace Tolo
 				"argument list provided to 'main'-function does not match the size of parameter list"
 			);
 
-			RunProgram(p_stack, codeStart, codeEnd);
+			{
+				ExecutionScope scope(this);
+				scope.RecordStackHighWater(RunProgram(p_stack, codeStart, codeEnd, scope.GetInstruments()));
+			}
 
 			return *reinterpret_cast<RETURN_TYPE*>(p_stack + codeEnd);
 		}
@@ -148,9 +555,66 @@ namespace Tolo
 				"argument list provided to 'main'-function does not match the size of parameter list"
 			);
 
-			RunProgram(p_stack, codeStart, codeEnd);
+			ExecutionScope scope(this);
+			scope.RecordStackHighWater(RunProgram(p_stack, codeStart, codeEnd, scope.GetInstruments()));
+		}
+
+		const ScriptFunctionInfo& GetScriptFunctionInfo(
+			const std::string& returnTypeName,
+			const std::string& functionName,
+			const std::vector<std::string>& parameterTypeNames
+		) const;
+
+		// resolves a function by explicit type names, needed for struct parameters or return values
+		template<typename SIGNATURE>
+		ScriptFunction<SIGNATURE> GetFunction(
+			const std::string& returnTypeName,
+			const std::string& functionName,
+			const std::vector<std::string>& parameterTypeNames
+		) const
+		{
+			const ScriptFunctionInfo& info = GetScriptFunctionInfo(returnTypeName, functionName, parameterTypeNames);
+
+			Affirm(
+				info.returnValueSize == ScriptFunction<SIGNATURE>::returnValueSize &&
+				info.parametersSize == ScriptFunction<SIGNATURE>::parametersSize,
+				"requested signature does not match the size of function '%s'",
+				GetFunctionHash(returnTypeName, functionName, parameterTypeNames).c_str()
+			);
+
+			return ScriptFunction<SIGNATURE>(const_cast<ProgramHandle*>(this), p_stack, codeEnd, &info);
+		}
+
+		template<typename SIGNATURE>
+		ScriptFunction<SIGNATURE> GetFunction(const std::string& functionName) const
+		{
+			return GetFunction<SIGNATURE>(
+				ScriptFunction<SIGNATURE>::ReturnTypeName(),
+				functionName,
+				ScriptFunction<SIGNATURE>::ParameterTypeNames()
+			);
 		}
 
 		const std::string& GetCodePath() const;
+
+		// maps lines of the preprocessed code back to the included files, filled by Compile
+		const SourceMap& GetSourceMap() const;
+
+		// the file and line the code at this ip was built from, false for code built from no line
+		bool GetSourceLocation(Ptr p_ip, SourceLocation& outLocation) const;
+
+		// writes the compiled code as instructions, with the functions and source lines they 
+		// were built from
+		void Disassemble(std::string& outText) const;
+
+		// threads used to parse and build function bodies, 0 uses one per core
+		void SetCompileThreadCount(size_t threadCount);
+
+		// where the last compile or hot reload spent its time and memory
+		const CompileStats& GetCompileStats() const;
+
+		// called with the compile stats after every compile and hot reload, an empty sink turns
+		// this off, WriteCompileStatsText formats them for a log
+		void SetCompileStatsSink(const CompileStatsSink& sink);
 	};
 }
\ No newline at end of file
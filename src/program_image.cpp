@@ -0,0 +1,170 @@
+#include "program_image.h"
+#include <cstring>
+
+#define IMAGE_VERSION 3
+
+namespace Tolo
+{
+	ProgramImage::ProgramImage() :
+		p_constStrings(nullptr),
+		p_code(nullptr)
+	{
+		// the header is written as raw bytes, padding included
+		std::memset(&header, 0, sizeof(ImageHeader));
+		std::memcpy(header.magic, "TOLO", 4);
+		header.version = IMAGE_VERSION;
+		header.pointerSize = static_cast<Int>(sizeof(Ptr));
+	}
+
+	template<typename T>
+	static void WriteArray(std::string& outData, const T* p_values, size_t count)
+	{
+		outData.append(reinterpret_cast<const char*>(p_values), sizeof(T) * count);
+	}
+
+	static void WriteString(std::string& outData, const std::string& str)
+	{
+		Int length = static_cast<Int>(str.size());
+		WriteArray(outData, &length, 1);
+		outData.append(str);
+	}
+
+	struct ImageReader
+	{
+		const char* p_data;
+		size_t size;
+		size_t offset;
+
+		void Read(void* p_dst, size_t byteCount)
+		{
+			Affirm(offset + byteCount <= size, "program image is truncated");
+
+			std::memcpy(p_dst, p_data + offset, byteCount);
+			offset += byteCount;
+		}
+
+		const Char* Skip(size_t byteCount)
+		{
+			Affirm(offset + byteCount <= size, "program image is truncated");
+
+			const Char* p_start = p_data + offset;
+			offset += byteCount;
+			return p_start;
+		}
+
+		template<typename T>
+		void ReadArray(std::vector<T>& outValues, Int count)
+		{
+			Affirm(count >= 0, "program image is corrupt");
+
+			outValues.resize(static_cast<size_t>(count));
+			Read(outValues.data(), sizeof(T) * outValues.size());
+		}
+
+		void ReadString(std::string& outStr)
+		{
+			Int length = 0;
+			Read(&length, sizeof(Int));
+
+			Affirm(length >= 0, "program image is corrupt");
+
+			const Char* p_str = Skip(static_cast<size_t>(length));
+			outStr.assign(p_str, p_str + length);
+		}
+	};
+
+	void SerializeProgramImage(const ProgramImage& image, std::string& outData)
+	{
+		const ImageHeader& header = image.header;
+
+		outData.reserve(
+			sizeof(ImageHeader) + 
+			header.constStringsSize + 
+			(header.codeEnd - header.constStringCapacity) + 
+			sizeof(Int) * image.stackRelocations.size() + 
+			sizeof(ImageNativeRelocation) * image.nativeRelocations.size() + 
+			sizeof(ImageScriptFunction) * image.scriptFunctions.size() + 
+			sizeof(ImageCodeLine) * image.codeLines.size()
+		);
+
+		WriteArray(outData, &header, 1);
+		WriteArray(outData, image.p_constStrings, static_cast<size_t>(header.constStringsSize));
+		WriteArray(outData, image.p_code, static_cast<size_t>(header.codeEnd - header.constStringCapacity));
+		WriteArray(outData, image.stackRelocations.data(), image.stackRelocations.size());
+		WriteArray(outData, image.nativeRelocations.data(), image.nativeRelocations.size());
+		WriteArray(outData, image.scriptFunctions.data(), image.scriptFunctions.size());
+		WriteArray(outData, image.codeLines.data(), image.codeLines.size());
+
+		WriteString(outData, image.mainFunctionHash);
+
+		for (const std::string& include : image.standardIncludes)
+			WriteString(outData, include);
+
+		for (const std::string& hash : image.nativeFunctionHashes)
+			WriteString(outData, hash);
+
+		for (const std::string& hash : image.scriptFunctionHashes)
+			WriteString(outData, hash);
+	}
+
+	void DeserializeProgramImage(const char* p_data, size_t size, ProgramImage& outImage)
+	{
+		ImageReader reader{ p_data, size, 0 };
+		ImageHeader& header = outImage.header;
+
+		reader.Read(&header, sizeof(ImageHeader));
+
+		Affirm(
+			std::memcmp(header.magic, "TOLO", 4) == 0,
+			"data is not a program image"
+		);
+
+		Affirm(
+			header.version == IMAGE_VERSION,
+			"program image version %i is not supported, expected version %i",
+			header.version, IMAGE_VERSION
+		);
+
+		Affirm(
+			header.pointerSize == static_cast<Int>(sizeof(Ptr)),
+			"program image was built for %i-byte pointers",
+			header.pointerSize
+		);
+
+		Affirm(
+			header.constStringsSize >= 0 &&
+			header.constStringsSize <= header.constStringCapacity &&
+			header.codeStart >= header.constStringCapacity &&
+			header.codeEnd >= header.codeStart,
+			"program image is corrupt"
+		);
+
+		outImage.p_constStrings = reader.Skip(static_cast<size_t>(header.constStringsSize));
+		outImage.p_code = reader.Skip(static_cast<size_t>(header.codeEnd - header.constStringCapacity));
+
+		reader.ReadArray(outImage.stackRelocations, header.stackRelocationCount);
+		reader.ReadArray(outImage.nativeRelocations, header.nativeRelocationCount);
+		reader.ReadArray(outImage.scriptFunctions, header.scriptFunctionCount);
+		reader.ReadArray(outImage.codeLines, header.codeLineCount);
+
+		reader.ReadString(outImage.mainFunctionHash);
+
+		Affirm(
+			header.standardIncludeCount >= 0 &&
+			header.nativeFunctionCount >= 0,
+			"program image is corrupt"
+		);
+
+		outImage.standardIncludes.resize(static_cast<size_t>(header.standardIncludeCount));
+		for (std::string& include : outImage.standardIncludes)
+			reader.ReadString(include);
+
+		outImage.nativeFunctionHashes.resize(static_cast<size_t>(header.nativeFunctionCount));
+		for (std::string& hash : outImage.nativeFunctionHashes)
+			reader.ReadString(hash);
+
+		outImage.scriptFunctionHashes.resize(outImage.scriptFunctions.size());
+		for (std::string& hash : outImage.scriptFunctionHashes)
+			reader.ReadString(hash);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+#include "common.h"
+#include <string>
+#include <vector>
+
+namespace Tolo
+{
+	/*
+	relocatable image of a compiled program, all sections follow each other in this order:
+
+	ImageHeader
+	const strings			[constStringsSize bytes], copied to the start of the stack
+	code					[codeEnd - constStringCapacity bytes], copied to the end of the const strings
+	stack relocations		Int[stackRelocationCount], pointer slots holding an offset from the stack start
+	native relocations		ImageNativeRelocation[nativeRelocationCount], pointer slots holding a native index
+	script functions		ImageScriptFunction[scriptFunctionCount]
+	code lines				ImageCodeLine[codeLineCount], lines of the preprocessed code
+	strings					main function hash, standard includes, native function hashes and
+							script function hashes, each stored as an Int length followed by the chars
+	*/
+
+	struct ImageHeader
+	{
+		Char magic[4];
+		Int version;
+		Int pointerSize;
+		Int constStringCapacity;
+		Int constStringsSize;
+		Int codeStart;
+		Int codeEnd;
+		Int mainReturnValueSize;
+		Int mainParameterCount;
+		Int stackRelocationCount;
+		Int nativeRelocationCount;
+		Int scriptFunctionCount;
+		Int standardIncludeCount;
+		Int nativeFunctionCount;
+		Int codeLineCount;
+	};
+
+	struct ImageNativeRelocation
+	{
+		Int codeOffset;
+		Int nativeIndex;
+	};
+
+	struct ImageScriptFunction
+	{
+		Int ipOffset;
+		Int parametersSize;
+		Int localsSize;
+		Int returnValueSize;
+	};
+
+	struct ImageCodeLine
+	{
+		Int offset;
+		Int line;
+	};
+
+	struct ProgramImage
+	{
+		ImageHeader header;
+		const Char* p_constStrings;
+		const Char* p_code;
+		std::vector<Int> stackRelocations;
+		std::vector<ImageNativeRelocation> nativeRelocations;
+		std::vector<ImageScriptFunction> scriptFunctions;
+		std::vector<ImageCodeLine> codeLines;
+		std::string mainFunctionHash;
+		std::vector<std::string> standardIncludes;
+		std::vector<std::string> nativeFunctionHashes;
+		std::vector<std::string> scriptFunctionHashes;
+
+		ProgramImage();
+	};
+
+	// the code must already have its pointer slots replaced by stack offsets and native indices
+	void SerializeProgramImage(const ProgramImage& image, std::string& outData);
+
+	// the const string and code sections keep pointing into the input data
+	void DeserializeProgramImage(const char* p_data, size_t size, ProgramImage& outImage);
+}
\ No newline at end of file
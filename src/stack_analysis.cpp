@@ -0,0 +1,448 @@
+#include "stack_analysis.h"
+#include "virtual_machine.h"
+#include <algorithm>
+
+namespace Tolo
+{
+	StackFunction::StackFunction() :
+		p_entryIp(nullptr),
+		parametersSize(0),
+		localsSize(0),
+		returnValueSize(0)
+	{}
+
+
+	StackAnalysisContext::StackAnalysisContext() :
+		p_stack(nullptr),
+		codeStart(0),
+		codeEnd(0),
+		p_offsetToNativeFunctionHash(nullptr),
+		p_codeLines(nullptr)
+	{}
+
+
+	FunctionStackUse::FunctionStackUse() :
+		frameSize(0),
+		operandDepth(0),
+		worstCaseSize(0)
+	{}
+
+
+	static const Int frameHeaderSize = static_cast<Int>(sizeof(Int) + sizeof(Ptr) + sizeof(Ptr));
+	static const size_t noFunction = static_cast<size_t>(-1);
+	static const Int unknownDepth = -2;
+
+	// a call found in the code of a function
+	struct StackCall
+	{
+		Int depth; // bytes on top of the caller's frame once the callee's frame is built
+		size_t calleeIndex; // noFunction for calls through a pointer
+		Int parametersSize;
+	};
+
+	// the code of a function or of the program
+	struct ScannedCode
+	{
+		Int startOffset;
+		Int endOffset;
+		Int parametersSize;
+		Int operandDepth;
+		std::vector<StackCall> calls;
+	};
+
+	// bytes pushed minus bytes popped by an instruction that is neither a call nor moves bytes
+	static Int GetStackEffect(OpCode opCode)
+	{
+		const Int charSize = sizeof(Char);
+		const Int intSize = sizeof(Int);
+		const Int floatSize = sizeof(Float);
+		const Int ptrSize = sizeof(Ptr);
+
+		switch (opCode)
+		{
+		case OpCode::Load_FP: return ptrSize;
+		case OpCode::Load_Const_Char: return charSize;
+		case OpCode::Load_Const_Int: return intSize;
+		case OpCode::Load_Const_Float: return floatSize;
+		case OpCode::Load_Const_Ptr: return ptrSize;
+		case OpCode::Write_IP: return -ptrSize;
+		case OpCode::Write_IP_If: return -charSize - ptrSize;
+
+		case OpCode::Char_Equal:
+		case OpCode::Char_Less:
+		case OpCode::Char_Greater:
+		case OpCode::Char_LessOrEqual:
+		case OpCode::Char_GreaterOrEqual:
+		case OpCode::Char_NotEqual:
+		case OpCode::Char_Add:
+		case OpCode::Char_Sub:
+		case OpCode::Char_Mul:
+		case OpCode::Char_Div:
+		case OpCode::And:
+		case OpCode::Or:
+		case OpCode::Bit_8_And:
+		case OpCode::Bit_8_Or:
+		case OpCode::Bit_8_Xor:
+		case OpCode::Bit_8_LeftShift:
+		case OpCode::Bit_8_RightShift:
+			return -charSize;
+
+		case OpCode::Int_Equal:
+		case OpCode::Int_Less:
+		case OpCode::Int_Greater:
+		case OpCode::Int_LessOrEqual:
+		case OpCode::Int_GreaterOrEqual:
+		case OpCode::Int_NotEqual:
+			return charSize - intSize - intSize;
+
+		case OpCode::Int_Add:
+		case OpCode::Int_Sub:
+		case OpCode::Int_Mul:
+		case OpCode::Int_Div:
+		case OpCode::Bit_32_And:
+		case OpCode::Bit_32_Or:
+		case OpCode::Bit_32_Xor:
+		case OpCode::Bit_32_LeftShift:
+		case OpCode::Bit_32_RightShift:
+			return -intSize;
+
+		case OpCode::Float_Equal:
+		case OpCode::Float_Less:
+		case OpCode::Float_Greater:
+		case OpCode::Float_LessOrEqual:
+		case OpCode::Float_GreaterOrEqual:
+		case OpCode::Float_NotEqual:
+			return charSize - floatSize - floatSize;
+
+		case OpCode::Float_Add:
+		case OpCode::Float_Sub:
+		case OpCode::Float_Mul:
+		case OpCode::Float_Div:
+			return -floatSize;
+
+		case OpCode::Ptr_Add:
+		case OpCode::Ptr_Sub:
+		case OpCode::Ptr_Offset:
+			return -intSize;
+
+		case OpCode::Ptr_Less:
+		case OpCode::Ptr_Greater:
+		case OpCode::Ptr_Equal:
+		case OpCode::Ptr_LessOrEqual:
+		case OpCode::Ptr_GreaterOrEqual:
+		case OpCode::Ptr_NotEqual:
+			return charSize - ptrSize - ptrSize;
+
+		default:
+			// unary operators keep the size of their operand
+			return 0;
+		}
+	}
+
+	// visits every instruction of the code between the offsets, data is visited as OpCode::INVALID
+	template<typename VISIT>
+	static void ForEachInstruction(const StackAnalysisContext& context, Int startOffset, Int endOffset, VISIT visit)
+	{
+		const std::vector<CodeLine>& codeLines = *context.p_codeLines;
+		auto lineIt = std::upper_bound(
+			codeLines.begin(), codeLines.end(), startOffset,
+			[](Int val, const CodeLine& codeLine) { return val < codeLine.offset; }
+		);
+
+		Int line = lineIt != codeLines.begin() ? std::prev(lineIt)->line : 0;
+
+		for (Int offset = startOffset; offset < endOffset;)
+		{
+			bool isLineStart = false;
+
+			for (; lineIt != codeLines.end() && lineIt->offset <= offset; lineIt++)
+			{
+				line = lineIt->line;
+				isLineStart = true;
+			}
+
+			if (line == DATA_CODE_LINE)
+			{
+				visit(offset, OpCode::INVALID, isLineStart);
+				offset += sizeof(Ptr);
+				continue;
+			}
+
+			OpCode opCode = static_cast<OpCode>(context.p_stack[offset]);
+			Int size = 1 + GetImmediateSize(opCode);
+
+			if (offset + size > endOffset)
+				break;
+
+			visit(offset, opCode, isLineStart);
+			offset += size;
+		}
+	}
+
+	static bool IsAddressTaken(const std::vector<bool>& addressTaken, const StackAnalysisContext& context, size_t functionIndex, Int parametersSize)
+	{
+		return addressTaken[functionIndex] && context.functions[functionIndex].parametersSize == parametersSize;
+	}
+
+	static void ScanCode(
+		const StackAnalysisContext& context,
+		const std::map<Ptr, size_t>& entryToFunction,
+		const std::vector<bool>& addressTaken,
+		ScannedCode& inoutCode
+	)
+	{
+		Int depth = 0;
+		Int maxDepth = 0;
+		OpCode lastOpCode = OpCode::INVALID;
+		Ptr p_lastImmediate = nullptr;
+
+		ForEachInstruction(context, inoutCode.startOffset, inoutCode.endOffset, [&](Int offset, OpCode opCode, bool isLineStart)
+		{
+			if (opCode == OpCode::INVALID)
+				return;
+
+			// statements start and end on an empty operand stack, this also drops what an
+			// instruction of unknown effect left behind
+			if (isLineStart)
+				depth = 0;
+
+			Ptr p_immediate = context.p_stack + offset + sizeof(Char);
+
+			switch (opCode)
+			{
+			case OpCode::Load_Bytes_From:
+			case OpCode::Write_Bytes_To:
+			{
+				// the size is a constant pushed right before
+				Int size = lastOpCode == OpCode::Load_Const_Int ? Get<Int>(p_lastImmediate) : 0;
+				depth -= static_cast<Int>(sizeof(Int) + sizeof(Ptr));
+				depth += opCode == OpCode::Load_Bytes_From ? size : -size;
+				break;
+			}
+			case OpCode::Call:
+			{
+				StackCall call;
+				call.parametersSize = Get<Int>(p_immediate);
+				call.depth = depth - static_cast<Int>(sizeof(Ptr)) + Get<Int>(p_immediate + sizeof(Int)) + frameHeaderSize;
+				call.calleeIndex = noFunction;
+
+				if (lastOpCode == OpCode::Load_Const_Ptr)
+				{
+					auto it = entryToFunction.find(Get<Ptr>(p_lastImmediate));
+
+					if (it != entryToFunction.end())
+						call.calleeIndex = it->second;
+				}
+
+				Int returnValueSize = 0;
+
+				if (call.calleeIndex != noFunction)
+					returnValueSize = context.functions[call.calleeIndex].returnValueSize;
+
+				for (size_t i = 0; call.calleeIndex == noFunction && i < context.functions.size(); i++)
+				{
+					if (IsAddressTaken(addressTaken, context, i, call.parametersSize))
+						returnValueSize = std::max(returnValueSize, context.functions[i].returnValueSize);
+				}
+
+				inoutCode.calls.push_back(call);
+				depth += returnValueSize - call.parametersSize - static_cast<Int>(sizeof(Ptr));
+				break;
+			}
+			case OpCode::Write_IP:
+			{
+				depth -= sizeof(Ptr);
+
+				if (lastOpCode == OpCode::Load_Const_Ptr)
+					break;
+
+				// a jump through a pointer is a virtual dispatch, the callee runs in this frame
+				StackCall call;
+				call.depth = depth;
+				call.calleeIndex = noFunction;
+				call.parametersSize = inoutCode.parametersSize;
+				inoutCode.calls.push_back(call);
+				break;
+			}
+			case OpCode::Return:
+				depth -= Get<Int>(p_immediate);
+				break;
+			case OpCode::Call_Native:
+			{
+				depth -= sizeof(Ptr);
+
+				if (lastOpCode != OpCode::Load_Const_Ptr)
+					break;
+
+				auto hashIt = context.p_offsetToNativeFunctionHash->find(static_cast<Int>(p_lastImmediate - context.p_stack));
+
+				if (hashIt == context.p_offsetToNativeFunctionHash->end())
+					break;
+
+				auto effectIt = context.nativeHashToStackEffect.find(hashIt->second);
+
+				if (effectIt != context.nativeHashToStackEffect.end())
+					depth += effectIt->second;
+				break;
+			}
+			default:
+				depth += GetStackEffect(opCode);
+				break;
+			}
+
+			depth = std::max(depth, 0);
+			maxDepth = std::max(maxDepth, depth);
+			lastOpCode = opCode;
+			p_lastImmediate = p_immediate;
+		});
+
+		inoutCode.operandDepth = maxDepth;
+	}
+
+	// deepest stack on top of the frame of the code, -1 if it can recurse
+	static Int GetWorstCaseDepth(
+		const StackAnalysisContext& context,
+		const std::vector<ScannedCode>& codes,
+		const std::vector<bool>& addressTaken,
+		size_t codeIndex,
+		std::vector<Int>& inoutDepths,
+		std::vector<bool>& inoutIsVisiting
+	)
+	{
+		if (inoutIsVisiting[codeIndex])
+			return -1;
+
+		if (inoutDepths[codeIndex] != unknownDepth)
+			return inoutDepths[codeIndex];
+
+		inoutIsVisiting[codeIndex] = true;
+		const ScannedCode& code = codes[codeIndex];
+		Int depth = code.operandDepth;
+
+		for (const StackCall& call : code.calls)
+		{
+			Int calleeDepth = 0;
+
+			for (size_t i = 0; i < context.functions.size() && calleeDepth >= 0; i++)
+			{
+				bool isCallee = call.calleeIndex != noFunction ?
+					i == call.calleeIndex :
+					IsAddressTaken(addressTaken, context, i, call.parametersSize);
+
+				if (isCallee)
+				{
+					Int val = GetWorstCaseDepth(context, codes, addressTaken, i, inoutDepths, inoutIsVisiting);
+					calleeDepth = val < 0 ? -1 : std::max(calleeDepth, val);
+				}
+			}
+
+			if (calleeDepth < 0)
+			{
+				depth = -1;
+				break;
+			}
+
+			depth = std::max(depth, call.depth + calleeDepth);
+		}
+
+		inoutIsVisiting[codeIndex] = false;
+		inoutDepths[codeIndex] = depth;
+
+		return depth;
+	}
+
+	void AnalyzeStackUse(const StackAnalysisContext& context, std::vector<FunctionStackUse>& outUses)
+	{
+		outUses.clear();
+
+		// old entries of swapped functions lead to their current code
+		std::map<std::string, size_t> hashToFunction;
+		std::map<Ptr, size_t> entryToFunction;
+
+		for (size_t i = 0; i < context.functions.size(); i++)
+			hashToFunction[context.functions[i].functionHash] = i;
+
+		for (const auto& e : context.functionEntries.entries)
+		{
+			auto it = hashToFunction.find(e.second);
+
+			if (it != hashToFunction.end())
+				entryToFunction[e.first] = it->second;
+		}
+
+		// the code of a function ends at the next entry, the program ends at the first
+		const auto& entries = context.functionEntries.entries;
+		std::vector<ScannedCode> codes(context.functions.size() + 1);
+
+		for (size_t i = 0; i < context.functions.size(); i++)
+		{
+			Ptr p_entryIp = context.functions[i].p_entryIp;
+			auto nextIt = std::upper_bound(
+				entries.begin(), entries.end(), p_entryIp,
+				[](Ptr p_val, const std::pair<Ptr, std::string>& entry) { return p_val < entry.first; }
+			);
+
+			codes[i].parametersSize = context.functions[i].parametersSize;
+			codes[i].startOffset = static_cast<Int>(p_entryIp - context.p_stack);
+			codes[i].endOffset = nextIt != entries.end() ? static_cast<Int>(nextIt->first - context.p_stack) : context.codeEnd;
+		}
+
+		ScannedCode& programCode = codes.back();
+		programCode.parametersSize = 0;
+		programCode.startOffset = context.codeStart;
+		programCode.endOffset = entries.empty() ? context.codeEnd : static_cast<Int>(entries.front().first - context.p_stack);
+
+		// functions can be called through a pointer once their address is loaded for anything
+		// but a direct call or stored in a v-table
+		std::vector<bool> addressTaken(context.functions.size(), false);
+
+		for (const ScannedCode& code : codes)
+		{
+			Ptr p_lastEntry = nullptr;
+
+			ForEachInstruction(context, code.startOffset, code.endOffset, [&](Int offset, OpCode opCode, bool)
+			{
+				if (p_lastEntry != nullptr && opCode != OpCode::Call)
+					addressTaken[entryToFunction.at(p_lastEntry)] = true;
+
+				p_lastEntry = nullptr;
+
+				if (opCode != OpCode::INVALID && opCode != OpCode::Load_Const_Ptr)
+					return;
+
+				Ptr p_val = Get<Ptr>(context.p_stack + offset + (opCode == OpCode::INVALID ? 0 : sizeof(Char)));
+
+				if (entryToFunction.count(p_val) == 0)
+					return;
+
+				if (opCode == OpCode::INVALID)
+					addressTaken[entryToFunction.at(p_val)] = true;
+				else
+					p_lastEntry = p_val;
+			});
+		}
+
+		for (ScannedCode& code : codes)
+			ScanCode(context, entryToFunction, addressTaken, code);
+
+		std::vector<Int> depths(codes.size(), unknownDepth);
+		std::vector<bool> isVisiting(codes.size(), false);
+
+		FunctionStackUse& programUse = outUses.emplace_back();
+		programUse.functionHash = "<program>";
+		programUse.operandDepth = programCode.operandDepth;
+		programUse.worstCaseSize = GetWorstCaseDepth(context, codes, addressTaken, codes.size() - 1, depths, isVisiting);
+
+		for (size_t i = 0; i < context.functions.size(); i++)
+		{
+			const StackFunction& function = context.functions[i];
+			FunctionStackUse& use = outUses.emplace_back();
+			use.functionHash = function.functionHash;
+			use.frameSize = function.parametersSize + function.localsSize + frameHeaderSize;
+			use.operandDepth = codes[i].operandDepth;
+
+			Int depth = GetWorstCaseDepth(context, codes, addressTaken, i, depths, isVisiting);
+			use.worstCaseSize = depth >= 0 ? use.frameSize + depth : -1;
+		}
+	}
+}
\ No newline at end of file
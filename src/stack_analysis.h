@@ -0,0 +1,53 @@
+#pragma once
+#include "common.h"
+#include "code_builder.h"
+#include "profiler.h"
+#include <string>
+#include <vector>
+#include <map>
+
+namespace Tolo
+{
+	// a script function as the stack analysis sees it
+	struct StackFunction
+	{
+		std::string functionHash;
+		Ptr p_entryIp;
+		Int parametersSize;
+		Int localsSize;
+		Int returnValueSize;
+
+		StackFunction();
+	};
+
+	// what the stack analysis reads the code with
+	struct StackAnalysisContext
+	{
+		Ptr p_stack;
+		Int codeStart;
+		Int codeEnd; // end of the built code
+		std::vector<StackFunction> functions;
+		FunctionEntries functionEntries; // old entries included, the code of a function ends at the next entry
+		const std::map<Int, std::string>* p_offsetToNativeFunctionHash;
+		std::map<std::string, Int> nativeHashToStackEffect; // size of the return value minus the parameters
+		const std::vector<CodeLine>* p_codeLines;
+
+		StackAnalysisContext();
+	};
+
+	// estimated stack use of a function, counted from its first parameter
+	struct FunctionStackUse
+	{
+		std::string functionHash;
+		Int frameSize; // parameters, locals and the saved registers
+		Int operandDepth; // most bytes of temporaries on top of the frame
+		Int worstCaseSize; // frame, temporaries and the deepest chain of calls, -1 if it can recurse
+
+		FunctionStackUse();
+	};
+
+	// the code in front of the functions comes first as '<program>', calls through a pointer may
+	// reach every function whose address is taken and that has the same parameters size, script
+	// functions called back from natives are not seen
+	void AnalyzeStackUse(const StackAnalysisContext& context, std::vector<FunctionStackUse>& outUses);
+}
\ No newline at end of file
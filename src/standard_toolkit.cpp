@@ -1,172 +1,155 @@
 #include "standard_toolkit.h"
 #include "file_io.h"
+#include "heap_profiler.h"
 #include <iostream>
 
 namespace Tolo
 {
+	static Ptr Malloc(Int size)
+	{
+		Affirm(size > 0, "failed to malloc, size was %i", size);
+
+		Ptr p_data = static_cast<Ptr>(std::malloc(static_cast<size_t>(size)));
+		Affirm(p_data != nullptr, "failed to malloc, size was %i", size);
+
+		return p_data;
+	}
+
+	static void Free(Ptr p_data)
+	{
+		std::free(p_data);
+	}
+
+	// bound as raw natives, the heap profiler reads the call site from the VM
+	static void MallocNative(VirtualMachine& vm)
+	{
+		Int size = Pop<Int>(vm);
+		Ptr p_data = Malloc(size);
+
+		if (vm.instruments.p_heapProfiler != nullptr)
+			vm.instruments.p_heapProfiler->Allocate(vm, p_data, size);
+
+		Push<Ptr>(vm, p_data);
+	}
+
+	static void FreeNative(VirtualMachine& vm)
+	{
+		Ptr p_data = Pop<Ptr>(vm);
+
+		if (vm.instruments.p_heapProfiler != nullptr)
+			vm.instruments.p_heapProfiler->Free(p_data);
+
+		Free(p_data);
+	}
+
+	static Int Strlen(Ptr p_str)
+	{
+		return static_cast<Int>(std::strlen(static_cast<const char*>(p_str)));
+	}
+
+	static void Memcpy(Ptr p_dst, Ptr p_src, Int size)
+	{
+		std::memcpy(p_dst, p_src, static_cast<size_t>(size));
+	}
+
+	static void Memset(Ptr p_data, Char val, Int count)
+	{
+		std::memset(p_data, val, static_cast<size_t>(count));
+	}
+
+	template<typename TO, typename FROM>
+	TO Cast(FROM val)
+	{
+		return static_cast<TO>(val);
+	}
+
+	static void PrintString(Ptr p_str)
+	{
+		std::cout << static_cast<const char*>(p_str);
+	}
+
 	template<typename T>
-	void Print(VirtualMachine& vm)
+	void Print(T val)
 	{
-		T val = Pop<T>(vm);
 		std::cout << val;
 	}
 
+	static void InputString(Ptr p_str, Int capacity)
+	{
+		std::string input;
+		std::getline(std::cin, input);
+
+		for (size_t i = 0; i < input.size() && i < static_cast<size_t>(capacity); i++)
+			p_str[i] = input[i];
+	}
+
 	template<typename T>
-	void Input(VirtualMachine& vm)
+	T Input()
 	{
 		T val = T();
 		std::cin >> val;
 
-		Push<T>(vm, val);
+		return val;
+	}
+
+	static void GetFileText(Ptr p_filepath, Ptr p_buffer, Int capacity)
+	{
+		std::string text;
+		ReadTextFile(static_cast<const char*>(p_filepath), text);
+
+		for (size_t i = 0; i < text.size() && i < static_cast<size_t>(capacity); i++)
+			p_buffer[i] = text[i];
+	}
+
+	static void SetFileText(Ptr p_filepath, Ptr p_str)
+	{
+		WriteTextFile(static_cast<const char*>(p_filepath), static_cast<const char*>(p_str), false);
+	}
+
+	static void AddFileText(Ptr p_filepath, Ptr p_str)
+	{
+		WriteTextFile(static_cast<const char*>(p_filepath), static_cast<const char*>(p_str), true);
+	}
+
+	static void Assert(Char test, Ptr p_str)
+	{
+		Affirm(test > 0, static_cast<const char*>(p_str));
 	}
 
 	void AddMemoryToolkit(ProgramHandle& program)
 	{
-		program.AddFunction("ptr", "malloc", {"int"}, [](VirtualMachine& vm)
-			{
-				Int size = Pop<Int>(vm);
-				Affirm(size > 0, "failed to malloc, size was %i", size);
-
-				Ptr p_data = static_cast<Ptr>(std::malloc(static_cast<size_t>(size)));
-				Affirm(p_data != nullptr, "failed to malloc, size was %i", size);
-
-				Push<Ptr>(vm, p_data);
-			}
-		);
-		program.AddFunction("void", "free", {"ptr"}, [](VirtualMachine& vm)
-			{
-				Ptr p_data = Pop<Ptr>(vm);
-				std::free(p_data);
-			}
-		);
-		program.AddFunction("int", "strlen", {"ptr"}, [](VirtualMachine& vm)
-			{
-				Ptr p_str = Pop<Ptr>(vm);
-				size_t len = std::strlen(static_cast<const char*>(p_str));
-				Push<Int>(vm, static_cast<Int>(len));
-			}
-		);
-		program.AddFunction("void", "memcpy", {"ptr", "ptr", "int"}, [](VirtualMachine& vm)
-			{
-				Ptr p_dst = Pop<Ptr>(vm);
-				Ptr p_src = Pop<Ptr>(vm);
-				Int size = Pop<Int>(vm);
-				std::memcpy(p_dst, p_src, static_cast<size_t>(size));
-			}
-		);
-		program.AddFunction("void", "memset", {"ptr", "char", "int"}, [](VirtualMachine& vm)
-			{
-				Ptr p_data = Pop<Ptr>(vm);
-				Char val = Pop<Char>(vm);
-				Int count = Pop<Int>(vm);
-				std::memset(p_data, val, static_cast<size_t>(count));
-			}
-		);
-		program.AddFunction("char", "cast", { "int" }, [](VirtualMachine& vm) 
-			{
-				Int val = Pop<Int>(vm);
-				Push<Char>(vm, static_cast<Char>(val));
-			}
-		);
-		program.AddFunction("char", "cast", { "float" }, [](VirtualMachine& vm)
-			{
-				Float val = Pop<Float>(vm);
-				Push<Char>(vm, static_cast<Char>(val));
-			}
-		);
-		program.AddFunction("int", "cast", { "char" }, [](VirtualMachine& vm)
-			{
-				Char val = Pop<Char>(vm);
-				Push<Int>(vm, static_cast<Int>(val));
-			}
-		);
-		program.AddFunction("int", "cast", { "float" }, [](VirtualMachine& vm)
-			{
-				Float val = Pop<Float>(vm);
-				Push<Int>(vm, static_cast<Int>(val));
-			}
-		);
-		program.AddFunction("float", "cast", { "char" }, [](VirtualMachine& vm)
-			{
-				Char val = Pop<Char>(vm);
-				Push<Float>(vm, static_cast<Float>(val));
-			}
-		);
-		program.AddFunction("float", "cast", { "int" }, [](VirtualMachine& vm)
-			{
-				Int val = Pop<Int>(vm);
-				Push<Float>(vm, static_cast<Float>(val));
-			}
-		);
+		program.AddFunction("ptr", "malloc", { "int" }, MallocNative);
+		program.AddFunction("void", "free", { "ptr" }, FreeNative);
+		program.AddFunction<Strlen>("strlen");
+		program.AddFunction<Memcpy>("memcpy");
+		program.AddFunction<Memset>("memset");
+		program.AddFunction<Cast<Char, Int>>("cast");
+		program.AddFunction<Cast<Char, Float>>("cast");
+		program.AddFunction<Cast<Int, Char>>("cast");
+		program.AddFunction<Cast<Int, Float>>("cast");
+		program.AddFunction<Cast<Float, Char>>("cast");
+		program.AddFunction<Cast<Float, Int>>("cast");
 	}
 
 	void AddIOToolkit(ProgramHandle& program)
 	{
-		program.AddFunction("void", "print", {"ptr"}, [](VirtualMachine& vm)
-			{
-				Ptr p_str = Pop<Ptr>(vm);
-				std::cout << static_cast<const char*>(p_str);
-			}
-		);
-		program.AddFunction("void", "print", {"char"}, Print<Char>);
-		program.AddFunction("void", "print", {"int"}, Print<Int>);
-		program.AddFunction("void", "print", {"float"}, Print<Float>);
-
-		program.AddFunction("void", "input", {"ptr", "int"}, [](VirtualMachine& vm)
-			{
-				Ptr p_str = Pop<Ptr>(vm);
-				size_t capacity = static_cast<size_t>(Pop<Int>(vm));
-
-				std::string input;
-				std::getline(std::cin, input);
-
-				for (size_t i = 0; i < input.size() && i < capacity; i++)
-					p_str[i] = input[i];
-			}
-		);
-		program.AddFunction("char", "input", {},  Input<Char>);
-		program.AddFunction("int", "input", {},  Input<Int>);
-		program.AddFunction("float", "input", {},  Input<Float>);
-
-		program.AddFunction("void", "get_file_txt", {"ptr", "ptr", "int"}, [](VirtualMachine& vm)
-			{
-				const char* p_filepath = static_cast<const char*>(Pop<Ptr>(vm));
-				Ptr p_buffer = Pop<Ptr>(vm);
-				size_t capacity = static_cast<size_t>(Pop<Int>(vm));
-
-				std::string text;
-				ReadTextFile(p_filepath, text);
-
-				for (size_t i = 0; i < text.size() && i < capacity; i++)
-					p_buffer[i] = text[i];
-			}
-		);
-		program.AddFunction("void", "set_file_txt", {"ptr", "ptr"}, [](VirtualMachine& vm)
-			{
-				const char* p_filepath = static_cast<const char*>(Pop<Ptr>(vm));
-				const char* p_str = static_cast<const char*>(Pop<Ptr>(vm));
-
-				WriteTextFile(p_filepath, p_str, false);
-			}
-		);
-		program.AddFunction("void", "add_file_txt", {"ptr", "ptr"}, [](VirtualMachine& vm)
-			{
-				const char* p_filepath = static_cast<const char*>(Pop<Ptr>(vm));
-				const char* p_str = static_cast<const char*>(Pop<Ptr>(vm));
-
-				WriteTextFile(p_filepath, p_str, true);
-			}
-		);
+		program.AddFunction<PrintString>("print");
+		program.AddFunction<Print<Char>>("print");
+		program.AddFunction<Print<Int>>("print");
+		program.AddFunction<Print<Float>>("print");
+
+		program.AddFunction<InputString>("input");
+		program.AddFunction<Input<Char>>("input");
+		program.AddFunction<Input<Int>>("input");
+		program.AddFunction<Input<Float>>("input");
+
+		program.AddFunction<GetFileText>("get_file_txt");
+		program.AddFunction<SetFileText>("set_file_txt");
+		program.AddFunction<AddFileText>("add_file_txt");
 	}
 
 	void AddAssertToolkit(ProgramHandle& program)
 	{
-		program.AddFunction("void", "assert", { "char", "ptr"}, [](VirtualMachine& vm)
-			{
-				Char test = Pop<Char>(vm);
-				const char* p_str = static_cast<const char*>(Pop<Ptr>(vm));
-				Affirm(test > 0, p_str);
-			}
-		);
+		program.AddFunction<Assert>("assert");
 	}
-}
\ No newline at end of file
+}
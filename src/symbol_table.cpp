@@ -0,0 +1,80 @@
+#include "symbol_table.h"
+
+namespace Tolo
+{
+	uint64_t HashSymbol(std::string_view name)
+	{
+		uint64_t hash = SYMBOL_HASH_SEED;
+
+		for (char c : name)
+			hash = HashSymbolChar(hash, c);
+
+		return hash;
+	}
+
+	SymbolTable::SymbolTable() :
+		slots(256, INVALID_SYMBOL)
+	{}
+
+	void SymbolTable::Grow()
+	{
+		slots.assign(slots.size() * 2, INVALID_SYMBOL);
+		size_t mask = slots.size() - 1;
+
+		for (size_t id = 0; id < names.size(); id++)
+		{
+			size_t slot = static_cast<size_t>(nameHashes[id]) & mask;
+
+			while (slots[slot] != INVALID_SYMBOL)
+				slot = (slot + 1) & mask;
+
+			slots[slot] = static_cast<SymbolId>(id);
+		}
+	}
+
+	SymbolId SymbolTable::Intern(std::string_view name)
+	{
+		return Intern(name, HashSymbol(name));
+	}
+
+	SymbolId SymbolTable::Intern(std::string_view name, uint64_t hash)
+	{
+		size_t mask = slots.size() - 1;
+		size_t slot = static_cast<size_t>(hash) & mask;
+
+		for (; slots[slot] != INVALID_SYMBOL; slot = (slot + 1) & mask)
+		{
+			SymbolId id = slots[slot];
+
+			if (nameHashes[id] == hash && names[id] == name)
+				return id;
+		}
+
+		SymbolId id = static_cast<SymbolId>(names.size());
+		names.emplace_back(name);
+		nameHashes.push_back(hash);
+		slots[slot] = id;
+
+		// kept at most half full so probes stay short
+		if (names.size() * 2 > slots.size())
+			Grow();
+
+		return id;
+	}
+
+	const std::string& SymbolTable::GetName(SymbolId id) const
+	{
+		Affirm(
+			id >= 0 && id < static_cast<SymbolId>(names.size()),
+			"invalid symbol id %i",
+			id
+		);
+
+		return names[id];
+	}
+
+	size_t SymbolTable::GetSize() const
+	{
+		return names.size();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include "common.h"
+#include <string>
+#include <string_view>
+#include <deque>
+#include <vector>
+#include <cstdint>
+
+namespace Tolo
+{
+	typedef Int SymbolId;
+
+	constexpr SymbolId INVALID_SYMBOL = -1;
+
+	// FNV-1a, fed one char at a time so the tokenizer can hash names while it scans them
+	constexpr uint64_t SYMBOL_HASH_SEED = 14695981039346656037ull;
+
+	inline uint64_t HashSymbolChar(uint64_t hash, char c)
+	{
+		return (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+	}
+
+	uint64_t HashSymbol(std::string_view name);
+
+	// interns names to dense integer ids, shared by the tokenizer and the parser of one compilation
+	class SymbolTable
+	{
+	private:
+		std::deque<std::string> names;
+		std::vector<uint64_t> nameHashes; // by id
+		std::vector<SymbolId> slots; // open addressing by hash, INVALID_SYMBOL if empty
+
+		void Grow();
+
+	public:
+		SymbolTable();
+
+		// the copy keeps the ids of all names interned so far
+		SymbolTable(const SymbolTable& rhs) = default;
+
+		SymbolTable& operator=(const SymbolTable& rhs) = delete;
+
+		SymbolId Intern(std::string_view name);
+
+		// hash has to be HashSymbol of name
+		SymbolId Intern(std::string_view name, uint64_t hash);
+
+		const std::string& GetName(SymbolId id) const;
+
+		size_t GetSize() const;
+	};
+}
\ No newline at end of file
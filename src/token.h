@@ -1,5 +1,6 @@
 #pragma once
-#include <string>
+#include "symbol_table.h"
+#include <string_view>
 
 namespace Tolo
 {
@@ -44,7 +45,8 @@ namespace Tolo
 		};
 
 		Type type;
-		std::string text;
+		std::string_view text; // view into the tokenized code, literals keep their escapes
 		int line;
+		SymbolId symbol; // interned text of names
 	};
 }
\ No newline at end of file
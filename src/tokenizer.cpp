@@ -1,12 +1,54 @@
 #include "tokenizer.h"
 #include "common.h"
-#include <map>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
 
 namespace Tolo
 {
-	void Tokenize(const std::string& code, std::vector<Token>& tokens)
+	enum class CharClass : unsigned char
 	{
-		static std::map<char, Token::Type> singleToType
+		Other, // starts a name, like letters
+		Space,
+		Newline,
+		Letter,
+		Digit,
+		Symbol,
+		Quote,
+		DoubleQuote
+	};
+
+	struct CharTable
+	{
+		CharClass classes[256];
+		Token::Type symbolTypes[256];
+
+		CharTable();
+	};
+
+	CharTable::CharTable()
+	{
+		for (int i = 0; i < 256; i++)
+		{
+			classes[i] = CharClass::Other;
+			symbolTypes[i] = Token::Type::Name;
+		}
+
+		for (int c = 'a'; c <= 'z'; c++)
+			classes[c] = CharClass::Letter;
+		for (int c = 'A'; c <= 'Z'; c++)
+			classes[c] = CharClass::Letter;
+		for (int c = '0'; c <= '9'; c++)
+			classes[c] = CharClass::Digit;
+
+		classes['_'] = CharClass::Letter;
+		classes[' '] = CharClass::Space;
+		classes['\t'] = CharClass::Space;
+		classes['\n'] = CharClass::Newline;
+		classes['\''] = CharClass::Quote;
+		classes['"'] = CharClass::DoubleQuote;
+
+		std::pair<char, Token::Type> symbols[]
 		{
 			{'(', Token::Type::StartPar},
 			{')', Token::Type::EndPar},
@@ -30,194 +72,332 @@ namespace Tolo
 			{'|', Token::Type::VerticalBar}
 		};
 
-		static std::map<std::string, Token::Type> doubleToType
+		for (auto& symbol : symbols)
 		{
-			{"::", Token::Type::DoubleColon},
-			{"<=", Token::Type::LeftArrowEqualSign},
-			{">=", Token::Type::RightArrowEqualSign},
-			{"==", Token::Type::DoubleEqualSign},
-			{"!=", Token::Type::ExclamationMarkEqualSign},
-			{"<<", Token::Type::DoubleLeftArrow},
-			{">>", Token::Type::DoubleRightArrow},
-			{"&&", Token::Type::DoubleAmpersand},
-			{"||", Token::Type::DoubleVerticalBar}
-		};
+			classes[static_cast<unsigned char>(symbol.first)] = CharClass::Symbol;
+			symbolTypes[static_cast<unsigned char>(symbol.first)] = symbol.second;
+		}
+	}
 
-		int line = 1;
+	static const CharTable charTable;
 
-		for (size_t i = 0; i < code.size();)
-		{
-			char c = code[i];
-			std::string doubleStr;
-			doubleStr += c;
-			if (i + 1 < code.size())
-				doubleStr += code[i + 1];
+	static constexpr size_t TOKEN_RELEASE_BATCH_SIZE = 256;
 
-			if (c == ' ' || c == '\n' || c == '\t')
-			{
-				if (c == '\n')
-					line++;
+	static CharClass ClassOf(char c)
+	{
+		return charTable.classes[static_cast<unsigned char>(c)];
+	}
 
-				i++;
+	static bool TryGetDoubleSymbolType(char c, char next, Token::Type& outType)
+	{
+		if (next == c)
+		{
+			switch (c)
+			{
+			case ':': outType = Token::Type::DoubleColon; return true;
+			case '=': outType = Token::Type::DoubleEqualSign; return true;
+			case '<': outType = Token::Type::DoubleLeftArrow; return true;
+			case '>': outType = Token::Type::DoubleRightArrow; return true;
+			case '&': outType = Token::Type::DoubleAmpersand; return true;
+			case '|': outType = Token::Type::DoubleVerticalBar; return true;
 			}
-			else if (doubleStr == "//")
+		}
+		else if (next == '=')
+		{
+			switch (c)
 			{
-				i += 2;
-				for (; i < code.size() && code[i] != '\n'; i++);
-				if (code[i] == '\n')
-					line++;
-
-				i++;
+			case '<': outType = Token::Type::LeftArrowEqualSign; return true;
+			case '>': outType = Token::Type::RightArrowEqualSign; return true;
+			case '!': outType = Token::Type::ExclamationMarkEqualSign; return true;
 			}
-			else if (doubleStr == "/*")
+		}
+
+		return false;
+	}
+
+	static bool TryDecodeEscape(char ec, char& outChar)
+	{
+		switch (ec)
+		{
+		case '\'': outChar = '\''; return true;
+		case '\\': outChar = '\\'; return true;
+		case 'n': outChar = '\n'; return true;
+		case 't': outChar = '\t'; return true;
+		case '0': outChar = '\0'; return true;
+		}
+
+		return false;
+	}
+
+	static void AffirmEscape(char ec, int line)
+	{
+		char decoded;
+		Affirm(TryDecodeEscape(ec, decoded), "invalid escape character '%c' at line %i", ec, line);
+	}
+
+	// scans from inoutPosition past the next token, false if only spaces and comments are left
+	static bool ScanToken(
+		const char* p_code, 
+		size_t size, 
+		SymbolTable& symbols, 
+		size_t& inoutPosition, 
+		int& inoutLine, 
+		Token& outToken
+	)
+	{
+		size_t& i = inoutPosition;
+		int& line = inoutLine;
+
+		while (i < size)
+		{
+			char c = p_code[i];
+			char next = i + 1 < size ? p_code[i + 1] : '\0';
+			size_t start = i;
+			Token::Type doubleType;
+
+			switch (ClassOf(c))
 			{
-				i += 2;
-				for (; i + 1 < code.size() && !(code[i] == '*' && code[i + 1] == '/'); i++)
+			case CharClass::Space:
+				i++;
+				break;
+
+			case CharClass::Newline:
+				line++;
+				i++;
+				break;
+
+			case CharClass::Symbol:
+				if (c == '/' && next == '/')
 				{
-					if (code[i] == '\n')
+					for (i += 2; i < size && p_code[i] != '\n'; i++);
+
+					if (i < size)
 						line++;
+
+					i++;
 				}
+				else if (c == '/' && next == '*')
+				{
+					for (i += 2; i + 1 < size && !(p_code[i] == '*' && p_code[i + 1] == '/'); i++)
+					{
+						if (p_code[i] == '\n')
+							line++;
+					}
 
-				Affirm(
-					i + 1 < code.size() && code[i] == '*' && code[i + 1] == '/',
-					"missing '*/' at line %i", 
-					line
-				);
+					Affirm(
+						i + 1 < size,
+						"missing '*/' at line %i", 
+						line
+					);
 
-				i += 2;
-			}
-			else if (doubleToType.count(doubleStr) != 0)
-			{
-				tokens.push_back({ doubleToType[doubleStr], doubleStr, line });
-				i += 2;
-			}
-			else if (singleToType.count(c) != 0)
-			{
-				std::string charStr;
-				charStr += c;
-				tokens.push_back({ singleToType[c], charStr, line });
-				i++;
-			}
-			else if (c == '\'')
-			{
-				Affirm(i + 2 < code.size(), "unexpected token ['] at line %i", line);
+					i += 2;
+				}
+				else if (TryGetDoubleSymbolType(c, next, doubleType))
+				{
+					outToken = { doubleType, std::string_view(p_code + i, 2), line, INVALID_SYMBOL };
+					i += 2;
+					return true;
+				}
+				else
+				{
+					outToken = { charTable.symbolTypes[static_cast<unsigned char>(c)], std::string_view(p_code + i, 1), line, INVALID_SYMBOL };
+					i++;
+					return true;
+				}
+				break;
 
-				std::string charStr;
+			case CharClass::Quote:
+				Affirm(i + 2 < size, "unexpected token ['] at line %i", line);
 
-				// check for escape character
-				if (i + 3 < code.size() && code[i + 3] == '\'' && code[i + 1] == '\\')
+				// the token keeps the escape, it is decoded by DecodeTokenText
+				if (i + 3 < size && p_code[i + 3] == '\'' && next == '\\')
 				{
-					char ec = code[i + 2];
-					if (ec == '\'')
-						charStr += '\'';
-					else if (ec == '\\')
-						charStr += '\\';
-					else if (ec == 'n')
-						charStr += '\n';
-					else if (ec == 't')
-						charStr += '\t';
-					else if (ec == '0')
-						charStr += '\0';
-					else
-						Affirm(false, "invalid escape character '%c' at line %i", ec, line);
-
+					AffirmEscape(p_code[i + 2], line);
+					outToken = { Token::Type::ConstChar, std::string_view(p_code + i + 1, 2), line, INVALID_SYMBOL };
 					i += 4;
+					return true;
 				}
 				else
 				{
-					Affirm(i + 2 < code.size() && code[i + 2] == '\'', "missing ['] at line %i", line);
-					charStr += code[i + 1];
+					Affirm(p_code[i + 2] == '\'', "missing ['] at line %i", line);
+					outToken = { Token::Type::ConstChar, std::string_view(p_code + i + 1, 1), line, INVALID_SYMBOL };
 					i += 3;
+					return true;
 				}
-				tokens.push_back({ Token::Type::ConstChar, charStr, line });
-			}
-			else if (c == '"')
+
+			case CharClass::DoubleQuote:
 			{
-				std::string str;
-				i++;
 				bool foundEndQuote = false;
 
-				for (; i < code.size(); i++)
+				for (i++; i < size; i++)
 				{
-					c = code[i];
+					c = p_code[i];
 					Affirm(c != '\n', "unexpected newline at line %i", line);
 
 					if (c == '"')
 					{
 						foundEndQuote = true;
-						i++;
 						break;
 					}
 					else if (c == '\\')
 					{
-						Affirm(i + 1 < code.size(), "unexpected end of tokens at line %i", line);
-
-						char ec = code[i + 1];
-						if (ec == '\'')
-							str += '\'';
-						else if (ec == '\\')
-							str += '\\';
-						else if (ec == 'n')
-							str += '\n';
-						else if (ec == 't')
-							str += '\t';
-						else if (ec == '0')
-							str += '\0';
-						else
-							Affirm(false, "invalid escape character '%c' at line %i", ec, line);
-
+						Affirm(i + 1 < size, "unexpected end of tokens at line %i", line);
+						AffirmEscape(p_code[i + 1], line);
 						i++;
 					}
-					else
-						str += c;
 				}
 
 				Affirm(foundEndQuote, "missing '\"' at line %i", line);
 
-				tokens.push_back({ Token::Type::ConstString, str, line });
-			}
-			else if (c >= '0' && c <= '9')
-			{
-				std::string numStr;
-				numStr += c;
+				outToken = { Token::Type::ConstString, std::string_view(p_code + start + 1, i - start - 1), line, INVALID_SYMBOL };
 				i++;
+				return true;
+			}
 
+			case CharClass::Digit:
+			{
 				bool hasDot = false;
 
-				for (; i < code.size(); i++)
+				for (i++; i < size; i++)
 				{
-					c = code[i];
+					c = p_code[i];
+
 					if (c == '.')
 					{
 						Affirm(!hasDot, "unexpected [.] at line %i", line);
 						hasDot = true;
-						numStr += c;
 					}
-					else if (c < '0' || c > '9')
+					else if (ClassOf(c) != CharClass::Digit)
 						break;
-					else
-						numStr += c;
 				}
 
-				tokens.push_back({ hasDot ? Token::Type::ConstFloat : Token::Type::ConstInt, numStr, line });
+				outToken = { hasDot ? Token::Type::ConstFloat : Token::Type::ConstInt, std::string_view(p_code + start, i - start), line, INVALID_SYMBOL };
+				return true;
 			}
-			else
+
+			default:
 			{
-				std::string name;
-				name += c;
-				i++;
+				// hashed while scanning, so interning does not read the name again
+				uint64_t hash = HashSymbolChar(SYMBOL_HASH_SEED, c);
 
-				for (; i < code.size(); i++)
+				for (i++; i < size; i++)
 				{
-					c = code[i];
-					if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_')
-						name += c;
-					else
+					CharClass charClass = ClassOf(p_code[i]);
+					if (charClass != CharClass::Letter && charClass != CharClass::Digit)
 						break;
+
+					hash = HashSymbolChar(hash, p_code[i]);
 				}
 
-				tokens.push_back({ Token::Type::Name, name, line });
+				std::string_view name(p_code + start, i - start);
+				outToken = { Token::Type::Name, name, line, symbols.Intern(name, hash) };
+				return true;
 			}
+			}
+		}
+
+		return false;
+	}
+
+	TokenStream::TokenStream(const std::string& code, SymbolTable& _symbols, int firstLine) :
+		p_code(code.data()),
+		size(code.size()),
+		p_symbols(&_symbols),
+		position(0),
+		line(firstLine),
+		tokenIndex(0),
+		peakBufferedTokenCount(0),
+		readTokenCount(0)
+	{}
+
+	bool TokenStream::ReadToken()
+	{
+		Token token;
+
+		if (!ScanToken(p_code, size, *p_symbols, position, line, token))
+			return false;
+
+		tokens.push_back(token);
+		peakBufferedTokenCount = std::max(peakBufferedTokenCount, tokens.size());
+		readTokenCount++;
+
+		return true;
+	}
+
+	const Token* TokenStream::Peek(size_t offset)
+	{
+		while (tokenIndex + offset >= tokens.size())
+		{
+			if (!ReadToken())
+				return nullptr;
+		}
+
+		return &tokens[tokenIndex + offset];
+	}
+
+	void TokenStream::Advance(size_t count)
+	{
+		tokenIndex += count;
+	}
+
+	void TokenStream::ReleaseConsumedTokens()
+	{
+		// erasing from the front of the deque is only worth it for a batch of tokens
+		if (tokenIndex < TOKEN_RELEASE_BATCH_SIZE)
+			return;
+
+		size_t releaseCount = std::min(tokenIndex, tokens.size());
+		tokens.erase(tokens.begin(), tokens.begin() + static_cast<std::ptrdiff_t>(releaseCount));
+		tokenIndex -= releaseCount;
+	}
+
+	size_t TokenStream::GetPeakBufferedTokenCount() const
+	{
+		return peakBufferedTokenCount;
+	}
+
+	size_t TokenStream::GetReadTokenCount() const
+	{
+		return readTokenCount;
+	}
+
+	void Tokenize(const std::string& code, SymbolTable& symbols, std::vector<Token>& tokens, int firstLine)
+	{
+		// rough guess to avoid most reallocations
+		tokens.reserve(tokens.size() + code.size() / 4);
+
+		size_t position = 0;
+		int line = firstLine;
+
+		// scans straight into the vector, the slot left after the last token is dropped
+		while (ScanToken(code.data(), code.size(), symbols, position, line, tokens.emplace_back()));
+
+		tokens.pop_back();
+	}
+
+	void DecodeTokenText(const Token& token, std::string& outText)
+	{
+		outText.clear();
+
+		if (token.type != Token::Type::ConstChar && token.type != Token::Type::ConstString)
+		{
+			outText = token.text;
+			return;
+		}
+
+		outText.reserve(token.text.size());
+
+		for (size_t i = 0; i < token.text.size(); i++)
+		{
+			char c = token.text[i];
+
+			if (c == '\\' && i + 1 < token.text.size())
+			{
+				TryDecodeEscape(token.text[i + 1], c);
+				i++;
+			}
+
+			outText += c;
 		}
 	}
 }
\ No newline at end of file
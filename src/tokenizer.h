@@ -1,8 +1,54 @@
 #pragma once
 #include "token.h"
+#include <string>
 #include <vector>
+#include <deque>
 
 namespace Tolo
 {
-	void Tokenize(const std::string& code, std::vector<Token>& tokens);
+	// tokenizes code on demand, tokens stay valid until they are released, so only the tokens 
+	// between two releases are held at once
+	class TokenStream
+	{
+	private:
+		const char* p_code;
+		size_t size;
+		SymbolTable* p_symbols;
+		size_t position;
+		int line;
+		std::deque<Token> tokens;
+		size_t tokenIndex; // current token in tokens
+		size_t peakBufferedTokenCount;
+		size_t readTokenCount;
+
+		// tokenizes up to the next token, false at the end of the code
+		bool ReadToken();
+
+	public:
+		// tokens view into code, which has to outlive them, names are interned into symbols
+		TokenStream(const std::string& code, SymbolTable& _symbols, int firstLine = 1);
+
+		TokenStream(const TokenStream&) = delete;
+
+		TokenStream& operator=(const TokenStream&) = delete;
+
+		// token offset tokens after the current one, nullptr behind the last token
+		const Token* Peek(size_t offset = 0);
+
+		void Advance(size_t count = 1);
+
+		// frees the tokens before the current one, once there are enough of them to free in a batch
+		void ReleaseConsumedTokens();
+
+		size_t GetPeakBufferedTokenCount() const;
+
+		// tokens read from the code so far
+		size_t GetReadTokenCount() const;
+	};
+
+	// tokens view into code, which has to outlive them, names are interned into symbols
+	void Tokenize(const std::string& code, SymbolTable& symbols, std::vector<Token>& tokens, int firstLine = 1);
+
+	// text of a token with the escapes of char and string literals decoded
+	void DecodeTokenText(const Token& token, std::string& outText);
 }
\ No newline at end of file
@@ -1,190 +1,339 @@
 #include "virtual_machine.h"
+#include "profiler.h"
+#include "execution_trace.h"
+#include "code_coverage.h"
 
 //#define DEBUG_VM
 
 namespace Tolo
 {
-	void RunProgram(Ptr p_stack, Int codeStart, Int codeEnd)
+	static void(*ops[])(VirtualMachine&)
 	{
-		static void(*ops[])(VirtualMachine&)
+		Op_Load_FP,
+		Op_Load_Bytes_From,
+		Op_Load_Const_T<Char>,
+		Op_Load_Const_T<Int>,
+		Op_Load_Const_T<Float>,
+		Op_Load_Const_T<Ptr>,
+
+		Op_Write_IP,
+		Op_Write_IP_If,
+		Op_Write_Bytes_To,
+
+		Op_Call,
+		Op_Return,
+		Op_Call_Native,
+
+		Op_T_Equal<Char>,
+		Op_T_Less<Char>,
+		Op_T_Greater<Char>,
+		Op_T_LessOrEqual<Char>,
+		Op_T_GreaterOrEqual<Char>,
+		Op_T_NotEqual<Char>,
+		Op_TU_Add<Char, Char>,
+		Op_TU_Sub<Char, Char>,
+		Op_T_Mul<Char>,
+		Op_T_Div<Char>,
+		Op_T_Negate<Char>,
+
+		Op_Not,
+		Op_And,
+		Op_Or,
+
+		Op_T_Equal<Int>,
+		Op_T_Less<Int>,
+		Op_T_Greater<Int>,
+		Op_T_LessOrEqual<Int>,
+		Op_T_GreaterOrEqual<Int>,
+		Op_T_NotEqual<Int>,
+		Op_TU_Add<Int, Int>,
+		Op_TU_Sub<Int, Int>,
+		Op_T_Mul<Int>,
+		Op_T_Div<Int>,
+		Op_T_Negate<Int>,
+
+		Op_T_Equal<Float>,
+		Op_T_Less<Float>,
+		Op_T_Greater<Float>,
+		Op_T_LessOrEqual<Float>,
+		Op_T_GreaterOrEqual<Float>,
+		Op_T_NotEqual<Float>,
+		Op_TU_Add<Float, Float>,
+		Op_TU_Sub<Float, Float>,
+		Op_T_Mul<Float>,
+		Op_T_Div<Float>,
+		Op_T_Negate<Float>,
+
+		Op_TU_Add<Ptr, Int>,
+		Op_TU_Sub<Ptr, Int>,
+		Op_Ptr_Offset,
+		Op_T_Less<Ptr>,
+		Op_T_Greater<Ptr>,
+		Op_T_Equal<Ptr>,
+		Op_T_LessOrEqual<Ptr>,
+		Op_T_GreaterOrEqual<Ptr>,
+		Op_T_NotEqual<Ptr>,
+			
+		Op_T_Bit_And<Char>,
+		Op_T_Bit_Or<Char>,
+		Op_T_Bit_Xor<Char>,
+		Op_T_Bit_LeftShift<Char>,
+		Op_T_Bit_RightShift<Char>,
+		Op_T_Bit_Invert<Char>,
+
+		Op_T_Bit_And<Int>,
+		Op_T_Bit_Or<Int>,
+		Op_T_Bit_Xor<Int>,
+		Op_T_Bit_LeftShift<Int>,
+		Op_T_Bit_RightShift<Int>,
+		Op_T_Bit_Invert<Int>
+	};
+
+	static const char* opNames[]
+	{
+		"Load_FP",
+		"Load_Bytes_From",
+		"Load_Const_Char",
+		"Load_Const_Int",
+		"Load_Const_Float",
+		"Load_Const_Ptr",
+
+		"Write_IP",
+		"Write_IP_If",
+		"Write_Bytes_To",
+
+		"Call",
+		"Return",
+		"Call_Native",
+
+		"Char_Equal",
+		"Char_Less",
+		"Char_Greater",
+		"Char_LessOrEqual",
+		"Char_GreaterOrEqual",
+		"Char_NotEqual",
+		"Char_Add",
+		"Char_Sub",
+		"Char_Mul",
+		"Char_Div",
+		"Char_Negate",
+
+		"Not",
+		"And",
+		"Or",
+
+		"Int_Equal",
+		"Int_Less",
+		"Int_Greater",
+		"Int_LessOrEqual",
+		"Int_GreaterOrEqual",
+		"Int_NotEqual",
+		"Int_Add",
+		"Int_Sub",
+		"Int_Mul",
+		"Int_Div",
+		"Int_Negate",
+
+		"Float_Equal",
+		"Float_Less",
+		"Float_Greater",
+		"Float_LessOrEqual",
+		"Float_GreaterOrEqual",
+		"Float_NotEqual",
+		"Float_Add",
+		"Float_Sub",
+		"Float_Mul",
+		"Float_Div",
+		"Float_Negate",
+
+		"Ptr_Add",
+		"Ptr_Sub",
+		"Ptr_Offset",
+		"Ptr_Less",
+		"Ptr_Greater",
+		"Ptr_Equal",
+		"Ptr_LessOrEqual",
+		"Ptr_GreaterOrEqual",
+		"Ptr_NotEqual",
+
+		"Bit_8_And",
+		"Bit_8_Or",
+		"Bit_8_Xor",
+		"Bit_8_LeftShift",
+		"Bit_8_RightShift",
+		"Bit_8_Invert",
+
+		"Bit_32_And",
+		"Bit_32_Or",
+		"Bit_32_Xor",
+		"Bit_32_LeftShift",
+		"Bit_32_RightShift",
+		"Bit_32_Invert"
+	};
+
+	const char* GetOpCodeName(OpCode opCode)
+	{
+		if (opCode < OpCode::Load_FP || opCode >= OpCode::INVALID)
+			return "INVALID";
+
+		return opNames[static_cast<size_t>(opCode)];
+	}
+
+	Int GetImmediateSize(OpCode opCode)
+	{
+		switch (opCode)
 		{
-			Op_Load_FP,
-			Op_Load_Bytes_From,
-			Op_Load_Const_T<Char>,
-			Op_Load_Const_T<Int>,
-			Op_Load_Const_T<Float>,
-			Op_Load_Const_T<Ptr>,
-
-			Op_Write_IP,
-			Op_Write_IP_If,
-			Op_Write_Bytes_To,
-
-			Op_Call,
-			Op_Return,
-			Op_Call_Native,
-
-			Op_T_Equal<Char>,
-			Op_T_Less<Char>,
-			Op_T_Greater<Char>,
-			Op_T_LessOrEqual<Char>,
-			Op_T_GreaterOrEqual<Char>,
-			Op_T_NotEqual<Char>,
-			Op_TU_Add<Char, Char>,
-			Op_TU_Sub<Char, Char>,
-			Op_T_Mul<Char>,
-			Op_T_Div<Char>,
-			Op_T_Negate<Char>,
-
-			Op_Not,
-			Op_And,
-			Op_Or,
-
-			Op_T_Equal<Int>,
-			Op_T_Less<Int>,
-			Op_T_Greater<Int>,
-			Op_T_LessOrEqual<Int>,
-			Op_T_GreaterOrEqual<Int>,
-			Op_T_NotEqual<Int>,
-			Op_TU_Add<Int, Int>,
-			Op_TU_Sub<Int, Int>,
-			Op_T_Mul<Int>,
-			Op_T_Div<Int>,
-			Op_T_Negate<Int>,
-
-			Op_T_Equal<Float>,
-			Op_T_Less<Float>,
-			Op_T_Greater<Float>,
-			Op_T_LessOrEqual<Float>,
-			Op_T_GreaterOrEqual<Float>,
-			Op_T_NotEqual<Float>,
-			Op_TU_Add<Float, Float>,
-			Op_TU_Sub<Float, Float>,
-			Op_T_Mul<Float>,
-			Op_T_Div<Float>,
-			Op_T_Negate<Float>,
-
-			Op_TU_Add<Ptr, Int>,
-			Op_TU_Sub<Ptr, Int>,
-			Op_T_Less<Ptr>,
-			Op_T_Greater<Ptr>,
-			Op_T_Equal<Ptr>,
-			Op_T_LessOrEqual<Ptr>,
-			Op_T_GreaterOrEqual<Ptr>,
-			Op_T_NotEqual<Ptr>,
-				
-			Op_T_Bit_And<Char>,
-			Op_T_Bit_Or<Char>,
-			Op_T_Bit_Xor<Char>,
-			Op_T_Bit_LeftShift<Char>,
-			Op_T_Bit_RightShift<Char>,
-			Op_T_Bit_Invert<Char>,
-
-			Op_T_Bit_And<Int>,
-			Op_T_Bit_Or<Int>,
-			Op_T_Bit_Xor<Int>,
-			Op_T_Bit_LeftShift<Int>,
-			Op_T_Bit_RightShift<Int>,
-			Op_T_Bit_Invert<Int>
-		};
+		case OpCode::Load_Const_Char: return sizeof(Char);
+		case OpCode::Load_Const_Int: return sizeof(Int);
+		case OpCode::Load_Const_Float: return sizeof(Float);
+		case OpCode::Load_Const_Ptr: return sizeof(Ptr);
+		case OpCode::Call: return sizeof(Int) + sizeof(Int);
+		case OpCode::Return: return sizeof(Int);
+		default: return 0;
+		}
+	}
 
-#ifdef DEBUG_VM
-		static const char* debugOpNames[]
+	// runs every attached instrument around each instruction
+	static void DispatchInstrumented(VirtualMachine& vm)
+	{
+		const VMInstruments& instruments = vm.instruments;
+
+		while (vm.p_instructionPtr < vm.p_codeEnd)
 		{
-			"Load_FP",
-			"Load_Bytes_From",
-			"Load_Const_Char",
-			"Load_Const_Int",
-			"Load_Const_Float",
-			"Load_Const_Ptr",
-
-			"Write_IP",
-			"Write_IP_If",
-			"Write_Bytes_To",
-
-			"Call",
-			"Return",
-			"Call_Native",
-
-			"Char_Equal",
-			"Char_Less",
-			"Char_Greater",
-			"Char_LessOrEqual",
-			"Char_GreaterOrEqual",
-			"Char_NotEqual",
-			"Char_Add",
-			"Char_Sub",
-			"Char_Mul",
-			"Char_Div",
-			"Char_Negate",
-
-			"Not",
-			"And",
-			"Or",
-
-			"Int_Equal",
-			"Int_Less",
-			"Int_Greater",
-			"Int_LessOrEqual",
-			"Int_GreaterOrEqual",
-			"Int_NotEqual",
-			"Int_Add",
-			"Int_Sub",
-			"Int_Mul",
-			"Int_Div",
-			"Int_Negate",
-
-			"Float_Equal",
-			"Float_Less",
-			"Float_Greater",
-			"Float_LessOrEqual",
-			"Float_GreaterOrEqual",
-			"Float_NotEqual",
-			"Float_Add",
-			"Float_Sub",
-			"Float_Mul",
-			"Float_Div",
-			"Float_Negate",
-
-			"Ptr_Add",
-			"Ptr_Sub",
-			"Ptr_Less",
-			"Ptr_Greater",
-			"Ptr_Equal",
-			"Ptr_LessOrEqual",
-			"Ptr_GreaterOrEqual",
-			"Ptr_NotEqual",
-
-			"Bit_8_And",
-			"Bit_8_Or",
-			"Bit_8_Xor",
-			"Bit_8_LeftShift",
-			"Bit_8_RightShift",
-			"Bit_8_Invert",
-
-			"Bit_32_And",
-			"Bit_32_Or",
-			"Bit_32_Xor",
-			"Bit_32_LeftShift",
-			"Bit_32_RightShift",
-			"Bit_32_Invert"
-		};
+			Ptr p_instructionPtr = vm.p_instructionPtr;
+			Ptr p_stackPtr = vm.p_stackPtr;
+			unsigned char opCode = static_cast<unsigned char>(*p_instructionPtr);
+
+#ifdef PROFILE_VM
+			if (instruments.p_profiler != nullptr)
+				instruments.p_profiler->CountInstruction(p_instructionPtr);
 #endif
 
-		VirtualMachine vm{
-			p_stack + codeEnd,
-			p_stack + codeStart,
-			p_stack + 0
-		};
+			if (instruments.p_counters != nullptr)
+				instruments.p_counters->Count(vm);
+
+			if (instruments.p_sampler != nullptr)
+				instruments.p_sampler->Tick(vm);
+
+			// counted before it runs, a native that fails still covered its call
+			if (instruments.p_coverage != nullptr)
+				instruments.p_coverage->Cover(p_instructionPtr);
+
+			uint64_t recordNumber = instruments.p_tracer != nullptr ? instruments.p_tracer->Begin(vm) : 0;
+
+			ops[opCode](vm);
 
-		const Ptr p_codeEnd = p_stack + codeEnd;
+			if (instruments.p_tracer != nullptr)
+				instruments.p_tracer->Finish(recordNumber, static_cast<Int>(vm.p_stackPtr - p_stackPtr));
 
-		while (vm.p_instructionPtr < p_codeEnd)
+			if (instruments.p_coverage != nullptr)
+				instruments.p_coverage->CoverJump(p_instructionPtr, vm.p_instructionPtr);
+
+#ifdef PROFILE_VM
+			if (instruments.p_profiler != nullptr)
+			{
+				if (opCode == static_cast<unsigned char>(OpCode::Call))
+					instruments.p_profiler->EnterFunction(vm.p_instructionPtr);
+				else if (opCode == static_cast<unsigned char>(OpCode::Return))
+					instruments.p_profiler->ReturnFromFunction();
+			}
+#endif
+		}
+	}
+
+	static void Dispatch(VirtualMachine& vm)
+	{
+		bool isInstrumented =
+			vm.instruments.p_counters != nullptr ||
+			vm.instruments.p_sampler != nullptr ||
+			vm.instruments.p_tracer != nullptr ||
+			vm.instruments.p_coverage != nullptr;
+
+#ifdef PROFILE_VM
+		isInstrumented = isInstrumented || vm.instruments.p_profiler != nullptr;
+#endif
+
+		if (isInstrumented)
+		{
+			DispatchInstrumented(vm);
+			return;
+		}
+
+		while (vm.p_instructionPtr < vm.p_codeEnd)
 		{
 			Char opCode = *vm.p_instructionPtr;
 #ifdef DEBUG_VM
-			std::printf("%s\n", debugOpNames[opCode]);
+			std::printf("%s\n", opNames[static_cast<unsigned char>(opCode)]);
 #endif
-			ops[opCode](vm);
+			ops[static_cast<unsigned char>(opCode)](vm);
 		}
 	}
+
+	VMInstruments::VMInstruments() :
+		p_profiler(nullptr),
+		p_sampler(nullptr),
+		p_counters(nullptr),
+		p_tracer(nullptr),
+		p_heapProfiler(nullptr),
+		p_coverage(nullptr)
+	{}
+
+	Ptr RunProgram(Ptr p_stack, Int codeStart, Int codeEnd, const VMInstruments& instruments)
+	{
+		VirtualMachine vm{
+			p_stack + codeEnd,
+			p_stack + codeStart,
+			p_stack + 0,
+			p_stack + codeEnd,
+			instruments,
+			p_stack + codeEnd
+		};
+
+		Dispatch(vm);
+
+		return vm.p_stackHighWater;
+	}
+
+	Ptr RunFunction(Ptr p_stack, Int codeEnd, Ptr p_functionIp, Int paramsSize, Int localsSize, const VMInstruments& instruments)
+	{
+		// arguments are already written at the end of the code
+		VirtualMachine vm{
+			p_stack + codeEnd + paramsSize,
+			p_stack + codeEnd,
+			p_stack + 0,
+			p_stack + codeEnd,
+			instruments,
+			p_stack + codeEnd
+		};
+
+		CallFunction(vm, p_functionIp, paramsSize, localsSize);
+
+		return vm.p_stackHighWater;
+	}
+
+	void CallFunction(VirtualMachine& vm, Ptr p_functionIp, Int paramsSize, Int localsSize)
+	{
+		Ptr p_callerIp = vm.p_instructionPtr;
+
+		// build the same frame as 'Call', but return to the end of the code so that the
+		// dispatch loop stops when this frame returns
+		vm.p_stackPtr += localsSize;
+		Push<Int>(vm, paramsSize + localsSize);
+		Push<Ptr>(vm, vm.p_codeEnd);
+		Push<Ptr>(vm, vm.p_framePtr);
+		vm.p_framePtr = vm.p_stackPtr;
+		vm.p_instructionPtr = p_functionIp;
+
+		if (vm.p_stackPtr > vm.p_stackHighWater)
+			vm.p_stackHighWater = vm.p_stackPtr;
+
+#ifdef PROFILE_VM
+		if (vm.instruments.p_profiler != nullptr)
+			vm.instruments.p_profiler->EnterFunction(p_functionIp);
+#endif
+
+		Dispatch(vm);
+
+		vm.p_instructionPtr = p_callerIp;
+	}
 }
\ No newline at end of file
@@ -25,11 +25,34 @@ namespace Tolo
 	*/
 
 
+	struct VMProfiler;
+	struct VMSampler;
+	struct ExecutionCounters;
+	struct VMTracer;
+	struct HeapProfiler;
+	struct CodeCoverage;
+
+	// tools a run reports to, nullptr when not attached
+	struct VMInstruments
+	{
+		VMProfiler* p_profiler; // only filled if PROFILE_VM is defined
+		VMSampler* p_sampler;
+		ExecutionCounters* p_counters;
+		VMTracer* p_tracer;
+		HeapProfiler* p_heapProfiler; // read by the memory toolkit natives
+		CodeCoverage* p_coverage;
+
+		VMInstruments();
+	};
+
 	struct VirtualMachine
 	{
 		Ptr p_stackPtr;
 		Ptr p_instructionPtr;
 		Ptr p_framePtr;
+		Ptr p_codeEnd;
+		VMInstruments instruments;
+		Ptr p_stackHighWater; // highest sp a call reached
 	};
 
 	typedef void(*native_func_t)(VirtualMachine&);
@@ -108,8 +131,12 @@ namespace Tolo
 
 	inline void Op_Write_IP_If(VirtualMachine& vm)
 	{
-		if (Pop<Char>(vm) > 0)
-			vm.p_instructionPtr = Pop<Ptr>(vm);
+		// the target is popped either way, or loops would grow the stack on every false branch
+		Char condition = Pop<Char>(vm);
+		Ptr p_target = Pop<Ptr>(vm);
+
+		if (condition > 0)
+			vm.p_instructionPtr = p_target;
 		else
 			vm.p_instructionPtr += sizeof(Char);
 	}
@@ -140,6 +167,10 @@ namespace Tolo
 		Push<Ptr>(vm, vm.p_framePtr);
 		vm.p_framePtr = vm.p_stackPtr;
 
+		// only sampled here, the temporaries of the innermost frame are left out
+		if (vm.p_stackPtr > vm.p_stackHighWater)
+			vm.p_stackHighWater = vm.p_stackPtr;
+
 		vm.p_instructionPtr = p_funcAddr;
 	}
 
@@ -241,6 +272,15 @@ namespace Tolo
 		vm.p_instructionPtr += sizeof(Char);
 	}
 
+	// member access pushes the offset on top of the address, unlike ptr arithmetic in scripts
+	inline void Op_Ptr_Offset(VirtualMachine& vm)
+	{
+		Int offset = Pop<Int>(vm);
+		Ptr p_address = Pop<Ptr>(vm);
+		Push<Ptr>(vm, p_address + offset);
+		vm.p_instructionPtr += sizeof(Char);
+	}
+
 	template<typename T, typename U>
 	void Op_TU_Add(VirtualMachine& vm)
 	{
@@ -338,5 +378,18 @@ namespace Tolo
 		vm.p_instructionPtr += sizeof(Char);
 	}
 
-	void RunProgram(Ptr p_stack, Int codeStart, Int codeEnd);
+	const char* GetOpCodeName(OpCode opCode);
+
+	// size of the immediate following an opcode
+	Int GetImmediateSize(OpCode opCode);
+
+	// both return the highest stack pointer reached by a call
+	Ptr RunProgram(Ptr p_stack, Int codeStart, Int codeEnd, const VMInstruments& instruments);
+
+	Ptr RunFunction(Ptr p_stack, Int codeEnd, Ptr p_functionIp, Int paramsSize, Int localsSize, const VMInstruments& instruments);
+
+	// runs a script function in a nested frame on top of the current stack, usable from inside
+	// native functions, the arguments must already be pushed with the first argument on top and
+	// the return value is left on top of the stack
+	void CallFunction(VirtualMachine& vm, Ptr p_functionIp, Int paramsSize, Int localsSize);
 }
\ No newline at end of file